@@ -16,6 +16,8 @@ Abstract:
 
 #include <PiDxe.h>
 
+#include <Library/PerformanceLib.h>
+
 #include "ArmGicDxe.h"
 
 /**
@@ -39,6 +41,8 @@ InterruptDxeInitialize (
   EFI_STATUS             Status;
   ARM_GIC_ARCH_REVISION  Revision;
 
+  PERF_INMODULE_BEGIN ("ArmGicInit");
+
   Revision = ArmGicGetSupportedArchRevision ();
 
   if (Revision == ARM_GIC_ARCH_REVISION_2) {
@@ -49,5 +53,7 @@ InterruptDxeInitialize (
     Status = EFI_UNSUPPORTED;
   }
 
+  PERF_INMODULE_END ("ArmGicInit");
+
   return Status;
 }
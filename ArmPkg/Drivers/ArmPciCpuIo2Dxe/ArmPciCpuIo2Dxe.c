@@ -13,13 +13,21 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/CpuIo2.h>
 
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/DxeServicesTableLib.h>
 #include <Library/IoLib.h>
 #include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
 #define MAX_IO_PORT_ADDRESS  0xFFFF
 
+//
+// Transfers smaller than this are always performed one access of the
+// requested width at a time, without looking up the memory type of the range.
+//
+#define MMIO_NORMAL_MEMORY_THRESHOLD  64
+
 //
 // Handle for the CPU I/O 2 Protocol
 //
@@ -177,6 +185,366 @@ CpuIoCheckParameter (
   return EFI_SUCCESS;
 }
 
+/**
+  Check whether a memory-mapped range is mapped as Normal memory.
+
+  Accesses to Normal memory may be merged, split or reordered, so transfers
+  to such a range, e.g., a framebuffer in a prefetchable BAR that the platform
+  mapped write-combining, can be performed with the widest accesses the CPU
+  supports rather than one access of the requested width at a time. Device
+  memory must be accessed exactly as requested.
+
+  The GCD memory space map can only be consulted at or below TPL_NOTIFY, so
+  ranges accessed at a higher TPL are treated as device memory.
+
+  @param[in] Address  The base address of the range.
+  @param[in] Length   The size of the range in bytes.
+
+  @retval TRUE   The whole range is mapped as Normal memory.
+  @retval FALSE  The range is, or may be, mapped as Device memory.
+
+**/
+STATIC
+BOOLEAN
+MmioRangeIsNormalMemory (
+  IN UINT64  Address,
+  IN UINT64  Length
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_TPL                          CurrentTpl;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR  Descriptor;
+
+  if (Length < MMIO_NORMAL_MEMORY_THRESHOLD) {
+    return FALSE;
+  }
+
+  CurrentTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  gBS->RestoreTPL (CurrentTpl);
+  if (CurrentTpl > TPL_NOTIFY) {
+    return FALSE;
+  }
+
+  Status = gDS->GetMemorySpaceDescriptor (Address, &Descriptor);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  if ((Address + Length - 1) > (Descriptor.BaseAddress + Descriptor.Length - 1)) {
+    return FALSE;
+  }
+
+  if ((Descriptor.Attributes & (EFI_MEMORY_UC | EFI_MEMORY_UCE)) != 0) {
+    return FALSE;
+  }
+
+  return (Descriptor.Attributes & (EFI_MEMORY_WC | EFI_MEMORY_WT | EFI_MEMORY_WB)) != 0;
+}
+
+/**
+  Read memory-mapped registers at increasing addresses into a buffer.
+
+  @param[in]  OperationWidth  The width of each access, EfiCpuIoWidthUint8 to
+                              EfiCpuIoWidthUint64.
+  @param[in]  Address         The base address of the transfer.
+  @param[in]  Count           The number of accesses to perform.
+  @param[out] Buffer          The destination buffer.
+
+**/
+STATIC
+VOID
+MmioReadPlain (
+  IN  EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth,
+  IN  UINTN                      Address,
+  IN  UINTN                      Count,
+  OUT VOID                       *Buffer
+  )
+{
+  UINTN  Index;
+
+  switch (OperationWidth) {
+    case EfiCpuIoWidthUint8:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT8 *)Buffer)[Index] = MmioRead8 (Address + Index);
+      }
+
+      break;
+    case EfiCpuIoWidthUint16:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT16 *)Buffer)[Index] = MmioRead16 (Address + Index * sizeof (UINT16));
+      }
+
+      break;
+    case EfiCpuIoWidthUint32:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT32 *)Buffer)[Index] = MmioRead32 (Address + Index * sizeof (UINT32));
+      }
+
+      break;
+    default:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT64 *)Buffer)[Index] = MmioRead64 (Address + Index * sizeof (UINT64));
+      }
+
+      break;
+  }
+}
+
+/**
+  Read a memory-mapped register repeatedly into a buffer.
+
+  @param[in]  OperationWidth  The width of each access, EfiCpuIoWidthUint8 to
+                              EfiCpuIoWidthUint64.
+  @param[in]  Address         The address of the register.
+  @param[in]  Count           The number of accesses to perform.
+  @param[out] Buffer          The destination buffer.
+
+**/
+STATIC
+VOID
+MmioReadFifo (
+  IN  EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth,
+  IN  UINTN                      Address,
+  IN  UINTN                      Count,
+  OUT VOID                       *Buffer
+  )
+{
+  UINTN  Index;
+
+  switch (OperationWidth) {
+    case EfiCpuIoWidthUint8:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT8 *)Buffer)[Index] = MmioRead8 (Address);
+      }
+
+      break;
+    case EfiCpuIoWidthUint16:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT16 *)Buffer)[Index] = MmioRead16 (Address);
+      }
+
+      break;
+    case EfiCpuIoWidthUint32:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT32 *)Buffer)[Index] = MmioRead32 (Address);
+      }
+
+      break;
+    default:
+      for (Index = 0; Index < Count; Index++) {
+        ((UINT64 *)Buffer)[Index] = MmioRead64 (Address);
+      }
+
+      break;
+  }
+}
+
+/**
+  Read memory-mapped registers at increasing addresses into the first element
+  of a buffer. Only the value of the last access is retained.
+
+  @param[in]  OperationWidth  The width of each access, EfiCpuIoWidthUint8 to
+                              EfiCpuIoWidthUint64.
+  @param[in]  Address         The base address of the transfer.
+  @param[in]  Count           The number of accesses to perform.
+  @param[out] Buffer          The destination buffer.
+
+**/
+STATIC
+VOID
+MmioReadFill (
+  IN  EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth,
+  IN  UINTN                      Address,
+  IN  UINTN                      Count,
+  OUT VOID                       *Buffer
+  )
+{
+  UINTN  Index;
+
+  switch (OperationWidth) {
+    case EfiCpuIoWidthUint8:
+      for (Index = 0; Index < Count; Index++) {
+        *(UINT8 *)Buffer = MmioRead8 (Address + Index);
+      }
+
+      break;
+    case EfiCpuIoWidthUint16:
+      for (Index = 0; Index < Count; Index++) {
+        *(UINT16 *)Buffer = MmioRead16 (Address + Index * sizeof (UINT16));
+      }
+
+      break;
+    case EfiCpuIoWidthUint32:
+      for (Index = 0; Index < Count; Index++) {
+        *(UINT32 *)Buffer = MmioRead32 (Address + Index * sizeof (UINT32));
+      }
+
+      break;
+    default:
+      for (Index = 0; Index < Count; Index++) {
+        *(UINT64 *)Buffer = MmioRead64 (Address + Index * sizeof (UINT64));
+      }
+
+      break;
+  }
+}
+
+/**
+  Write a buffer to memory-mapped registers at increasing addresses.
+
+  @param[in] OperationWidth  The width of each access, EfiCpuIoWidthUint8 to
+                             EfiCpuIoWidthUint64.
+  @param[in] Address         The base address of the transfer.
+  @param[in] Count           The number of accesses to perform.
+  @param[in] Buffer          The source buffer.
+
+**/
+STATIC
+VOID
+MmioWritePlain (
+  IN EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth,
+  IN UINTN                      Address,
+  IN UINTN                      Count,
+  IN VOID                       *Buffer
+  )
+{
+  UINTN  Index;
+
+  switch (OperationWidth) {
+    case EfiCpuIoWidthUint8:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite8 (Address + Index, ((UINT8 *)Buffer)[Index]);
+      }
+
+      break;
+    case EfiCpuIoWidthUint16:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite16 (Address + Index * sizeof (UINT16), ((UINT16 *)Buffer)[Index]);
+      }
+
+      break;
+    case EfiCpuIoWidthUint32:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite32 (Address + Index * sizeof (UINT32), ((UINT32 *)Buffer)[Index]);
+      }
+
+      break;
+    default:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite64 (Address + Index * sizeof (UINT64), ((UINT64 *)Buffer)[Index]);
+      }
+
+      break;
+  }
+}
+
+/**
+  Write a buffer to a memory-mapped register repeatedly.
+
+  @param[in] OperationWidth  The width of each access, EfiCpuIoWidthUint8 to
+                             EfiCpuIoWidthUint64.
+  @param[in] Address         The address of the register.
+  @param[in] Count           The number of accesses to perform.
+  @param[in] Buffer          The source buffer.
+
+**/
+STATIC
+VOID
+MmioWriteFifo (
+  IN EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth,
+  IN UINTN                      Address,
+  IN UINTN                      Count,
+  IN VOID                       *Buffer
+  )
+{
+  UINTN  Index;
+
+  switch (OperationWidth) {
+    case EfiCpuIoWidthUint8:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite8 (Address, ((UINT8 *)Buffer)[Index]);
+      }
+
+      break;
+    case EfiCpuIoWidthUint16:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite16 (Address, ((UINT16 *)Buffer)[Index]);
+      }
+
+      break;
+    case EfiCpuIoWidthUint32:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite32 (Address, ((UINT32 *)Buffer)[Index]);
+      }
+
+      break;
+    default:
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite64 (Address, ((UINT64 *)Buffer)[Index]);
+      }
+
+      break;
+  }
+}
+
+/**
+  Write the first element of a buffer to memory-mapped registers at
+  increasing addresses.
+
+  @param[in] OperationWidth  The width of each access, EfiCpuIoWidthUint8 to
+                             EfiCpuIoWidthUint64.
+  @param[in] Address         The base address of the transfer.
+  @param[in] Count           The number of accesses to perform.
+  @param[in] Buffer          The source buffer.
+
+**/
+STATIC
+VOID
+MmioWriteFill (
+  IN EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth,
+  IN UINTN                      Address,
+  IN UINTN                      Count,
+  IN VOID                       *Buffer
+  )
+{
+  UINTN   Index;
+  UINT8   Value8;
+  UINT16  Value16;
+  UINT32  Value32;
+  UINT64  Value64;
+
+  switch (OperationWidth) {
+    case EfiCpuIoWidthUint8:
+      Value8 = *(UINT8 *)Buffer;
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite8 (Address + Index, Value8);
+      }
+
+      break;
+    case EfiCpuIoWidthUint16:
+      Value16 = *(UINT16 *)Buffer;
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite16 (Address + Index * sizeof (UINT16), Value16);
+      }
+
+      break;
+    case EfiCpuIoWidthUint32:
+      Value32 = *(UINT32 *)Buffer;
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite32 (Address + Index * sizeof (UINT32), Value32);
+      }
+
+      break;
+    default:
+      Value64 = *(UINT64 *)Buffer;
+      for (Index = 0; Index < Count; Index++) {
+        MmioWrite64 (Address + Index * sizeof (UINT64), Value64);
+      }
+
+      break;
+  }
+}
+
 /**
   Reads memory-mapped registers.
 
@@ -228,10 +596,7 @@ CpuMemoryServiceRead (
   )
 {
   EFI_STATUS                 Status;
-  UINT8                      InStride;
-  UINT8                      OutStride;
   EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth;
-  UINT8                      *Uint8Buffer;
 
   Status = CpuIoCheckParameter (TRUE, Width, Address, Count, Buffer);
   if (EFI_ERROR (Status)) {
@@ -239,21 +604,19 @@ CpuMemoryServiceRead (
   }
 
   //
-  // Select loop based on the width of the transfer
+  // Select loop based on the type and width of the transfer
   //
-  InStride       = mInStride[Width];
-  OutStride      = mOutStride[Width];
   OperationWidth = (EFI_CPU_IO_PROTOCOL_WIDTH)(Width & 0x03);
-  for (Uint8Buffer = Buffer; Count > 0; Address += InStride, Uint8Buffer += OutStride, Count--) {
-    if (OperationWidth == EfiCpuIoWidthUint8) {
-      *Uint8Buffer = MmioRead8 ((UINTN)Address);
-    } else if (OperationWidth == EfiCpuIoWidthUint16) {
-      *((UINT16 *)Uint8Buffer) = MmioRead16 ((UINTN)Address);
-    } else if (OperationWidth == EfiCpuIoWidthUint32) {
-      *((UINT32 *)Uint8Buffer) = MmioRead32 ((UINTN)Address);
-    } else if (OperationWidth == EfiCpuIoWidthUint64) {
-      *((UINT64 *)Uint8Buffer) = MmioRead64 ((UINTN)Address);
+  if (Width <= EfiCpuIoWidthUint64) {
+    if (MmioRangeIsNormalMemory (Address, LShiftU64 (Count, OperationWidth))) {
+      CopyMem (Buffer, (VOID *)(UINTN)Address, Count << OperationWidth);
+    } else {
+      MmioReadPlain (OperationWidth, (UINTN)Address, Count, Buffer);
     }
+  } else if (Width <= EfiCpuIoWidthFifoUint64) {
+    MmioReadFifo (OperationWidth, (UINTN)Address, Count, Buffer);
+  } else {
+    MmioReadFill (OperationWidth, (UINTN)Address, Count, Buffer);
   }
 
   return EFI_SUCCESS;
@@ -310,10 +673,8 @@ CpuMemoryServiceWrite (
   )
 {
   EFI_STATUS                 Status;
-  UINT8                      InStride;
-  UINT8                      OutStride;
   EFI_CPU_IO_PROTOCOL_WIDTH  OperationWidth;
-  UINT8                      *Uint8Buffer;
+  UINTN                      Length;
 
   Status = CpuIoCheckParameter (TRUE, Width, Address, Count, Buffer);
   if (EFI_ERROR (Status)) {
@@ -321,21 +682,35 @@ CpuMemoryServiceWrite (
   }
 
   //
-  // Select loop based on the width of the transfer
+  // Select loop based on the type and width of the transfer
   //
-  InStride       = mInStride[Width];
-  OutStride      = mOutStride[Width];
   OperationWidth = (EFI_CPU_IO_PROTOCOL_WIDTH)(Width & 0x03);
-  for (Uint8Buffer = Buffer; Count > 0; Address += InStride, Uint8Buffer += OutStride, Count--) {
-    if (OperationWidth == EfiCpuIoWidthUint8) {
-      MmioWrite8 ((UINTN)Address, *Uint8Buffer);
-    } else if (OperationWidth == EfiCpuIoWidthUint16) {
-      MmioWrite16 ((UINTN)Address, *((UINT16 *)Uint8Buffer));
-    } else if (OperationWidth == EfiCpuIoWidthUint32) {
-      MmioWrite32 ((UINTN)Address, *((UINT32 *)Uint8Buffer));
-    } else if (OperationWidth == EfiCpuIoWidthUint64) {
-      MmioWrite64 ((UINTN)Address, *((UINT64 *)Uint8Buffer));
+  if (Width <= EfiCpuIoWidthUint64) {
+    if (MmioRangeIsNormalMemory (Address, LShiftU64 (Count, OperationWidth))) {
+      CopyMem ((VOID *)(UINTN)Address, Buffer, Count << OperationWidth);
+    } else {
+      MmioWritePlain (OperationWidth, (UINTN)Address, Count, Buffer);
     }
+  } else if (Width <= EfiCpuIoWidthFifoUint64) {
+    MmioWriteFifo (OperationWidth, (UINTN)Address, Count, Buffer);
+  } else if (MmioRangeIsNormalMemory (Address, LShiftU64 (Count, OperationWidth))) {
+    Length = Count << OperationWidth;
+    switch (OperationWidth) {
+      case EfiCpuIoWidthUint8:
+        SetMem ((VOID *)(UINTN)Address, Length, *(UINT8 *)Buffer);
+        break;
+      case EfiCpuIoWidthUint16:
+        SetMem16 ((VOID *)(UINTN)Address, Length, *(UINT16 *)Buffer);
+        break;
+      case EfiCpuIoWidthUint32:
+        SetMem32 ((VOID *)(UINTN)Address, Length, *(UINT32 *)Buffer);
+        break;
+      default:
+        SetMem64 ((VOID *)(UINTN)Address, Length, *(UINT64 *)Buffer);
+        break;
+    }
+  } else {
+    MmioWriteFill (OperationWidth, (UINTN)Address, Count, Buffer);
   }
 
   return EFI_SUCCESS;
@@ -0,0 +1,1334 @@
+/** @file
+  EFI_MP_SERVICES_PROTOCOL implementation that brings up the secondary cores
+  with PSCI CPU_ON, and lets DXE drivers run procedures on them.
+
+  The application processors share the page tables and the exception vectors
+  of the boot processor, and each runs on its own stack. They wait for work in
+  ApMain, and are powered off again with PSCI CPU_OFF at ExitBootServices so
+  that the OS can start them itself.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <IndustryStandard/ArmStdSmc.h>
+#include <Library/ArmHvcLib.h>
+#include <Library/ArmLib.h>
+#include <Library/ArmSmcLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include <Guid/ArmMpCoreInfo.h>
+#include <Guid/EventGroup.h>
+#include <Protocol/LoadedImage.h>
+
+#include "MpServicesInternal.h"
+
+STATIC_ASSERT (OFFSET_OF (AP_STARTUP_DATA, Mair) == 0, "AP_STARTUP_DATA.Mair offset mismatch");
+STATIC_ASSERT (OFFSET_OF (AP_STARTUP_DATA, Tcr) == 8, "AP_STARTUP_DATA.Tcr offset mismatch");
+STATIC_ASSERT (OFFSET_OF (AP_STARTUP_DATA, Ttbr0) == 16, "AP_STARTUP_DATA.Ttbr0 offset mismatch");
+STATIC_ASSERT (OFFSET_OF (AP_STARTUP_DATA, Sctlr) == 24, "AP_STARTUP_DATA.Sctlr offset mismatch");
+STATIC_ASSERT (OFFSET_OF (AP_STARTUP_DATA, Vbar) == 32, "AP_STARTUP_DATA.Vbar offset mismatch");
+STATIC_ASSERT (OFFSET_OF (AP_STARTUP_DATA, CpuCount) == 40, "AP_STARTUP_DATA.CpuCount offset mismatch");
+STATIC_ASSERT (OFFSET_OF (AP_STARTUP_DATA, Cpus) == 48, "AP_STARTUP_DATA.Cpus offset mismatch");
+STATIC_ASSERT (sizeof (AP_STARTUP_CPU) == 16, "AP_STARTUP_CPU size mismatch");
+
+//
+// Read by ApEntryPoint with the MMU off.
+//
+AP_STARTUP_DATA  mApStartupData;
+
+//
+// Processor number 0 is the boot processor.
+//
+STATIC CPU_AP_DATA      *mCpuData;
+STATIC UINTN            mCpuCount;
+STATIC ALL_APS_REQUEST  mAllApsRequest;
+STATIC EFI_EVENT        mPollEvent;
+STATIC BOOLEAN          mUseHvc;
+
+/**
+  Issue a PSCI call through the conduit the platform selected.
+
+  This function may be called from the application processors.
+
+  @param[in]  FunctionId    The PSCI function ID.
+  @param[in]  Arg1          The first argument.
+  @param[in]  Arg2          The second argument.
+  @param[in]  Arg3          The third argument.
+
+  @return The value returned by the PSCI implementation in x0.
+
+**/
+STATIC
+INTN
+PsciCall (
+  IN UINTN  FunctionId,
+  IN UINTN  Arg1,
+  IN UINTN  Arg2,
+  IN UINTN  Arg3
+  )
+{
+  ARM_HVC_ARGS  HvcArgs;
+  ARM_SMC_ARGS  SmcArgs;
+
+  if (mUseHvc) {
+    ZeroMem (&HvcArgs, sizeof (HvcArgs));
+    HvcArgs.Arg0 = FunctionId;
+    HvcArgs.Arg1 = Arg1;
+    HvcArgs.Arg2 = Arg2;
+    HvcArgs.Arg3 = Arg3;
+    ArmCallHvc (&HvcArgs);
+    return (INTN)HvcArgs.Arg0;
+  }
+
+  ZeroMem (&SmcArgs, sizeof (SmcArgs));
+  SmcArgs.Arg0 = FunctionId;
+  SmcArgs.Arg1 = Arg1;
+  SmcArgs.Arg2 = Arg2;
+  SmcArgs.Arg3 = Arg3;
+  ArmCallSmc (&SmcArgs);
+  return (INTN)SmcArgs.Arg0;
+}
+
+/**
+  Return the current time in nanoseconds.
+
+**/
+STATIC
+UINT64
+GetTimeInNs (
+  VOID
+  )
+{
+  return GetTimeInNanoSecond (GetPerformanceCounter ());
+}
+
+/**
+  Convert a timeout in microseconds into a deadline.
+
+  @param[in]  TimeoutInMicroseconds   The timeout, or 0 for none.
+
+  @return The deadline in nanoseconds, or 0 for none.
+
+**/
+STATIC
+UINT64
+GetDeadline (
+  IN UINTN  TimeoutInMicroseconds
+  )
+{
+  if (TimeoutInMicroseconds == 0) {
+    return 0;
+  }
+
+  return GetTimeInNs () + MultU64x32 (TimeoutInMicroseconds, 1000);
+}
+
+/**
+  Check whether a deadline returned by GetDeadline () has passed.
+
+**/
+STATIC
+BOOLEAN
+DeadlinePassed (
+  IN UINT64  Deadline
+  )
+{
+  return Deadline != 0 && GetTimeInNs () >= Deadline;
+}
+
+/**
+  Look up the processor number of the caller.
+
+  @param[out]  ProcessorNumber    The processor number.
+
+  @retval EFI_SUCCESS     The caller was found.
+  @retval EFI_NOT_FOUND   The caller is not a known processor.
+
+**/
+STATIC
+EFI_STATUS
+GetCurrentProcessorNumber (
+  OUT UINTN  *ProcessorNumber
+  )
+{
+  UINT64  Mpidr;
+  UINTN   Index;
+
+  Mpidr = ArmReadMpidr () & MPIDR_AFFINITY_MASK;
+  for (Index = 0; Index < mCpuCount; Index++) {
+    if (mCpuData[Index].Mpidr == Mpidr) {
+      *ProcessorNumber = Index;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Check whether the caller is the boot processor.
+
+**/
+STATIC
+BOOLEAN
+IsCurrentProcessorBsp (
+  VOID
+  )
+{
+  return (ArmReadMpidr () & MPIDR_AFFINITY_MASK) == mCpuData[0].Mpidr;
+}
+
+/**
+  Check whether an application processor can accept a new procedure.
+
+  The procedure of a processor that timed out is allowed to run to completion,
+  after which the processor is returned to the idle state here.
+
+  @param[in]  Index   The processor number.
+
+**/
+STATIC
+BOOLEAN
+IsApAvailable (
+  IN UINTN  Index
+  )
+{
+  CPU_AP_DATA  *Cpu;
+
+  Cpu = &mCpuData[Index];
+  if (Cpu->Owner != ApOwnerNone) {
+    return FALSE;
+  }
+
+  if (Cpu->State == CpuStateFinished) {
+    Cpu->State = CpuStateIdle;
+  }
+
+  return Cpu->State == CpuStateIdle;
+}
+
+/**
+  Post a procedure to an idle application processor and wake it up.
+
+  @param[in]  Index       The processor number.
+  @param[in]  Procedure   The procedure to run.
+  @param[in]  Argument    The argument of the procedure.
+
+**/
+STATIC
+VOID
+PostProcedure (
+  IN UINTN             Index,
+  IN EFI_AP_PROCEDURE  Procedure,
+  IN VOID              *Argument
+  )
+{
+  mCpuData[Index].Procedure = Procedure;
+  mCpuData[Index].Argument  = Argument;
+
+  //
+  // Publish the procedure before the state change that lets the processor
+  // pick it up.
+  //
+  ArmDataMemoryBarrier ();
+  mCpuData[Index].State = CpuStateReady;
+  ArmDataSynchronizationBarrier ();
+  ArmCallSEV ();
+}
+
+/**
+  Idle loop of the application processors. Runs the procedures posted by the
+  boot processor, and never returns.
+
+  @param[in]  CpuIndex    The processor number of the caller.
+
+**/
+VOID
+EFIAPI
+ApMain (
+  IN UINTN  CpuIndex
+  )
+{
+  CPU_AP_DATA  *Cpu;
+
+  Cpu        = &mCpuData[CpuIndex];
+  Cpu->State = CpuStateIdle;
+  ArmDataSynchronizationBarrier ();
+  ArmCallSEV ();
+
+  for ( ; ;) {
+    while (Cpu->State != CpuStateReady) {
+      ArmCallWFE ();
+    }
+
+    ArmDataMemoryBarrier ();
+    Cpu->State = CpuStateBusy;
+
+    Cpu->Procedure (Cpu->Argument);
+
+    ArmDataMemoryBarrier ();
+    Cpu->State = CpuStateFinished;
+    ArmDataSynchronizationBarrier ();
+    ArmCallSEV ();
+  }
+}
+
+/**
+  Procedure posted to the application processors at ExitBootServices.
+
+  @param[in]  Buffer    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+ApPowerOff (
+  IN OUT VOID  *Buffer
+  )
+{
+  PsciCall (ARM_SMC_ID_PSCI_CPU_OFF, 0, 0, 0);
+
+  //
+  // CPU_OFF does not return on success.
+  //
+  CpuDeadLoop ();
+}
+
+/**
+  Start the periodic timer that completes non-blocking requests.
+
+**/
+STATIC
+VOID
+StartPollTimer (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gBS->SetTimer (mPollEvent, TimerPeriodic, AP_POLL_INTERVAL);
+  ASSERT_EFI_ERROR (Status);
+}
+
+/**
+  Post the StartupAllAPs procedure to the next application processor of the
+  request that has not been dispatched yet.
+
+  @retval TRUE    A processor was dispatched.
+  @retval FALSE   All the processors of the request have been dispatched.
+
+**/
+STATIC
+BOOLEAN
+DispatchNextPendingAp (
+  VOID
+  )
+{
+  UINTN        Index;
+  CPU_AP_DATA  *Cpu;
+
+  for (Index = 1; Index < mCpuCount; Index++) {
+    Cpu = &mCpuData[Index];
+    if ((Cpu->Owner == ApOwnerAllAps) && Cpu->Pending) {
+      Cpu->Pending = FALSE;
+      PostProcedure (Index, mAllApsRequest.Procedure, mAllApsRequest.Argument);
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Collect the processors that completed the current StartupAllAPs request,
+  dispatch the next one in single threaded mode, and handle its timeout.
+
+  @retval EFI_SUCCESS     All the processors have completed the request.
+  @retval EFI_NOT_READY   The request is still in progress.
+  @retval EFI_TIMEOUT     The request timed out. The processors that did not
+                          complete it are returned in the failed CPU list of
+                          the request.
+
+**/
+STATIC
+EFI_STATUS
+CheckAllApsRequest (
+  VOID
+  )
+{
+  UINTN        Index;
+  UINTN        FailedCount;
+  UINTN        *FailedCpus;
+  BOOLEAN      Running;
+  CPU_AP_DATA  *Cpu;
+
+  Running     = FALSE;
+  FailedCount = 0;
+  for (Index = 1; Index < mCpuCount; Index++) {
+    Cpu = &mCpuData[Index];
+    if (Cpu->Owner != ApOwnerAllAps) {
+      continue;
+    }
+
+    if (Cpu->State == CpuStateFinished) {
+      Cpu->State = CpuStateIdle;
+      Cpu->Owner = ApOwnerNone;
+      continue;
+    }
+
+    if (!Cpu->Pending) {
+      Running = TRUE;
+    }
+
+    FailedCount++;
+  }
+
+  if (!Running && !DispatchNextPendingAp ()) {
+    mAllApsRequest.InProgress = FALSE;
+    return EFI_SUCCESS;
+  }
+
+  if (!DeadlinePassed (mAllApsRequest.Deadline)) {
+    return EFI_NOT_READY;
+  }
+
+  FailedCpus = NULL;
+  if (mAllApsRequest.FailedCpuList != NULL) {
+    FailedCpus = AllocatePool ((FailedCount + 1) * sizeof (UINTN));
+  }
+
+  FailedCount = 0;
+  for (Index = 1; Index < mCpuCount; Index++) {
+    Cpu = &mCpuData[Index];
+    if (Cpu->Owner != ApOwnerAllAps) {
+      continue;
+    }
+
+    Cpu->Owner   = ApOwnerNone;
+    Cpu->Pending = FALSE;
+    if (FailedCpus != NULL) {
+      FailedCpus[FailedCount++] = Index;
+    }
+  }
+
+  if (FailedCpus != NULL) {
+    FailedCpus[FailedCount]          = END_OF_CPU_LIST;
+    *mAllApsRequest.FailedCpuList = FailedCpus;
+  }
+
+  mAllApsRequest.InProgress = FALSE;
+  return EFI_TIMEOUT;
+}
+
+/**
+  Check whether the StartupThisAP request of an application processor has
+  completed or timed out.
+
+  @param[in]  Index   The processor number.
+
+  @retval EFI_SUCCESS     The procedure has returned.
+  @retval EFI_NOT_READY   The procedure is still running.
+  @retval EFI_TIMEOUT     The request timed out.
+
+**/
+STATIC
+EFI_STATUS
+CheckThisApRequest (
+  IN UINTN  Index
+  )
+{
+  CPU_AP_DATA  *Cpu;
+
+  Cpu = &mCpuData[Index];
+  if (Cpu->State == CpuStateFinished) {
+    Cpu->State = CpuStateIdle;
+    Cpu->Owner = ApOwnerNone;
+    if (Cpu->Finished != NULL) {
+      *Cpu->Finished = TRUE;
+    }
+
+    Cpu->WaitEvent = NULL;
+    return EFI_SUCCESS;
+  }
+
+  if (!DeadlinePassed (Cpu->Deadline)) {
+    return EFI_NOT_READY;
+  }
+
+  Cpu->Owner     = ApOwnerNone;
+  Cpu->WaitEvent = NULL;
+  return EFI_TIMEOUT;
+}
+
+/**
+  Periodic timer notification that completes the non-blocking requests, and
+  signals their wait events.
+
+  @param[in]  Event     The poll timer event.
+  @param[in]  Context   Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+CheckApsStatus (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINTN       Index;
+  BOOLEAN     Outstanding;
+  EFI_EVENT   WaitEvent;
+  EFI_STATUS  Status;
+
+  Outstanding = FALSE;
+
+  if (mAllApsRequest.InProgress && (mAllApsRequest.WaitEvent != NULL)) {
+    WaitEvent = mAllApsRequest.WaitEvent;
+    Status    = CheckAllApsRequest ();
+    if (Status == EFI_NOT_READY) {
+      Outstanding = TRUE;
+    } else {
+      gBS->SignalEvent (WaitEvent);
+    }
+  }
+
+  for (Index = 1; Index < mCpuCount; Index++) {
+    if ((mCpuData[Index].Owner != ApOwnerThisAp) ||
+        (mCpuData[Index].WaitEvent == NULL))
+    {
+      continue;
+    }
+
+    WaitEvent = mCpuData[Index].WaitEvent;
+    Status    = CheckThisApRequest (Index);
+    if (Status == EFI_NOT_READY) {
+      Outstanding = TRUE;
+    } else {
+      gBS->SignalEvent (WaitEvent);
+    }
+  }
+
+  if (!Outstanding) {
+    gBS->SetTimer (mPollEvent, TimerCancel, 0);
+  }
+}
+
+/**
+  This service retrieves the number of logical processor in the platform
+  and the number of those logical processors that are enabled on this boot.
+  This service may only be called from the BSP.
+
+  @param[in]  This                        A pointer to the
+                                          EFI_MP_SERVICES_PROTOCOL instance.
+  @param[out] NumberOfProcessors          Pointer to the total number of
+                                          logical processors in the system,
+                                          including the BSP and disabled APs.
+  @param[out] NumberOfEnabledProcessors   Pointer to the number of enabled
+                                          logical processors that exist in
+                                          system, including the BSP.
+
+  @retval EFI_SUCCESS             The number of logical processors and enabled
+                                  logical processors was retrieved.
+  @retval EFI_DEVICE_ERROR        The calling processor is an AP.
+  @retval EFI_INVALID_PARAMETER   NumberOfProcessors or
+                                  NumberOfEnabledProcessors is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+GetNumberOfProcessors (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  OUT UINTN                     *NumberOfProcessors,
+  OUT UINTN                     *NumberOfEnabledProcessors
+  )
+{
+  UINTN  Index;
+  UINTN  EnabledCount;
+
+  if ((NumberOfProcessors == NULL) || (NumberOfEnabledProcessors == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!IsCurrentProcessorBsp ()) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  EnabledCount = 0;
+  for (Index = 0; Index < mCpuCount; Index++) {
+    if ((mCpuData[Index].StatusFlag & PROCESSOR_ENABLED_BIT) != 0) {
+      EnabledCount++;
+    }
+  }
+
+  *NumberOfProcessors        = mCpuCount;
+  *NumberOfEnabledProcessors = EnabledCount;
+  return EFI_SUCCESS;
+}
+
+/**
+  Gets detailed MP-related information on the requested processor at the
+  instant this call is made. This service may only be called from the BSP.
+
+  @param[in]  This                  A pointer to the EFI_MP_SERVICES_PROTOCOL
+                                    instance.
+  @param[in]  ProcessorNumber       The handle number of processor. Bit 24 may
+                                    be set to request the extended topology.
+  @param[out] ProcessorInfoBuffer   A pointer to the buffer where information
+                                    for the requested processor is deposited.
+
+  @retval EFI_SUCCESS             Processor information was returned.
+  @retval EFI_DEVICE_ERROR        The calling processor is an AP.
+  @retval EFI_INVALID_PARAMETER   ProcessorInfoBuffer is NULL.
+  @retval EFI_NOT_FOUND           The processor with the handle specified by
+                                  ProcessorNumber does not exist in the
+                                  platform.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+GetProcessorInfo (
+  IN  EFI_MP_SERVICES_PROTOCOL   *This,
+  IN  UINTN                      ProcessorNumber,
+  OUT EFI_PROCESSOR_INFORMATION  *ProcessorInfoBuffer
+  )
+{
+  UINT64   Mpidr;
+  BOOLEAN  Extended;
+
+  if (ProcessorInfoBuffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!IsCurrentProcessorBsp ()) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Extended         = (ProcessorNumber & CPU_V2_EXTENDED_TOPOLOGY) != 0;
+  ProcessorNumber &= ~(UINTN)CPU_V2_EXTENDED_TOPOLOGY;
+  if (ProcessorNumber >= mCpuCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  Mpidr = mCpuData[ProcessorNumber].Mpidr;
+
+  ProcessorInfoBuffer->ProcessorId      = Mpidr;
+  ProcessorInfoBuffer->StatusFlag       = mCpuData[ProcessorNumber].StatusFlag;
+  ProcessorInfoBuffer->Location.Package = (UINT32)GET_MPIDR_AFF2 (Mpidr);
+  ProcessorInfoBuffer->Location.Core    = (UINT32)GET_MPIDR_AFF1 (Mpidr);
+  ProcessorInfoBuffer->Location.Thread  = (UINT32)GET_MPIDR_AFF0 (Mpidr);
+
+  if (Extended) {
+    ZeroMem (
+      &ProcessorInfoBuffer->ExtendedInformation,
+      sizeof (ProcessorInfoBuffer->ExtendedInformation)
+      );
+    ProcessorInfoBuffer->ExtendedInformation.Location2.Package = (UINT32)GET_MPIDR_AFF3 (Mpidr);
+    ProcessorInfoBuffer->ExtendedInformation.Location2.Die     = (UINT32)GET_MPIDR_AFF2 (Mpidr);
+    ProcessorInfoBuffer->ExtendedInformation.Location2.Core    = (UINT32)GET_MPIDR_AFF1 (Mpidr);
+    ProcessorInfoBuffer->ExtendedInformation.Location2.Thread  = (UINT32)GET_MPIDR_AFF0 (Mpidr);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  This service executes a caller provided function on all enabled APs.
+
+  APs can run either simultaneously or one at a time in sequence. This service
+  supports both blocking and non-blocking requests. This service may only be
+  called from the BSP.
+
+  @param[in]  This                    A pointer to the
+                                      EFI_MP_SERVICES_PROTOCOL instance.
+  @param[in]  Procedure               A pointer to the function to be run on
+                                      enabled APs of the system.
+  @param[in]  SingleThread            If TRUE, then all the enabled APs
+                                      execute the function specified by
+                                      Procedure one by one, in ascending order
+                                      of processor handle number. If FALSE,
+                                      then all the enabled APs execute the
+                                      function simultaneously.
+  @param[in]  WaitEvent               The event created by the caller with
+                                      CreateEvent () service. If NULL, the
+                                      request is blocking.
+  @param[in]  TimeoutInMicroSeconds   The time limit for all APs to complete
+                                      the request, or 0 for no limit.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure for
+                                      all APs.
+  @param[out] FailedCpuList           If not NULL, set to a list of the
+                                      processor numbers that did not complete
+                                      the request before it timed out. The
+                                      list is terminated by END_OF_CPU_LIST
+                                      and must be freed by the caller.
+
+  @retval EFI_SUCCESS             In blocking mode, all APs have finished
+                                  before the timeout expired. In non-blocking
+                                  mode, the function has been dispatched to
+                                  all enabled APs.
+  @retval EFI_DEVICE_ERROR        Caller processor is AP.
+  @retval EFI_NOT_STARTED         No enabled APs exist in the system.
+  @retval EFI_NOT_READY           Any enabled APs are busy.
+  @retval EFI_TIMEOUT             In blocking mode, the timeout expired
+                                  before all enabled APs have finished.
+  @retval EFI_INVALID_PARAMETER   Procedure is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StartupAllAPs (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  EFI_AP_PROCEDURE          Procedure,
+  IN  BOOLEAN                   SingleThread,
+  IN  EFI_EVENT                 WaitEvent               OPTIONAL,
+  IN  UINTN                     TimeoutInMicroSeconds,
+  IN  VOID                      *ProcedureArgument      OPTIONAL,
+  OUT UINTN                     **FailedCpuList         OPTIONAL
+  )
+{
+  UINTN       Index;
+  UINTN       EnabledCount;
+  EFI_TPL     OldTpl;
+  EFI_STATUS  Status;
+
+  if (!IsCurrentProcessorBsp ()) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (Procedure == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (FailedCpuList != NULL) {
+    *FailedCpuList = NULL;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  EnabledCount = 0;
+  for (Index = 1; Index < mCpuCount; Index++) {
+    if ((mCpuData[Index].StatusFlag & PROCESSOR_ENABLED_BIT) == 0) {
+      continue;
+    }
+
+    if (mAllApsRequest.InProgress || !IsApAvailable (Index)) {
+      gBS->RestoreTPL (OldTpl);
+      return EFI_NOT_READY;
+    }
+
+    EnabledCount++;
+  }
+
+  if (EnabledCount == 0) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_NOT_STARTED;
+  }
+
+  for (Index = 1; Index < mCpuCount; Index++) {
+    if ((mCpuData[Index].StatusFlag & PROCESSOR_ENABLED_BIT) != 0) {
+      mCpuData[Index].Owner   = ApOwnerAllAps;
+      mCpuData[Index].Pending = TRUE;
+    }
+  }
+
+  mAllApsRequest.InProgress    = TRUE;
+  mAllApsRequest.Procedure     = Procedure;
+  mAllApsRequest.Argument      = ProcedureArgument;
+  mAllApsRequest.SingleThread  = SingleThread;
+  mAllApsRequest.WaitEvent     = WaitEvent;
+  mAllApsRequest.Deadline      = GetDeadline (TimeoutInMicroSeconds);
+  mAllApsRequest.FailedCpuList = FailedCpuList;
+
+  if (SingleThread) {
+    DispatchNextPendingAp ();
+  } else {
+    while (DispatchNextPendingAp ()) {
+    }
+  }
+
+  if (WaitEvent != NULL) {
+    StartPollTimer ();
+    gBS->RestoreTPL (OldTpl);
+    return EFI_SUCCESS;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  do {
+    Status = CheckAllApsRequest ();
+  } while (Status == EFI_NOT_READY);
+
+  return Status;
+}
+
+/**
+  This service lets the caller get one enabled AP to execute a caller
+  provided function. This service may only be called from the BSP.
+
+  @param[in]  This                    A pointer to the
+                                      EFI_MP_SERVICES_PROTOCOL instance.
+  @param[in]  Procedure               A pointer to the function to be run on
+                                      the designated AP.
+  @param[in]  ProcessorNumber         The handle number of the AP.
+  @param[in]  WaitEvent               The event created by the caller with
+                                      CreateEvent () service. If NULL, the
+                                      request is blocking.
+  @param[in]  TimeoutInMicroseconds   The time limit for the AP to complete
+                                      the request, or 0 for no limit.
+  @param[in]  ProcedureArgument       The parameter passed into Procedure on
+                                      the specified AP.
+  @param[out] Finished                If not NULL, set to TRUE once the
+                                      procedure of a non-blocking request has
+                                      returned.
+
+  @retval EFI_SUCCESS             In blocking mode, the AP has finished
+                                  before the timeout expired. In non-blocking
+                                  mode, the function has been dispatched to
+                                  the AP.
+  @retval EFI_DEVICE_ERROR        The calling processor is an AP.
+  @retval EFI_TIMEOUT             In blocking mode, the timeout expired
+                                  before the AP has finished.
+  @retval EFI_NOT_READY           The specified AP is busy.
+  @retval EFI_NOT_FOUND           The processor with the handle specified by
+                                  ProcessorNumber does not exist.
+  @retval EFI_INVALID_PARAMETER   ProcessorNumber specifies the BSP or a
+                                  disabled AP, or Procedure is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StartupThisAP (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  EFI_AP_PROCEDURE          Procedure,
+  IN  UINTN                     ProcessorNumber,
+  IN  EFI_EVENT                 WaitEvent               OPTIONAL,
+  IN  UINTN                     TimeoutInMicroseconds,
+  IN  VOID                      *ProcedureArgument      OPTIONAL,
+  OUT BOOLEAN                   *Finished               OPTIONAL
+  )
+{
+  CPU_AP_DATA  *Cpu;
+  EFI_TPL      OldTpl;
+  EFI_STATUS   Status;
+
+  if (!IsCurrentProcessorBsp ()) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (Procedure == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (ProcessorNumber >= mCpuCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  Cpu = &mCpuData[ProcessorNumber];
+  if ((ProcessorNumber == 0) ||
+      ((Cpu->StatusFlag & PROCESSOR_ENABLED_BIT) == 0))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (!IsApAvailable (ProcessorNumber)) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_NOT_READY;
+  }
+
+  if (Finished != NULL) {
+    *Finished = FALSE;
+  }
+
+  Cpu->Owner     = ApOwnerThisAp;
+  Cpu->WaitEvent = WaitEvent;
+  Cpu->Deadline  = GetDeadline (TimeoutInMicroseconds);
+  Cpu->Finished  = Finished;
+
+  PostProcedure (ProcessorNumber, Procedure, ProcedureArgument);
+
+  if (WaitEvent != NULL) {
+    StartPollTimer ();
+    gBS->RestoreTPL (OldTpl);
+    return EFI_SUCCESS;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  do {
+    Status = CheckThisApRequest (ProcessorNumber);
+  } while (Status == EFI_NOT_READY);
+
+  return Status;
+}
+
+/**
+  This service switches the requested AP to be the BSP from that point onward.
+
+  The application processors run with the page tables and exception vectors
+  of the boot processor, and the timer and interrupt controller drivers only
+  serve the boot processor, so this is not supported.
+
+  @param[in] This             A pointer to the EFI_MP_SERVICES_PROTOCOL
+                              instance.
+  @param[in] ProcessorNumber  The handle number of AP that is to become the
+                              new BSP.
+  @param[in] EnableOldBSP     If TRUE, the old BSP is listed as an enabled AP.
+
+  @retval EFI_UNSUPPORTED     Switching the BSP is not supported.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SwitchBSP (
+  IN EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  UINTN                    ProcessorNumber,
+  IN  BOOLEAN                  EnableOldBSP
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  This service lets the caller enable or disable an AP from this point
+  onward. This service may only be called from the BSP.
+
+  @param[in] This             A pointer to the EFI_MP_SERVICES_PROTOCOL
+                              instance.
+  @param[in] ProcessorNumber  The handle number of AP.
+  @param[in] EnableAP         Specifies the new state for the processor.
+  @param[in] HealthFlag       If not NULL, a pointer to a value that specifies
+                              the new health status of the AP.
+
+  @retval EFI_SUCCESS             The specified AP was enabled or disabled.
+  @retval EFI_UNSUPPORTED         The AP could not be started at boot, and
+                                  cannot be enabled.
+  @retval EFI_DEVICE_ERROR        The calling processor is an AP.
+  @retval EFI_NOT_FOUND           Processor with the handle specified by
+                                  ProcessorNumber does not exist.
+  @retval EFI_INVALID_PARAMETER   ProcessorNumber specifies the BSP.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+EnableDisableAP (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  UINTN                     ProcessorNumber,
+  IN  BOOLEAN                   EnableAP,
+  IN  UINT32                    *HealthFlag OPTIONAL
+  )
+{
+  CPU_AP_DATA  *Cpu;
+
+  if (!IsCurrentProcessorBsp ()) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (ProcessorNumber >= mCpuCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (ProcessorNumber == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Cpu = &mCpuData[ProcessorNumber];
+  if (EnableAP && (Cpu->State == CpuStateOff)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (EnableAP) {
+    Cpu->StatusFlag |= PROCESSOR_ENABLED_BIT;
+  } else {
+    Cpu->StatusFlag &= ~PROCESSOR_ENABLED_BIT;
+  }
+
+  if (HealthFlag != NULL) {
+    Cpu->StatusFlag &= ~PROCESSOR_HEALTH_STATUS_BIT;
+    Cpu->StatusFlag |= *HealthFlag & PROCESSOR_HEALTH_STATUS_BIT;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  This return the handle number for the calling processor. This service may
+  be called from the BSP and APs.
+
+  @param[in]  This              A pointer to the EFI_MP_SERVICES_PROTOCOL
+                                instance.
+  @param[out] ProcessorNumber   Pointer to the handle number of AP.
+
+  @retval EFI_SUCCESS             The current processor handle number was
+                                  returned in ProcessorNumber.
+  @retval EFI_INVALID_PARAMETER   ProcessorNumber is NULL.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+WhoAmI (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  OUT UINTN                     *ProcessorNumber
+  )
+{
+  if (ProcessorNumber == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return GetCurrentProcessorNumber (ProcessorNumber);
+}
+
+STATIC EFI_MP_SERVICES_PROTOCOL  mMpServicesProtocol = {
+  GetNumberOfProcessors,
+  GetProcessorInfo,
+  StartupAllAPs,
+  StartupThisAP,
+  SwitchBSP,
+  EnableDisableAP,
+  WhoAmI
+};
+
+/**
+  Build the processor list from the gArmMpCoreInfoGuid HOB, with the boot
+  processor first.
+
+  @retval EFI_SUCCESS             The processor list was built.
+  @retval EFI_OUT_OF_RESOURCES    Memory allocation failed.
+
+**/
+STATIC
+EFI_STATUS
+CollectProcessors (
+  VOID
+  )
+{
+  VOID           *Hob;
+  ARM_CORE_INFO  *CoreInfo;
+  UINTN          CoreCount;
+  UINTN          Index;
+  UINT64         Mpidr;
+
+  CoreInfo  = NULL;
+  CoreCount = 0;
+
+  Hob = GetFirstGuidHob (&gArmMpCoreInfoGuid);
+  if (Hob != NULL) {
+    CoreInfo  = GET_GUID_HOB_DATA (Hob);
+    CoreCount = GET_GUID_HOB_DATA_SIZE (Hob) / sizeof (ARM_CORE_INFO);
+  }
+
+  //
+  // Leave room for the boot processor in case the HOB does not list it.
+  //
+  mCpuData = AllocateZeroPool ((CoreCount + 1) * sizeof (CPU_AP_DATA));
+  if (mCpuData == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mCpuData[0].Mpidr      = ArmReadMpidr () & MPIDR_AFFINITY_MASK;
+  mCpuData[0].StatusFlag = PROCESSOR_AS_BSP_BIT | PROCESSOR_ENABLED_BIT |
+                           PROCESSOR_HEALTH_STATUS_BIT;
+  mCpuData[0].State = CpuStateBusy;
+  mCpuCount         = 1;
+
+  for (Index = 0; Index < CoreCount; Index++) {
+    Mpidr = CoreInfo[Index].Mpidr & MPIDR_AFFINITY_MASK;
+    if (Mpidr == mCpuData[0].Mpidr) {
+      continue;
+    }
+
+    mCpuData[mCpuCount].Mpidr      = Mpidr;
+    mCpuData[mCpuCount].StatusFlag = PROCESSOR_ENABLED_BIT |
+                                     PROCESSOR_HEALTH_STATUS_BIT;
+    mCpuData[mCpuCount].State = CpuStateOff;
+    mCpuCount++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Mark an application processor that could not be started as disabled.
+
+  @param[in]  Index   The processor number.
+
+**/
+STATIC
+VOID
+MarkApFailed (
+  IN UINTN  Index
+  )
+{
+  mCpuData[Index].StatusFlag &= ~(PROCESSOR_ENABLED_BIT | PROCESSOR_HEALTH_STATUS_BIT);
+}
+
+/**
+  Start all the application processors with PSCI CPU_ON, and wait for them to
+  reach their idle loop.
+
+  @param[in]  ImageHandle   The image handle of this driver.
+
+  @retval EFI_SUCCESS             The processors were started, or marked
+                                  disabled if they could not be.
+  @retval EFI_OUT_OF_RESOURCES    Memory allocation failed.
+
+**/
+STATIC
+EFI_STATUS
+StartApplicationProcessors (
+  IN EFI_HANDLE  ImageHandle
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_LOADED_IMAGE_PROTOCOL  *LoadedImage;
+  AP_STARTUP_CPU             *Cpus;
+  UINT8                      *Stacks;
+  UINTN                      Index;
+  INTN                       PsciStatus;
+  UINT64                     Deadline;
+
+  Status = gBS->HandleProtocol (
+                  ImageHandle,
+                  &gEfiLoadedImageProtocolGuid,
+                  (VOID **)&LoadedImage
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  Cpus   = AllocateZeroPool (mCpuCount * sizeof (AP_STARTUP_CPU));
+  Stacks = AllocatePages (EFI_SIZE_TO_PAGES (AP_STACK_SIZE) * (mCpuCount - 1));
+  if ((Cpus == NULL) || (Stacks == NULL)) {
+    if (Cpus != NULL) {
+      FreePool (Cpus);
+    }
+
+    if (Stacks != NULL) {
+      FreePages (Stacks, EFI_SIZE_TO_PAGES (AP_STACK_SIZE) * (mCpuCount - 1));
+    }
+
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < mCpuCount; Index++) {
+    Cpus[Index].Mpidr = mCpuData[Index].Mpidr;
+    if (Index > 0) {
+      Cpus[Index].StackTop = (UINTN)Stacks + Index * AP_STACK_SIZE;
+    }
+  }
+
+  mApStartupData.Mair     = ArmGetMAIR ();
+  mApStartupData.Tcr      = ArmGetTCR ();
+  mApStartupData.Ttbr0    = (UINTN)ArmGetTTBR0BaseAddress ();
+  mApStartupData.Sctlr    = ArmReadSctlr ();
+  mApStartupData.Vbar     = ArmReadVBar ();
+  mApStartupData.CpuCount = mCpuCount;
+  mApStartupData.Cpus     = Cpus;
+
+  //
+  // The application processors start with the MMU and caches off, so the
+  // startup data and the code they run before enabling the MMU must be
+  // visible at the point of coherency.
+  //
+  WriteBackDataCacheRange (Cpus, mCpuCount * sizeof (AP_STARTUP_CPU));
+  WriteBackDataCacheRange (LoadedImage->ImageBase, (UINTN)LoadedImage->ImageSize);
+
+  for (Index = 1; Index < mCpuCount; Index++) {
+    PsciStatus = PsciCall (
+                   ARM_SMC_ID_PSCI_CPU_ON_AARCH64,
+                   (UINTN)mCpuData[Index].Mpidr,
+                   (UINTN)ApEntryPoint,
+                   0
+                   );
+    if (PsciStatus != ARM_SMC_PSCI_RET_SUCCESS) {
+      DEBUG ((
+        DEBUG_ERROR,
+        "%a: CPU_ON failed for MPIDR 0x%lx: %Ld\n",
+        __FUNCTION__,
+        mCpuData[Index].Mpidr,
+        (INT64)PsciStatus
+        ));
+      MarkApFailed (Index);
+    }
+  }
+
+  Deadline = GetTimeInNs () + AP_STARTUP_TIMEOUT;
+  for (Index = 1; Index < mCpuCount; Index++) {
+    if ((mCpuData[Index].StatusFlag & PROCESSOR_ENABLED_BIT) == 0) {
+      continue;
+    }
+
+    while ((mCpuData[Index].State == CpuStateOff) &&
+           !DeadlinePassed (Deadline))
+    {
+      MicroSecondDelay (10);
+    }
+
+    if (mCpuData[Index].State == CpuStateOff) {
+      DEBUG ((
+        DEBUG_ERROR,
+        "%a: CPU with MPIDR 0x%lx did not start\n",
+        __FUNCTION__,
+        mCpuData[Index].Mpidr
+        ));
+      MarkApFailed (Index);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Power off the idle application processors so that the OS can start them
+  with PSCI CPU_ON itself.
+
+  @param[in]  Event     The ExitBootServices event.
+  @param[in]  Context   Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+OnExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINTN   Index;
+  UINT64  Deadline;
+
+  for (Index = 1; Index < mCpuCount; Index++) {
+    if (mCpuData[Index].State == CpuStateOff) {
+      continue;
+    }
+
+    if (!IsApAvailable (Index)) {
+      DEBUG ((
+        DEBUG_WARN,
+        "%a: CPU with MPIDR 0x%lx is still running a procedure\n",
+        __FUNCTION__,
+        mCpuData[Index].Mpidr
+        ));
+      continue;
+    }
+
+    PostProcedure (Index, ApPowerOff, NULL);
+  }
+
+  Deadline = GetTimeInNs () + AP_OFF_TIMEOUT;
+  for (Index = 1; Index < mCpuCount; Index++) {
+    if ((mCpuData[Index].State == CpuStateOff) ||
+        (mCpuData[Index].Procedure != ApPowerOff))
+    {
+      continue;
+    }
+
+    while (PsciCall (
+             ARM_SMC_ID_PSCI_AFFINITY_INFO_AARCH64,
+             (UINTN)mCpuData[Index].Mpidr,
+             ARM_SMC_ID_PSCI_AFFINITY_LEVEL_0,
+             0
+             ) != ARM_SMC_ID_PSCI_AFFINITY_INFO_OFF)
+    {
+      if (DeadlinePassed (Deadline)) {
+        DEBUG ((
+          DEBUG_WARN,
+          "%a: CPU with MPIDR 0x%lx did not power off\n",
+          __FUNCTION__,
+          mCpuData[Index].Mpidr
+          ));
+        break;
+      }
+
+      MicroSecondDelay (10);
+    }
+  }
+}
+
+/**
+  Entry point of the driver. Starts the secondary cores and installs the MP
+  services protocol.
+
+  @param[in]  ImageHandle   The image handle of this driver.
+  @param[in]  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   The protocol was installed.
+  @retval other         The driver could not be initialized.
+
+**/
+EFI_STATUS
+EFIAPI
+ArmPsciMpServicesDxeInitialize (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   ExitBootServicesEvent;
+  INTN        Version;
+
+  Status = CollectProcessors ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mUseHvc = PcdGetBool (PcdMonitorConduitHvc);
+
+  if (mCpuCount > 1) {
+    Version = PsciCall (ARM_SMC_ID_PSCI_VERSION, 0, 0, 0);
+    if ((Version < 0) || ((UINTN)Version < ARM_SMC_PSCI_VERSION)) {
+      DEBUG ((DEBUG_ERROR, "%a: PSCI 0.2 or later is required\n", __FUNCTION__));
+      return EFI_UNSUPPORTED;
+    }
+
+    Status = StartApplicationProcessors (ImageHandle);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = gBS->CreateEventEx (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    OnExitBootServices,
+                    NULL,
+                    &gEfiEventExitBootServicesGuid,
+                    &ExitBootServicesEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  CheckApsStatus,
+                  NULL,
+                  &mPollEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  return gBS->InstallMultipleProtocolInterfaces (
+                &ImageHandle,
+                &gEfiMpServiceProtocolGuid,
+                &mMpServicesProtocol,
+                NULL
+                );
+}
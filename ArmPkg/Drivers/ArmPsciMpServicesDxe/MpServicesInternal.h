@@ -0,0 +1,155 @@
+/** @file
+  Internal definitions of the PSCI based MP services driver.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MP_SERVICES_INTERNAL_H_
+#define MP_SERVICES_INTERNAL_H_
+
+#include <Protocol/MpService.h>
+
+//
+// Size of the stack of each application processor.
+//
+#define AP_STACK_SIZE  SIZE_64KB
+
+//
+// Interval of the timer that completes non-blocking requests, in 100ns units.
+//
+#define AP_POLL_INTERVAL  EFI_TIMER_PERIOD_MILLISECONDS (1)
+
+//
+// Time an application processor is given to reach its idle loop after
+// CPU_ON, and to report OFF after CPU_OFF, in nanoseconds.
+//
+#define AP_STARTUP_TIMEOUT  1000000000ULL
+#define AP_OFF_TIMEOUT      100000000ULL
+
+//
+// The affinity fields of MPIDR_EL1: Aff0-Aff2 in bits [23:0], Aff3 in
+// bits [39:32].
+//
+#define MPIDR_AFFINITY_MASK  (ARM_CORE_AFF0 | ARM_CORE_AFF1 | ARM_CORE_AFF2 | ARM_CORE_AFF3)
+
+//
+// Per-CPU entry of the table used by ApEntryPoint to find its stack.
+//
+typedef struct {
+  UINT64    Mpidr;
+  UINT64    StackTop;
+} AP_STARTUP_CPU;
+
+//
+// Data used by ApEntryPoint to replicate the MMU and exception configuration
+// of the boot processor. It is read with the MMU and caches off, so it must be
+// cleaned to the point of coherency before any processor is started. The
+// offsets are relied upon by AArch64/MpFuncs.S and AArch64/MpFuncs.masm.
+//
+typedef struct {
+  UINT64            Mair;
+  UINT64            Tcr;
+  UINT64            Ttbr0;
+  UINT64            Sctlr;
+  UINT64            Vbar;
+  UINT64            CpuCount;
+  AP_STARTUP_CPU    *Cpus;
+} AP_STARTUP_DATA;
+
+typedef enum {
+  //
+  // The processor has not been started, or could not be started.
+  //
+  CpuStateOff,
+  //
+  // The processor waits in ApMain for a procedure.
+  //
+  CpuStateIdle,
+  //
+  // A procedure has been posted by the boot processor.
+  //
+  CpuStateReady,
+  //
+  // The processor runs the posted procedure.
+  //
+  CpuStateBusy,
+  //
+  // The procedure has returned, and the result was not collected yet.
+  //
+  CpuStateFinished
+} CPU_STATE;
+
+typedef enum {
+  ApOwnerNone,
+  ApOwnerThisAp,
+  ApOwnerAllAps
+} AP_OWNER;
+
+typedef struct {
+  UINT64                      Mpidr;
+  UINT32                      StatusFlag;
+  volatile CPU_STATE          State;
+  EFI_AP_PROCEDURE            Procedure;
+  VOID                        *Argument;
+
+  //
+  // The request this processor belongs to. A processor that timed out has no
+  // owner, and is returned to the idle state once its procedure returns.
+  //
+  AP_OWNER                    Owner;
+
+  //
+  // StartupThisAP bookkeeping. Deadline is in nanoseconds, 0 means none.
+  //
+  EFI_EVENT                   WaitEvent;
+  UINT64                      Deadline;
+  BOOLEAN                     *Finished;
+
+  //
+  // StartupAllAPs bookkeeping: the processor takes part in the request, but
+  // has not been dispatched yet in single threaded mode.
+  //
+  BOOLEAN                     Pending;
+} CPU_AP_DATA;
+
+typedef struct {
+  BOOLEAN             InProgress;
+  EFI_AP_PROCEDURE    Procedure;
+  VOID                *Argument;
+  BOOLEAN             SingleThread;
+  EFI_EVENT           WaitEvent;
+  UINT64              Deadline;
+  UINTN               **FailedCpuList;
+} ALL_APS_REQUEST;
+
+extern AP_STARTUP_DATA  mApStartupData;
+
+/**
+  Entry point of the application processors, passed to PSCI CPU_ON.
+
+  Looks up the stack of the calling processor, enables the MMU and caches with
+  the configuration of the boot processor, and calls ApMain.
+
+**/
+VOID
+EFIAPI
+ApEntryPoint (
+  VOID
+  );
+
+/**
+  Idle loop of the application processors. Runs the procedures posted by the
+  boot processor, and never returns.
+
+  @param[in]  CpuIndex    The processor number of the caller.
+
+**/
+VOID
+EFIAPI
+ApMain (
+  IN UINTN  CpuIndex
+  );
+
+#endif // MP_SERVICES_INTERNAL_H_
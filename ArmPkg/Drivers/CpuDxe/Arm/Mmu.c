@@ -157,6 +157,7 @@ SyncCacheConfigPage (
   volatile ARM_PAGE_TABLE_ENTRY  *SecondLevelTable;
   UINT32                         NextPageAttributes;
   UINT32                         PageAttributes;
+  UINT32                         PageDescriptor;
   UINT32                         BaseAddress;
   UINT64                         GcdAttributes;
 
@@ -172,9 +173,15 @@ SyncCacheConfigPage (
   SecondLevelTable = (ARM_PAGE_TABLE_ENTRY *)(FirstLevelDescriptor & TT_DESCRIPTOR_SECTION_PAGETABLE_ADDRESS_MASK);
 
   for (i = 0; i < TRANSLATION_TABLE_PAGE_COUNT; i++) {
-    if ((SecondLevelTable[i] & TT_DESCRIPTOR_PAGE_TYPE_MASK) == TT_DESCRIPTOR_PAGE_TYPE_PAGE) {
+    // large pages are handled as the small pages they are made of
+    PageDescriptor = SecondLevelTable[i];
+    if (TT_DESCRIPTOR_PAGE_TYPE_IS_LARGEPAGE (PageDescriptor)) {
+      PageDescriptor = TT_DESCRIPTOR_CONVERT_LARGEPAGE_TO_PAGE (PageDescriptor);
+    }
+
+    if ((PageDescriptor & TT_DESCRIPTOR_PAGE_TYPE_MASK) == TT_DESCRIPTOR_PAGE_TYPE_PAGE) {
       // extract attributes (cacheability and permissions)
-      PageAttributes = SecondLevelTable[i] & (TT_DESCRIPTOR_PAGE_CACHE_POLICY_MASK | TT_DESCRIPTOR_PAGE_AP_MASK);
+      PageAttributes = PageDescriptor & (TT_DESCRIPTOR_PAGE_CACHE_POLICY_MASK | TT_DESCRIPTOR_PAGE_AP_MASK);
 
       if (NextPageAttributes == 0) {
         // start on a new region
@@ -258,10 +265,13 @@ SyncCacheConfig (
   // Get the first region
   NextSectionAttributes = FirstLevelTable[0] & (TT_DESCRIPTOR_SECTION_CACHE_POLICY_MASK | TT_DESCRIPTOR_SECTION_AP_MASK);
 
-  // iterate through each 1MB descriptor
+  // iterate through each 1MB descriptor, supersections being handled as the
+  // sections they are made of
   NextRegionBase = NextRegionLength = 0;
   for (i = 0; i < TRANSLATION_TABLE_SECTION_COUNT; i++) {
-    if ((FirstLevelTable[i] & TT_DESCRIPTOR_SECTION_TYPE_MASK) == TT_DESCRIPTOR_SECTION_TYPE_SECTION) {
+    if (((FirstLevelTable[i] & TT_DESCRIPTOR_SECTION_TYPE_MASK) == TT_DESCRIPTOR_SECTION_TYPE_SECTION) ||
+        TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION (FirstLevelTable[i]))
+    {
       // extract attributes (cacheability and permissions)
       SectionAttributes = FirstLevelTable[i] & (TT_DESCRIPTOR_SECTION_CACHE_POLICY_MASK | TT_DESCRIPTOR_SECTION_AP_MASK);
 
@@ -302,9 +312,6 @@ SyncCacheConfig (
                                 );
       ASSERT_EFI_ERROR (Status);
     } else {
-      // We do not support yet 16MB sections
-      ASSERT ((FirstLevelTable[i] & TT_DESCRIPTOR_SECTION_TYPE_MASK) != TT_DESCRIPTOR_SECTION_TYPE_SUPERSECTION);
-
       // start on a new region
       if (NextSectionAttributes != 0) {
         // Convert Section Attributes into GCD Attributes
@@ -410,19 +417,18 @@ GetMemoryRegionPage (
     // Get the section at the given index
     PageDescriptor = PageTable[TableIndex];
 
+    // Large pages are handled as the small pages they are made of
+    if (TT_DESCRIPTOR_PAGE_TYPE_IS_LARGEPAGE (PageDescriptor)) {
+      PageDescriptor = TT_DESCRIPTOR_CONVERT_LARGEPAGE_TO_PAGE (PageDescriptor);
+    }
+
     if ((PageDescriptor & TT_DESCRIPTOR_PAGE_TYPE_MASK) == TT_DESCRIPTOR_PAGE_TYPE_FAULT) {
       // Case: End of the boundary of the region
       return EFI_SUCCESS;
-    } else if ((PageDescriptor & TT_DESCRIPTOR_PAGE_TYPE_PAGE) == TT_DESCRIPTOR_PAGE_TYPE_PAGE) {
-      if ((PageDescriptor & TT_DESCRIPTOR_PAGE_ATTRIBUTE_MASK) == PageAttributes) {
-        *RegionLength = *RegionLength + TT_DESCRIPTOR_PAGE_SIZE;
-      } else {
-        // Case: End of the boundary of the region
-        return EFI_SUCCESS;
-      }
+    } else if ((PageDescriptor & TT_DESCRIPTOR_PAGE_ATTRIBUTE_MASK) == PageAttributes) {
+      *RegionLength = *RegionLength + TT_DESCRIPTOR_PAGE_SIZE;
     } else {
-      // We do not support Large Page yet. We return EFI_SUCCESS that means end of the region.
-      ASSERT (0);
+      // Case: End of the boundary of the region
       return EFI_SUCCESS;
     }
   }
@@ -478,7 +484,12 @@ GetMemoryRegion (
     PageTableIndex = ((*BaseAddress) & TT_DESCRIPTOR_PAGE_INDEX_MASK)  >> TT_DESCRIPTOR_PAGE_BASE_SHIFT;
     ASSERT (PageTableIndex < TRANSLATION_TABLE_PAGE_COUNT);
 
-    PageAttributes    = PageTable[PageTableIndex] & TT_DESCRIPTOR_PAGE_ATTRIBUTE_MASK;
+    PageAttributes = PageTable[PageTableIndex];
+    if (TT_DESCRIPTOR_PAGE_TYPE_IS_LARGEPAGE (PageAttributes)) {
+      PageAttributes = TT_DESCRIPTOR_CONVERT_LARGEPAGE_TO_PAGE (PageAttributes);
+    }
+
+    PageAttributes   &= TT_DESCRIPTOR_PAGE_ATTRIBUTE_MASK;
     *RegionAttributes = TT_DESCRIPTOR_CONVERT_TO_SECTION_CACHE_POLICY (PageAttributes, 0) |
                         TT_DESCRIPTOR_CONVERT_TO_SECTION_AP (PageAttributes);
   }
@@ -51,7 +51,8 @@
 #define TT_DESCRIPTOR_SECTION_TYPE_PAGE_TABLE    (1UL << 0)
 #define TT_DESCRIPTOR_SECTION_TYPE_SECTION       ((0UL << 18) | (2UL << 0))
 #define TT_DESCRIPTOR_SECTION_TYPE_SUPERSECTION  ((1UL << 18) | (2UL << 0))
-#define TT_DESCRIPTOR_SECTION_TYPE_IS_PAGE_TABLE(Desc)  (((Desc) & 3UL) == TT_DESCRIPTOR_SECTION_TYPE_PAGE_TABLE)
+#define TT_DESCRIPTOR_SECTION_TYPE_IS_PAGE_TABLE(Desc)    (((Desc) & 3UL) == TT_DESCRIPTOR_SECTION_TYPE_PAGE_TABLE)
+#define TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION(Desc)  (((Desc) & TT_DESCRIPTOR_SECTION_TYPE_MASK) == TT_DESCRIPTOR_SECTION_TYPE_SUPERSECTION)
 
 // Translation table descriptor types
 #define TT_DESCRIPTOR_PAGE_TYPE_MASK       (3UL << 0)
@@ -59,10 +60,16 @@
 #define TT_DESCRIPTOR_PAGE_TYPE_PAGE       (2UL << 0)
 #define TT_DESCRIPTOR_PAGE_TYPE_PAGE_XN    (3UL << 0)
 #define TT_DESCRIPTOR_PAGE_TYPE_LARGEPAGE  (1UL << 0)
+#define TT_DESCRIPTOR_PAGE_TYPE_IS_LARGEPAGE(Desc)  (((Desc) & TT_DESCRIPTOR_PAGE_TYPE_MASK) == TT_DESCRIPTOR_PAGE_TYPE_LARGEPAGE)
 
 // Section descriptor definitions
 #define TT_DESCRIPTOR_SECTION_SIZE  (0x00100000)
 
+// Supersection descriptor definitions. A supersection is made of 16
+// consecutive first level entries holding the same descriptor.
+#define TT_DESCRIPTOR_SUPERSECTION_SIZE   (0x01000000)
+#define TT_DESCRIPTOR_SUPERSECTION_COUNT  (TT_DESCRIPTOR_SUPERSECTION_SIZE / TT_DESCRIPTOR_SECTION_SIZE)
+
 #define TT_DESCRIPTOR_SECTION_NS_MASK  (1UL << 19)
 #define TT_DESCRIPTOR_SECTION_NS       (1UL << 19)
 
@@ -114,6 +121,11 @@
 
 #define TT_DESCRIPTOR_PAGE_SIZE  (0x00001000)
 
+// Large page descriptor definitions. A large page is made of 16 consecutive
+// second level entries holding the same descriptor.
+#define TT_DESCRIPTOR_LARGEPAGE_SIZE   (0x00010000)
+#define TT_DESCRIPTOR_LARGEPAGE_COUNT  (TT_DESCRIPTOR_LARGEPAGE_SIZE / TT_DESCRIPTOR_PAGE_SIZE)
+
 #define TT_DESCRIPTOR_PAGE_CACHE_POLICY_MASK                    ((3UL << 6) | (1UL << 3) | (1UL << 2))
 #define TT_DESCRIPTOR_PAGE_CACHEABLE_MASK                       (1UL << 3)
 #define TT_DESCRIPTOR_PAGE_CACHE_POLICY_STRONGLY_ORDERED        ((0UL << 6) | (0UL << 3) | (0UL << 2))
@@ -149,6 +161,18 @@
                                                                     (((Desc) & TT_DESCRIPTOR_LARGEPAGE_CACHE_POLICY_MASK) & TT_DESCRIPTOR_SECTION_CACHE_POLICY_MASK): \
                                                                     (((((Desc) & (0x3 << 6)) << 6) | (Desc & (0x3 << 2)))))
 
+#define TT_DESCRIPTOR_LARGEPAGE_COMMON_MASK  (TT_DESCRIPTOR_PAGE_NG_MASK | TT_DESCRIPTOR_PAGE_S_MASK | \
+                                                             TT_DESCRIPTOR_PAGE_AP_MASK | (0x3UL << 2))
+
+#define TT_DESCRIPTOR_CONVERT_PAGE_TO_LARGEPAGE(Desc)  (((Desc) & TT_DESCRIPTOR_LARGEPAGE_COMMON_MASK)             | \
+                                                             (((Desc) & (0x7UL << 6)) << 6)                         | \
+                                                             (((Desc) & TT_DESCRIPTOR_PAGE_XN_MASK) << 15)          | \
+                                                             TT_DESCRIPTOR_PAGE_TYPE_LARGEPAGE)
+#define TT_DESCRIPTOR_CONVERT_LARGEPAGE_TO_PAGE(Desc)  (((Desc) & TT_DESCRIPTOR_LARGEPAGE_COMMON_MASK)             | \
+                                                             (((Desc) >> 6) & (0x7UL << 6))                         | \
+                                                             (((Desc) & TT_DESCRIPTOR_LARGEPAGE_XN_MASK) >> 15)     | \
+                                                             TT_DESCRIPTOR_PAGE_TYPE_PAGE)
+
 #define TT_DESCRIPTOR_SECTION_ATTRIBUTE_MASK  (TT_DESCRIPTOR_SECTION_NS_MASK | TT_DESCRIPTOR_SECTION_NG_MASK |               \
                                                              TT_DESCRIPTOR_SECTION_S_MASK | TT_DESCRIPTOR_SECTION_AP_MASK | \
                                                              TT_DESCRIPTOR_SECTION_XN_MASK | TT_DESCRIPTOR_SECTION_CACHE_POLICY_MASK)
@@ -165,11 +189,23 @@
 #define TT_DESCRIPTOR_SECTION_BASE_ADDRESS(a)  ((a) & TT_DESCRIPTOR_SECTION_BASE_ADDRESS_MASK)
 #define TT_DESCRIPTOR_SECTION_BASE_SHIFT  20
 
+#define TT_DESCRIPTOR_SUPERSECTION_BASE_ADDRESS_MASK  (0xFF000000)
+#define TT_DESCRIPTOR_SUPERSECTION_BASE_ADDRESS(a)  ((a) & TT_DESCRIPTOR_SUPERSECTION_BASE_ADDRESS_MASK)
+
+// Supersections share the attribute layout of sections, but have no domain
+#define TT_DESCRIPTOR_CONVERT_SECTION_TO_SUPERSECTION(Desc)  (((Desc) & TT_DESCRIPTOR_SECTION_ATTRIBUTE_MASK) | \
+                                                             TT_DESCRIPTOR_SECTION_TYPE_SUPERSECTION)
+#define TT_DESCRIPTOR_CONVERT_SUPERSECTION_TO_SECTION(Desc)  (((Desc) & TT_DESCRIPTOR_SECTION_ATTRIBUTE_MASK) | \
+                                                             TT_DESCRIPTOR_SECTION_TYPE_SECTION)
+
 #define TT_DESCRIPTOR_PAGE_BASE_ADDRESS_MASK  (0xFFFFF000)
 #define TT_DESCRIPTOR_PAGE_INDEX_MASK         (0x000FF000)
 #define TT_DESCRIPTOR_PAGE_BASE_ADDRESS(a)  ((a) & TT_DESCRIPTOR_PAGE_BASE_ADDRESS_MASK)
 #define TT_DESCRIPTOR_PAGE_BASE_SHIFT  12
 
+#define TT_DESCRIPTOR_LARGEPAGE_BASE_ADDRESS_MASK  (0xFFFF0000)
+#define TT_DESCRIPTOR_LARGEPAGE_BASE_ADDRESS(a)  ((a) & TT_DESCRIPTOR_LARGEPAGE_BASE_ADDRESS_MASK)
+
 #define TT_DESCRIPTOR_SECTION_WRITE_BACK(NonSecure)     (TT_DESCRIPTOR_SECTION_TYPE_SECTION                                                           |     \
                                                             ((NonSecure) ?  TT_DESCRIPTOR_SECTION_NS : 0)    | \
                                                             TT_DESCRIPTOR_SECTION_NG_GLOBAL                         | \
@@ -234,4 +270,41 @@ ConvertSectionAttributesToPageAttributes (
   IN BOOLEAN  IsLargePage
   );
 
+/**
+  Check whether the MMU implements supersections.
+
+  @retval TRUE    Supersections may be used.
+  @retval FALSE   ID_MMFR3.Supersec reports that supersections are not
+                  supported, so 1MB sections must be used instead.
+
+**/
+BOOLEAN
+ArmMmuSupersectionsSupported (
+  VOID
+  );
+
+/**
+  Replace a supersection by the 16 sections it is made of, with the same
+  attributes.
+
+  @param[in]  SectionEntry  Any of the first level entries of the supersection.
+
+**/
+VOID
+ConvertSupersectionToSections (
+  IN volatile ARM_FIRST_LEVEL_DESCRIPTOR  *SectionEntry
+  );
+
+/**
+  Replace a large page by the 16 small pages it is made of, with the same
+  attributes.
+
+  @param[in]  PageEntry   Any of the second level entries of the large page.
+
+**/
+VOID
+ConvertLargePageToPages (
+  IN volatile ARM_PAGE_TABLE_ENTRY  *PageEntry
+  );
+
 #endif // ARMV7_MMU_H_
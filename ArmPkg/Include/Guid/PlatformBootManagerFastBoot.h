@@ -0,0 +1,36 @@
+/** @file
+  Variable used by PlatformBootManagerLib to remember the last boot target, so
+  that a boot with an unchanged platform configuration can connect only the
+  controllers on the path to that target.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PLATFORM_BOOT_MANAGER_FAST_BOOT_H_
+#define PLATFORM_BOOT_MANAGER_FAST_BOOT_H_
+
+#define PLATFORM_BOOT_MANAGER_FAST_BOOT_GUID \
+  { 0x2e8af107, 0xeda0, 0x4dda, { 0xbc, 0x06, 0xea, 0x30, 0xab, 0x20, 0x61, 0xc7 } }
+
+#define PLATFORM_BOOT_MANAGER_FAST_BOOT_VARIABLE_NAME  L"FastBootTarget"
+
+typedef struct {
+  //
+  // CRC32 of the platform configuration the target was booted with.
+  //
+  UINT32    Fingerprint;
+  //
+  // The Boot#### option that was booted.
+  //
+  UINT16    OptionNumber;
+  UINT16    Reserved;
+  //
+  // Followed by the full device path of the boot option.
+  //
+} PLATFORM_BOOT_MANAGER_FAST_BOOT_TARGET;
+
+extern EFI_GUID  gPlatformBootManagerFastBootGuid;
+
+#endif
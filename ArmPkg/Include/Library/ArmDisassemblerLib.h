@@ -9,6 +9,75 @@
 #ifndef ARM_DISASSEMBLER_LIB_H_
 #define ARM_DISASSEMBLER_LIB_H_
 
+#define ARM_DECODED_MAX_OPERANDS  6
+
+//
+// Condition code of instructions that are not conditional.
+//
+#define ARM_CONDITION_ALWAYS  0xE
+
+typedef enum {
+  //
+  // Value is a core register number, 13 to 15 being SP, LR and PC.
+  //
+  ArmOperandRegister,
+  //
+  // Value is an immediate, e.g. an offset, a shift amount or a constant.
+  //
+  ArmOperandImmediate,
+  //
+  // Value is an address computed from the PC, e.g. a branch target or the
+  // location of a literal.
+  //
+  ArmOperandAddress,
+  //
+  // Value is a bit mask of core registers.
+  //
+  ArmOperandRegisterList,
+  //
+  // Value is a coprocessor number.
+  //
+  ArmOperandCoprocessor,
+  //
+  // Value is a coprocessor register number.
+  //
+  ArmOperandCoprocessorRegister
+} ARM_OPERAND_TYPE;
+
+typedef struct {
+  ARM_OPERAND_TYPE    Type;
+  UINT32              Value;
+} ARM_OPERAND;
+
+//
+// Instruction decoded without producing text.
+//
+typedef struct {
+  //
+  // Mnemonic without condition or flag setting suffix, NULL if the
+  // instruction is not known.
+  //
+  CONST CHAR8    *Mnemonic;
+  //
+  // The encoding. The first halfword of 32-bit Thumb instructions is in
+  // bits [31:16].
+  //
+  UINT32         Encoding;
+  //
+  // Size of the instruction in bytes.
+  //
+  UINT8          Length;
+  UINT8          Condition;
+  BOOLEAN        SetFlags;
+  BOOLEAN        WriteBack;
+  //
+  // The operands in assembly order. Memory operands are flattened into their
+  // base register followed by their offset.
+  //
+  UINT8          OperandCount;
+  ARM_OPERAND    Operands[ARM_DECODED_MAX_OPERANDS];
+} ARM_DECODED_INSTRUCTION;
+
 /**
   Place a disassembly of **OpCodePtr into buffer, and update OpCodePtr to
   point to next instruction.
@@ -34,4 +103,29 @@ DisassembleInstruction (
   OUT UINTN      Size
   );
 
+/**
+  Decode the instruction at OpCodePtr into its mnemonic and operands, without
+  producing any text.
+
+  Addresses computed from the PC assume the instruction executes where it is
+  located.
+
+  @param  OpCodePtr     Pointer to the instruction to decode.
+  @param  Thumb         TRUE for Thumb(2), FALSE for ARM instruction stream
+  @param  Instruction   The decoded instruction. Length and Encoding are set
+                        even if the instruction is not known.
+
+  @retval RETURN_SUCCESS      The instruction was decoded.
+  @retval RETURN_NOT_FOUND    The instruction is not known.
+  @retval RETURN_UNSUPPORTED  Decoding is not supported for this instruction
+                              set.
+
+**/
+RETURN_STATUS
+DecodeInstruction (
+  IN  CONST UINT8              *OpCodePtr,
+  IN  BOOLEAN                  Thumb,
+  OUT ARM_DECODED_INSTRUCTION  *Instruction
+  );
+
 #endif // ARM_DISASSEMBLER_LIB_H_
@@ -0,0 +1,122 @@
+/** @file
+  Index of the files of a firmware volume.
+
+  The files of a firmware volume are walked once, their headers are checked,
+  and each of them is recorded in a caller provided table, chained by file
+  type and by file name. Looking up a file then only visits the files that
+  share its chain, instead of walking the firmware volume again.
+
+  The index does not allocate memory, so that it can be used from SEC and
+  PrePi, with the table on the stack.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef FV_FILE_INDEX_LIB_H_
+#define FV_FILE_INDEX_LIB_H_
+
+#include <Pi/PiFirmwareFile.h>
+#include <Pi/PiFirmwareVolume.h>
+
+#define FV_FILE_INDEX_BUCKETS  16
+
+typedef struct {
+  //
+  // The offset of the file header from the base of the firmware volume.
+  //
+  UINT32    Offset;
+  //
+  // The next entries of the same type and name chains, in firmware volume
+  // order, or MAX_UINT16 at the end of a chain.
+  //
+  UINT16    NextOfType;
+  UINT16    NextOfName;
+} FV_FILE_INDEX_ENTRY;
+
+typedef struct {
+  EFI_FIRMWARE_VOLUME_HEADER    *FwVolHeader;
+  FV_FILE_INDEX_ENTRY           *Entries;
+  UINT16                        MaxCount;
+  UINT16                        Count;
+  //
+  // The offset of the first file that did not fit in the table, or zero if
+  // every file of the firmware volume is indexed.
+  //
+  UINT32                        UnindexedOffset;
+  UINT16                        TypeHeads[FV_FILE_INDEX_BUCKETS];
+  UINT16                        NameHeads[FV_FILE_INDEX_BUCKETS];
+} FV_FILE_INDEX;
+
+/**
+  Index the files of a firmware volume.
+
+  Files are indexed until the end of the firmware volume, a file with an
+  invalid header, or the end of the table. If the table is too small, the
+  files that did not fit are still found by the lookup functions, by walking
+  the rest of the firmware volume.
+
+  @param[in]  FwVolHeader   The firmware volume.
+  @param[in]  Entries       The table of the index.
+  @param[in]  MaxCount      The number of entries of the table, at most
+                            MAX_UINT16.
+  @param[out] Index         The index.
+
+  @retval EFI_SUCCESS             Every file of the firmware volume was
+                                  indexed.
+  @retval EFI_BUFFER_TOO_SMALL    The table is too small for every file.
+  @retval EFI_VOLUME_CORRUPTED    The header of a file is invalid. The files
+                                  before it were indexed.
+  @retval EFI_INVALID_PARAMETER   A parameter is NULL, or FwVolHeader is not a
+                                  firmware volume.
+
+**/
+EFI_STATUS
+EFIAPI
+FvFileIndexInitialize (
+  IN  EFI_FIRMWARE_VOLUME_HEADER  *FwVolHeader,
+  IN  FV_FILE_INDEX_ENTRY         *Entries,
+  IN  UINTN                       MaxCount,
+  OUT FV_FILE_INDEX               *Index
+  );
+
+/**
+  Find the first file of a given type.
+
+  @param[in]  Index       The index.
+  @param[in]  FileType    The type of the file.
+  @param[out] FileHeader  The header of the file.
+
+  @retval EFI_SUCCESS     The file was found.
+  @retval EFI_NOT_FOUND   The firmware volume has no file of this type.
+
+**/
+EFI_STATUS
+EFIAPI
+FvFileIndexFindByType (
+  IN  CONST FV_FILE_INDEX  *Index,
+  IN  EFI_FV_FILETYPE      FileType,
+  OUT EFI_FFS_FILE_HEADER  **FileHeader
+  );
+
+/**
+  Find a file by name.
+
+  @param[in]  Index       The index.
+  @param[in]  Name        The name of the file.
+  @param[out] FileHeader  The header of the file.
+
+  @retval EFI_SUCCESS     The file was found.
+  @retval EFI_NOT_FOUND   The firmware volume has no file of this name.
+
+**/
+EFI_STATUS
+EFIAPI
+FvFileIndexFindByName (
+  IN  CONST FV_FILE_INDEX  *Index,
+  IN  CONST EFI_GUID       *Name,
+  OUT EFI_FFS_FILE_HEADER  **FileHeader
+  );
+
+#endif // FV_FILE_INDEX_LIB_H_
@@ -0,0 +1,76 @@
+/** @file
+  Batching of the symbol load records of the PE/COFF extra action libraries.
+
+  Each image load or unload produces a debugger command. Writing each command
+  to the host as soon as it is produced costs a round trip to the debugger or
+  to the model per image. This library keeps the commands in memory and writes
+  them in large blocks at the boot milestones, along with a manifest that
+  lists every record in a fixed, machine-readable format.
+
+  The manifest starts with the PECOFF_SYMBOL_MANIFEST_HEADER line, followed by
+  one line per record:
+
+    load <address> <path>
+    unload <address> <path>
+
+  where <address> is the address the symbols are loaded at, as a 16 digit
+  hexadecimal number prefixed with 0x, and <path> runs to the end of the line.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PECOFF_SYMBOL_BATCH_LIB_H_
+#define PECOFF_SYMBOL_BATCH_LIB_H_
+
+#define PECOFF_SYMBOL_MANIFEST_HEADER  "# PE/COFF symbol manifest v1\n"
+
+/**
+  Write a block of text to the debugger.
+
+  @param[in]  String  The NULL-terminated text to write. It holds one or more
+                      complete lines.
+
+**/
+typedef
+VOID
+(EFIAPI *PECOFF_SYMBOL_BATCH_OUTPUT)(
+  IN CONST CHAR8  *String
+  );
+
+/**
+  Queue the debugger command and the manifest record of an image load or
+  unload.
+
+  The queued records are written when the buffer is full, and at the boot
+  milestones supported by the library instance.
+
+  @param[in]  WriteCommands  Writes a block of debugger commands.
+  @param[in]  WriteManifest  Writes a block of manifest lines. Optional.
+  @param[in]  Command        The NULL-terminated debugger command for the
+                             image, including its line terminator.
+  @param[in]  Load           TRUE if the image is loaded, FALSE if it is
+                             unloaded.
+  @param[in]  ImagePath      The NULL-terminated path of the symbol file of
+                             the image, as the debugger sees it.
+  @param[in]  ImageAddress   The address the symbols are loaded at.
+
+  @retval RETURN_SUCCESS      The record was queued or written.
+  @retval RETURN_UNSUPPORTED  Records are not batched by this library
+                              instance, or not at this point of the boot.
+                              The caller must write the command itself.
+
+**/
+RETURN_STATUS
+EFIAPI
+PeCoffSymbolBatchRecord (
+  IN PECOFF_SYMBOL_BATCH_OUTPUT  WriteCommands,
+  IN PECOFF_SYMBOL_BATCH_OUTPUT  WriteManifest  OPTIONAL,
+  IN CONST CHAR8                 *Command,
+  IN BOOLEAN                     Load,
+  IN CONST CHAR8                 *ImagePath,
+  IN PHYSICAL_ADDRESS            ImageAddress
+  );
+
+#endif // PECOFF_SYMBOL_BATCH_LIB_H_
@@ -40,3 +40,32 @@ DisassembleInstruction (
   AsciiSPrint (Buf, Size, "AArch64 not supported");
   return;
 }
+
+/**
+  Decode the instruction at OpCodePtr into its mnemonic and operands, without
+  producing any text.
+
+  @param  OpCodePtr     Pointer to the instruction to decode.
+  @param  Thumb         TRUE for Thumb(2), FALSE for ARM instruction stream
+  @param  Instruction   The decoded instruction. Length and Encoding are set
+                        even if the instruction is not known.
+
+  @retval RETURN_UNSUPPORTED  Not yet supported for AArch64.
+
+**/
+RETURN_STATUS
+DecodeInstruction (
+  IN  CONST UINT8              *OpCodePtr,
+  IN  BOOLEAN                  Thumb,
+  OUT ARM_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  Instruction->Mnemonic     = NULL;
+  Instruction->Encoding     = *(CONST UINT32 *)OpCodePtr;
+  Instruction->Length       = 4;
+  Instruction->Condition    = ARM_CONDITION_ALWAYS;
+  Instruction->SetFlags     = FALSE;
+  Instruction->WriteBack    = FALSE;
+  Instruction->OperandCount = 0;
+  return RETURN_UNSUPPORTED;
+}
@@ -19,6 +19,7 @@
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/PrintLib.h>
+#include <Library/ArmDisassemblerLib.h>
 
 extern CHAR8  *gCondition[];
 
@@ -371,6 +372,92 @@ THUMB_INSTRUCTIONS  gOpThumb2[] = {
   { "RFE",    0xe990c000, 0xffd0ffff, RFE_FORMAT           } // RFE{IA}<c> <Rn>{!}
 };
 
+//
+// The tables above are searched in order and the first matching entry wins.
+// Instead of scanning a whole table for every instruction, the entries are
+// grouped in buckets keyed on bits [15:8] of 16-bit instructions and on bits
+// [28:20] of 32-bit ones, which discriminate most entries. A bucket holds,
+// in table order, the entries that can match an instruction with its key,
+// so scanning it finds the same entry as scanning the whole table.
+//
+#define THUMB_BUCKET_DEPTH   8
+#define THUMB_BUCKET_SHIFT   8
+#define THUMB_BUCKETS        256
+#define THUMB2_BUCKET_SHIFT  20
+#define THUMB2_BUCKETS       512
+
+#define THUMB_BUCKET(OpCode)    (&mThumbBuckets[((OpCode) >> THUMB_BUCKET_SHIFT) & (THUMB_BUCKETS - 1)])
+#define THUMB2_BUCKET(OpCode)   (&mThumb2Buckets[((OpCode) >> THUMB2_BUCKET_SHIFT) & (THUMB2_BUCKETS - 1)])
+
+typedef struct {
+  UINT8    Count;
+  UINT8    Entry[THUMB_BUCKET_DEPTH];
+} THUMB_BUCKET;
+
+STATIC BOOLEAN       mThumbBucketsBuilt = FALSE;
+STATIC THUMB_BUCKET  mThumbBuckets[THUMB_BUCKETS];
+STATIC THUMB_BUCKET  mThumb2Buckets[THUMB2_BUCKETS];
+
+/**
+  Group the entries of an instruction table in buckets.
+
+  @param  Table         The instruction table.
+  @param  TableSize     The number of entries of the table.
+  @param  Shift         The position of the key in the instructions.
+  @param  Buckets       The buckets.
+  @param  BucketCount   The number of buckets, a power of two.
+
+**/
+STATIC
+VOID
+BuildThumbBuckets (
+  IN  CONST THUMB_INSTRUCTIONS  *Table,
+  IN  UINTN                     TableSize,
+  IN  UINTN                     Shift,
+  OUT THUMB_BUCKET              *Buckets,
+  IN  UINTN                     BucketCount
+  )
+{
+  UINT32  Key;
+  UINT32  KeyMask;
+  UINTN   Index;
+
+  KeyMask = (UINT32)(BucketCount - 1) << Shift;
+
+  for (Key = 0; Key < BucketCount; Key++) {
+    Buckets[Key].Count = 0;
+    for (Index = 0; Index < TableSize; Index++) {
+      if ((((Key << Shift) ^ Table[Index].OpCode) & Table[Index].Mask & KeyMask) != 0) {
+        continue;
+      }
+
+      ASSERT (Buckets[Key].Count < THUMB_BUCKET_DEPTH);
+      if (Buckets[Key].Count < THUMB_BUCKET_DEPTH) {
+        Buckets[Key].Entry[Buckets[Key].Count++] = (UINT8)Index;
+      }
+    }
+  }
+}
+
+/**
+  Build the buckets of both instruction tables on first use.
+
+**/
+STATIC
+VOID
+InitializeThumbBuckets (
+  VOID
+  )
+{
+  if (mThumbBucketsBuilt) {
+    return;
+  }
+
+  BuildThumbBuckets (gOpThumb, ARRAY_SIZE (gOpThumb), THUMB_BUCKET_SHIFT, mThumbBuckets, THUMB_BUCKETS);
+  BuildThumbBuckets (gOpThumb2, ARRAY_SIZE (gOpThumb2), THUMB2_BUCKET_SHIFT, mThumb2Buckets, THUMB2_BUCKETS);
+  mThumbBucketsBuilt = TRUE;
+}
+
 CHAR8  *gShiftType[] = {
   "LSL",
   "LSR",
@@ -497,6 +584,11 @@ DisassembleThumbInstruction (
   BOOLEAN  WriteBack; // W
   UINT32   Coproc, Opc1, Opc2, CRd, CRn, CRm;
   UINT32   Mask;
+  UINTN    Slot;
+  UINTN    Count;
+  UINT8    *Entry;
+
+  InitializeThumbBuckets ();
 
   OpCodePtr = *OpCodePtrPtr;
   OpCode    = **OpCodePtrPtr;
@@ -525,7 +617,10 @@ DisassembleThumbInstruction (
     ItFlag = FALSE;
   }*/
 
-  for (Index = 0; Index < sizeof (gOpThumb)/sizeof (THUMB_INSTRUCTIONS); Index++) {
+  Count = THUMB_BUCKET (OpCode)->Count;
+  Entry = THUMB_BUCKET (OpCode)->Entry;
+  for (Slot = 0; Slot < Count; Slot++) {
+    Index = Entry[Slot];
     if ((OpCode & gOpThumb[Index].Mask) == gOpThumb[Index].OpCode) {
       if (Extended) {
         Offset = AsciiSPrint (Buf, Size, "0x%04x       %-6a", OpCode, gOpThumb[Index].Start);
@@ -695,7 +790,11 @@ DisassembleThumbInstruction (
   Rd             = (OpCode32 >> 8) & 0xf;
   Rm             = (OpCode32 & 0xf);
   Rn             = (OpCode32 >> 16) & 0xf;
-  for (Index = 0; Index < sizeof (gOpThumb2)/sizeof (THUMB_INSTRUCTIONS); Index++) {
+
+  Count = THUMB2_BUCKET (OpCode32)->Count;
+  Entry = THUMB2_BUCKET (OpCode32)->Entry;
+  for (Slot = 0; Slot < Count; Slot++) {
+    Index = Entry[Slot];
     if ((OpCode32 & gOpThumb2[Index].Mask) == gOpThumb2[Index].OpCode) {
       if (Extended) {
         Offset = AsciiSPrint (Buf, Size, "0x%04x   %-6a", OpCode32, gOpThumb2[Index].Start);
@@ -1032,6 +1131,565 @@ DisassembleThumbInstruction (
   AsciiSPrint (Buf, Size, "0x%08x", OpCode32);
 }
 
+/**
+  Append an operand to a decoded instruction.
+
+  @param  Instruction   The decoded instruction.
+  @param  Type          The type of the operand.
+  @param  Value         The value of the operand.
+
+**/
+STATIC
+VOID
+AddOperand (
+  IN OUT ARM_DECODED_INSTRUCTION  *Instruction,
+  IN     ARM_OPERAND_TYPE         Type,
+  IN     UINT32                   Value
+  )
+{
+  ASSERT (Instruction->OperandCount < ARM_DECODED_MAX_OPERANDS);
+  if (Instruction->OperandCount < ARM_DECODED_MAX_OPERANDS) {
+    Instruction->Operands[Instruction->OperandCount].Type  = Type;
+    Instruction->Operands[Instruction->OperandCount].Value = Value;
+    Instruction->OperandCount++;
+  }
+}
+
+/**
+  Expand the modified immediate constant of a Thumb2 data processing
+  instruction, i.e. ThumbExpandImm() of the ARM ARM.
+
+  @param  Imm12   The i:imm3:imm8 field of the instruction.
+
+  @return The constant.
+
+**/
+STATIC
+UINT32
+ThumbExpandImm (
+  IN  UINT32  Imm12
+  )
+{
+  UINT32  Imm8;
+
+  Imm8 = Imm12 & 0xff;
+  if ((Imm12 & 0xc00) == 0) {
+    switch ((Imm12 >> 8) & 3) {
+      case 0:
+        return Imm8;
+      case 1:
+        return (Imm8 << 16) | Imm8;
+      case 2:
+        return (Imm8 << 24) | (Imm8 << 8);
+      default:
+        return Imm8 * 0x01010101;
+    }
+  }
+
+  return RRotU32 (0x80 | (Imm12 & 0x7f), (Imm12 >> 7) & 0x1f);
+}
+
+/**
+  Decode the operands of a 16-bit Thumb instruction.
+
+  @param  OpCode        The instruction.
+  @param  AddressMode   The address mode of the matching table entry.
+  @param  Pc            The address of the instruction.
+  @param  Instruction   The decoded instruction.
+
+**/
+STATIC
+VOID
+DecodeThumbOperands (
+  IN     UINT16                   OpCode,
+  IN     UINT32                   AddressMode,
+  IN     UINT32                   Pc,
+  IN OUT ARM_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT32  Rd, Rn, Rm, Rt;
+  UINT32  Imm8;
+
+  Rd   = OpCode & 0x7;
+  Rn   = (OpCode >> 3) & 0x7;
+  Rm   = (OpCode >> 6) & 0x7;
+  Rt   = (OpCode >> 8) & 0x7;
+  Imm8 = OpCode & 0xff;
+
+  switch (AddressMode) {
+    case LOAD_STORE_FORMAT1:
+      // <Rt>, [<Rn>, #<imm5 * 4>]
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode >> 4) & 0x7c);
+      break;
+    case LOAD_STORE_FORMAT1_H:
+      // <Rt>, [<Rn>, #<imm5 * 2>]
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode >> 5) & 0x3e);
+      break;
+    case LOAD_STORE_FORMAT1_B:
+      // <Rt>, [<Rn>, #<imm5>]
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode >> 6) & 0x1f);
+      break;
+    case LOAD_STORE_FORMAT2:
+    case DATA_FORMAT1:
+      // <Rt>, [<Rn>, <Rm>] or <Rd>, <Rn>, <Rm>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      break;
+    case LOAD_STORE_FORMAT3:
+      // <Rt>, <label>
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandAddress, PcAlign4 (Pc) + (Imm8 << 2));
+      break;
+    case LOAD_STORE_FORMAT4:
+      // <Rt>, [SP, #<imm8 * 4>]
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, 13);
+      AddOperand (Instruction, ArmOperandImmediate, Imm8 << 2);
+      break;
+    case LOAD_STORE_MULTIPLE_FORMAT1:
+      // <Rn>!, <registers>
+      Instruction->WriteBack = TRUE;
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegisterList, Imm8);
+      break;
+    case POP_FORMAT:
+      AddOperand (Instruction, ArmOperandRegisterList, Imm8 | (((OpCode & BIT8) != 0) ? BIT15 : 0));
+      break;
+    case PUSH_FORMAT:
+      AddOperand (Instruction, ArmOperandRegisterList, Imm8 | (((OpCode & BIT8) != 0) ? BIT14 : 0));
+      break;
+    case IMMED_8:
+      AddOperand (Instruction, ArmOperandImmediate, Imm8);
+      break;
+    case CONDITIONAL_BRANCH:
+      Instruction->Condition = (UINT8)((OpCode >> 8) & 0xf);
+      AddOperand (Instruction, ArmOperandAddress, Pc + 4 + SignExtend32 (Imm8 << 1, BIT8));
+      break;
+    case UNCONDITIONAL_BRANCH_SHORT:
+      AddOperand (Instruction, ArmOperandAddress, Pc + 4 + SignExtend32 ((OpCode & 0x7ff) << 1, BIT11));
+      break;
+    case BRANCH_EXCHANGE:
+      AddOperand (Instruction, ArmOperandRegister, (OpCode >> 3) & 0xf);
+      break;
+    case DATA_FORMAT2:
+      // <Rd>, <Rn>, #<imm3>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, Rm);
+      break;
+    case DATA_FORMAT3:
+      // <Rdn>, #<imm8>
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandImmediate, Imm8);
+      break;
+    case DATA_FORMAT4:
+      // <Rd>, <Rm>, #<imm5>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode >> 6) & 0x1f);
+      break;
+    case DATA_FORMAT5:
+      // <Rdn>, <Rm>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      break;
+    case DATA_FORMAT6_SP:
+      // <Rd>, SP, #<imm8 * 4>
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, 13);
+      AddOperand (Instruction, ArmOperandImmediate, Imm8 << 2);
+      break;
+    case DATA_FORMAT6_PC:
+    case ADR_FORMAT:
+      // <Rd>, <label>
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandAddress, PcAlign4 (Pc) + (Imm8 << 2));
+      break;
+    case DATA_FORMAT7:
+      // SP, SP, #<imm7 * 4>
+      AddOperand (Instruction, ArmOperandRegister, 13);
+      AddOperand (Instruction, ArmOperandRegister, 13);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode & 0x7f) << 2);
+      break;
+    case DATA_FORMAT8:
+      // <Rdn>, <Rm> with high registers
+      AddOperand (Instruction, ArmOperandRegister, Rd | (((OpCode & BIT7) != 0) ? 8 : 0));
+      AddOperand (Instruction, ArmOperandRegister, (OpCode >> 3) & 0xf);
+      break;
+    case CPS_FORMAT:
+      // im:A:I:F
+      AddOperand (Instruction, ArmOperandImmediate, OpCode & 0x17);
+      break;
+    case ENDIAN_FORMAT:
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode >> 3) & 1);
+      break;
+    case DATA_CBZ:
+      // <Rn>, <label>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandAddress, Pc + 4 + (((OpCode >> 2) & 0x3e) | (((OpCode & BIT9) != 0) ? BIT6 : 0)));
+      break;
+    case IT_BLOCK:
+      // <firstcond>, mask
+      Instruction->Condition = (UINT8)((OpCode >> 4) & 0xf);
+      AddOperand (Instruction, ArmOperandImmediate, OpCode & 0xf);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+  Decode the operands of a 32-bit Thumb2 instruction.
+
+  @param  OpCode32      The instruction, first halfword in bits [31:16].
+  @param  AddressMode   The address mode of the matching table entry.
+  @param  Pc            The address of the instruction.
+  @param  Instruction   The decoded instruction.
+
+**/
+STATIC
+VOID
+DecodeThumb2Operands (
+  IN     UINT32                   OpCode32,
+  IN     UINT32                   AddressMode,
+  IN     UINT32                   Pc,
+  IN OUT ARM_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT32   Rd, Rn, Rm, Rt, Rt2;
+  UINT32   Imm12, Imm8, Shift;
+  UINT32   Target, LsBit, MsBit;
+  BOOLEAN  Sign, I1, I2;
+
+  Rt    = (OpCode32 >> 12) & 0xf;
+  Rt2   = (OpCode32 >> 8) & 0xf;
+  Rd    = (OpCode32 >> 8) & 0xf;
+  Rm    = OpCode32 & 0xf;
+  Rn    = (OpCode32 >> 16) & 0xf;
+  Imm8  = OpCode32 & 0xff;
+  Imm12 = Imm8 | ((OpCode32 >> 4) & 0x700) | (((OpCode32 & BIT26) != 0) ? BIT11 : 0);
+  Shift = ((OpCode32 >> 6) & 3) | ((OpCode32 >> 10) & 0x1c);
+  Sign  = (OpCode32 & BIT26) != 0;
+  I1    = ((OpCode32 & BIT13) != 0) == Sign;
+  I2    = ((OpCode32 & BIT11) != 0) == Sign;
+
+  switch (AddressMode) {
+    case B_T3:
+      // S:J2:J1:imm6:imm11:0
+      Instruction->Condition = (UINT8)((OpCode32 >> 22) & 0xf);
+      Target                 = ((OpCode32 << 1) & 0xffe) | ((OpCode32 >> 4) & 0x3f000);
+      Target                |= ((OpCode32 & BIT11) != 0) ? BIT19 : 0;
+      Target                |= ((OpCode32 & BIT13) != 0) ? BIT18 : 0;
+      Target                |= Sign ? BIT20 : 0;
+      AddOperand (Instruction, ArmOperandAddress, Pc + 4 + SignExtend32 (Target, BIT20));
+      break;
+    case B_T4:
+      // S:I1:I2:imm10:imm11:0
+      Target  = ((OpCode32 << 1) & 0xffe) | ((OpCode32 >> 4) & 0x3ff000);
+      Target |= I2 ? BIT22 : 0;
+      Target |= I1 ? BIT23 : 0;
+      Target |= Sign ? BIT24 : 0;
+      AddOperand (Instruction, ArmOperandAddress, Pc + 4 + SignExtend32 (Target, BIT24));
+      break;
+    case BL_T2:
+      // S:I1:I2:imm10H:imm10L:00
+      Target  = ((OpCode32 << 1) & 0xffc) | ((OpCode32 >> 4) & 0x3ff000);
+      Target |= I2 ? BIT22 : 0;
+      Target |= I1 ? BIT23 : 0;
+      Target |= Sign ? BIT24 : 0;
+      AddOperand (Instruction, ArmOperandAddress, PcAlign4 (Pc) + SignExtend32 (Target, BIT24));
+      break;
+    case POP_T2:
+      AddOperand (Instruction, ArmOperandRegisterList, OpCode32 & 0xffff);
+      break;
+    case POP_T3:
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      break;
+    case STM_FORMAT:
+      // <Rn>{!}, <registers>
+      Instruction->WriteBack = (OpCode32 & BIT21) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandRegisterList, OpCode32 & 0xffff);
+      break;
+    case LDM_REG_IMM12_SIGNED:
+      // <Rt>, <label>
+      Target = OpCode32 & 0xfff;
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandAddress, PcAlign4 (Pc) + (((OpCode32 & BIT23) != 0) ? Target : -Target));
+      break;
+    case LDM_REG_INDIRECT_LSL:
+      // <Rt>, [<Rn>, <Rm> {, LSL #<imm2>}]
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 4) & 3);
+      break;
+    case LDM_REG_IMM12:
+      // <Rt>, [<Rn>, #<imm12>]
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, OpCode32 & 0xfff);
+      break;
+    case LDM_REG_IMM8:
+      // <Rt>, [<Rn>, #+/-<imm8>]{!} or <Rt>, [<Rn>], #+/-<imm8>
+      Instruction->WriteBack = (OpCode32 & BIT8) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, ((OpCode32 & BIT9) != 0) ? Imm8 : -Imm8);
+      break;
+    case LDRD_REG_IMM8_SIGNED:
+      // <Rt>, <Rt2>, [<Rn>, #+/-<imm8 * 4>]{!}
+      Instruction->WriteBack = (OpCode32 & BIT21) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rt2);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, ((OpCode32 & BIT23) != 0) ? Imm8 << 2 : -(Imm8 << 2));
+      break;
+    case LDRD_REG_IMM8:
+      // <Rt>, <Rt2>, <label>
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rt2);
+      AddOperand (Instruction, ArmOperandAddress, PcAlign4 (Pc) + (((OpCode32 & BIT23) != 0) ? Imm8 << 2 : -(Imm8 << 2)));
+      break;
+    case LDREXB:
+      // <Rt>, [<Rn>]
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      break;
+    case LDREXD:
+      // <Rt>, <Rt2>, [<Rn>]
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rt2);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      break;
+    case SRS_FORMAT:
+      // SP{!}, #<mode>
+      Instruction->WriteBack = (OpCode32 & BIT21) != 0;
+      AddOperand (Instruction, ArmOperandRegister, 13);
+      AddOperand (Instruction, ArmOperandImmediate, OpCode32 & 0x1f);
+      break;
+    case RFE_FORMAT:
+      // <Rn>{!}
+      Instruction->WriteBack = (OpCode32 & BIT21) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      break;
+    case ADD_IMM12:
+      // <Rd>, <Rn>, #<const>, a plain imm12 for ADDW
+      Instruction->SetFlags = (OpCode32 & BIT20) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, ((OpCode32 & BIT25) != 0) ? Imm12 : ThumbExpandImm (Imm12));
+      break;
+    case ADD_IMM12_1REG:
+      // <Rd>, #<const>
+      Instruction->SetFlags = (OpCode32 & BIT20) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandImmediate, ThumbExpandImm (Imm12));
+      break;
+    case THUMB2_IMM16:
+      // <Rd>, #<imm4:i:imm3:imm8>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandImmediate, Imm12 | ((OpCode32 >> 4) & 0xf000));
+      break;
+    case ADD_IMM5:
+      // <Rd>, <Rn>, <Rm>, #<type>, #<imm5>
+      Instruction->SetFlags = (OpCode32 & BIT20) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 4) & 3);
+      AddOperand (Instruction, ArmOperandImmediate, Shift);
+      break;
+    case ADD_IMM5_2REG:
+      // <Rn>, <Rm>, #<type>, #<imm5>
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 4) & 3);
+      AddOperand (Instruction, ArmOperandImmediate, Shift);
+      break;
+    case ASR_IMM5:
+      // <Rd>, <Rm>, #<imm5>
+      Instruction->SetFlags = (OpCode32 & BIT20) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      AddOperand (Instruction, ArmOperandImmediate, Shift);
+      break;
+    case ASR_3REG:
+      // <Rd>, <Rn>, <Rm>
+      Instruction->SetFlags = (OpCode32 & BIT20) != 0;
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      break;
+    case ADR_THUMB2:
+      // <Rd>, <label>, subtracting when bits 23 and 21 are set
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      if ((OpCode32 & (BIT23 | BIT21)) == (BIT23 | BIT21)) {
+        AddOperand (Instruction, ArmOperandAddress, PcAlign4 (Pc) - Imm12);
+      } else {
+        AddOperand (Instruction, ArmOperandAddress, PcAlign4 (Pc) + Imm12);
+      }
+
+      break;
+    case CMN_THUMB2:
+      // <Rn>, #<const>
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandImmediate, ThumbExpandImm (Imm12));
+      break;
+    case BFC_THUMB2:
+      // <Rd>{, <Rn>}, #<lsb>, #<width>, BFC being BFI with Rn == PC
+      MsBit = OpCode32 & 0x1f;
+      LsBit = Shift;
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      if (((OpCode32 >> 20) & 0x3f) == 0x36) {
+        // BFI and BFC encode the msb
+        if (Rn != 0xf) {
+          AddOperand (Instruction, ArmOperandRegister, Rn);
+        }
+
+        AddOperand (Instruction, ArmOperandImmediate, LsBit);
+        AddOperand (Instruction, ArmOperandImmediate, MsBit - LsBit + 1);
+      } else {
+        // SBFX and UBFX encode the width minus 1
+        AddOperand (Instruction, ArmOperandRegister, Rn);
+        AddOperand (Instruction, ArmOperandImmediate, LsBit);
+        AddOperand (Instruction, ArmOperandImmediate, MsBit + 1);
+      }
+
+      break;
+    case CPD_THUMB2:
+      // <coproc>, #<opc1>, <CRd>, <CRn>, <CRm>, #<opc2>
+      AddOperand (Instruction, ArmOperandCoprocessor, (OpCode32 >> 8) & 0xf);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 20) & 0xf);
+      AddOperand (Instruction, ArmOperandCoprocessorRegister, Rt);
+      AddOperand (Instruction, ArmOperandCoprocessorRegister, Rn);
+      AddOperand (Instruction, ArmOperandCoprocessorRegister, Rm);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 5) & 0x7);
+      break;
+    case MRC_THUMB2:
+      // <coproc>, #<opc1>, <Rt>, <CRn>, <CRm>, #<opc2>
+      AddOperand (Instruction, ArmOperandCoprocessor, (OpCode32 >> 8) & 0xf);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 21) & 0x7);
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandCoprocessorRegister, Rn);
+      AddOperand (Instruction, ArmOperandCoprocessorRegister, Rm);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 5) & 0x7);
+      break;
+    case MRRC_THUMB2:
+      // <coproc>, #<opc1>, <Rt>, <Rt2>, <CRm>
+      AddOperand (Instruction, ArmOperandCoprocessor, (OpCode32 >> 8) & 0xf);
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 4) & 0xf);
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandCoprocessorRegister, Rm);
+      break;
+    case THUMB2_2REGS:
+      // <Rd>, <Rm>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      break;
+    case THUMB2_4REGS:
+      // <Rd>, <Rn>, <Rm>, <Ra>
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      AddOperand (Instruction, ArmOperandRegister, Rm);
+      AddOperand (Instruction, ArmOperandRegister, Rt);
+      break;
+    case THUMB2_MRS:
+      // <Rd>, CPSR
+      AddOperand (Instruction, ArmOperandRegister, Rd);
+      break;
+    case THUMB2_MSR:
+      // CPSR_<fields>, <Rn>
+      AddOperand (Instruction, ArmOperandImmediate, (OpCode32 >> 8) & 0xf);
+      AddOperand (Instruction, ArmOperandRegister, Rn);
+      break;
+    case THUMB2_NO_ARGS:
+    default:
+      break;
+  }
+}
+
+/**
+  Decode the Thumb instruction at OpCodePtr.
+
+  @param  OpCodePtr     Pointer to the instruction to decode.
+  @param  Instruction   The decoded instruction.
+
+  @retval RETURN_SUCCESS      The instruction was decoded.
+  @retval RETURN_NOT_FOUND    The instruction is not known.
+
+**/
+STATIC
+RETURN_STATUS
+DecodeThumbInstruction (
+  IN  CONST UINT16             *OpCodePtr,
+  OUT ARM_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  UINT16        OpCode;
+  UINT32        OpCode32;
+  UINT32        Pc;
+  UINTN         Slot;
+  UINTN         Index;
+  THUMB_BUCKET  *Bucket;
+
+  InitializeThumbBuckets ();
+
+  Instruction->Mnemonic     = NULL;
+  Instruction->Condition    = ARM_CONDITION_ALWAYS;
+  Instruction->SetFlags     = FALSE;
+  Instruction->WriteBack    = FALSE;
+  Instruction->OperandCount = 0;
+
+  OpCode = *OpCodePtr;
+  Pc     = (UINT32)(UINTN)OpCodePtr;
+
+  //
+  // Halfwords starting with 0b11101, 0b11110 or 0b11111 are the first half of
+  // a 32-bit instruction, no 16-bit entry matches them.
+  //
+  if ((OpCode & 0xf800) < 0xe800) {
+    Instruction->Encoding = OpCode;
+    Instruction->Length   = 2;
+
+    Bucket = THUMB_BUCKET (OpCode);
+    for (Slot = 0; Slot < Bucket->Count; Slot++) {
+      Index = Bucket->Entry[Slot];
+      if ((OpCode & gOpThumb[Index].Mask) == gOpThumb[Index].OpCode) {
+        Instruction->Mnemonic = gOpThumb[Index].Start;
+        DecodeThumbOperands (OpCode, gOpThumb[Index].AddressMode, Pc, Instruction);
+        return RETURN_SUCCESS;
+      }
+    }
+
+    return RETURN_NOT_FOUND;
+  }
+
+  OpCode32              = (((UINT32)OpCode) << 16) | *(OpCodePtr + 1);
+  Instruction->Encoding = OpCode32;
+  Instruction->Length   = 4;
+
+  Bucket = THUMB2_BUCKET (OpCode32);
+  for (Slot = 0; Slot < Bucket->Count; Slot++) {
+    Index = Bucket->Entry[Slot];
+    if ((OpCode32 & gOpThumb2[Index].Mask) == gOpThumb2[Index].OpCode) {
+      Instruction->Mnemonic = gOpThumb2[Index].Start;
+      DecodeThumb2Operands (OpCode32, gOpThumb2[Index].AddressMode, Pc, Instruction);
+      return RETURN_SUCCESS;
+    }
+  }
+
+  return RETURN_NOT_FOUND;
+}
+
 VOID
 DisassembleArmInstruction (
   IN  UINT32   **OpCodePtr,
@@ -1071,3 +1729,41 @@ DisassembleInstruction (
     DisassembleArmInstruction ((UINT32 **)OpCodePtr, Buf, Size, Extended);
   }
 }
+
+/**
+  Decode the instruction at OpCodePtr into its mnemonic and operands, without
+  producing any text.
+
+  Only the Thumb(2) instruction set is decoded, the ARM instruction stream is
+  only disassembled into text.
+
+  @param  OpCodePtr     Pointer to the instruction to decode.
+  @param  Thumb         TRUE for Thumb(2), FALSE for ARM instruction stream
+  @param  Instruction   The decoded instruction. Length and Encoding are set
+                        even if the instruction is not known.
+
+  @retval RETURN_SUCCESS      The instruction was decoded.
+  @retval RETURN_NOT_FOUND    The instruction is not known.
+  @retval RETURN_UNSUPPORTED  Thumb is FALSE.
+
+**/
+RETURN_STATUS
+DecodeInstruction (
+  IN  CONST UINT8              *OpCodePtr,
+  IN  BOOLEAN                  Thumb,
+  OUT ARM_DECODED_INSTRUCTION  *Instruction
+  )
+{
+  if (Thumb) {
+    return DecodeThumbInstruction ((CONST UINT16 *)OpCodePtr, Instruction);
+  }
+
+  Instruction->Mnemonic     = NULL;
+  Instruction->Encoding     = *(CONST UINT32 *)OpCodePtr;
+  Instruction->Length       = 4;
+  Instruction->Condition    = (UINT8)(Instruction->Encoding >> 28);
+  Instruction->SetFlags     = FALSE;
+  Instruction->WriteBack    = FALSE;
+  Instruction->OperandCount = 0;
+  return RETURN_UNSUPPORTED;
+}
@@ -10,9 +10,20 @@
 #include <Uefi.h>
 
 #include <Library/ArmLib.h>
+#include <Library/DebugLib.h>
 
 #include <Chipset/ArmV7.h>
 
+#define ID_MMFR3_SUPERSEC_SHIFT          28
+#define ID_MMFR3_SUPERSEC_MASK           0xf
+#define ID_MMFR3_SUPERSEC_NOT_SUPPORTED  0xf
+
+UINTN
+EFIAPI
+ArmReadIdMmfr3 (
+  VOID
+  );
+
 UINT32
 ConvertSectionAttributesToPageAttributes (
   IN UINT32   SectionAttributes,
@@ -30,3 +41,84 @@ ConvertSectionAttributesToPageAttributes (
 
   return PageAttributes;
 }
+
+/**
+  Check whether the MMU implements supersections.
+
+  @retval TRUE    Supersections may be used.
+  @retval FALSE   ID_MMFR3.Supersec reports that supersections are not
+                  supported, so 1MB sections must be used instead.
+
+**/
+BOOLEAN
+ArmMmuSupersectionsSupported (
+  VOID
+  )
+{
+  return ((ArmReadIdMmfr3 () >> ID_MMFR3_SUPERSEC_SHIFT) & ID_MMFR3_SUPERSEC_MASK) !=
+         ID_MMFR3_SUPERSEC_NOT_SUPPORTED;
+}
+
+/**
+  Replace a supersection by the 16 sections it is made of, with the same
+  attributes.
+
+  @param[in]  SectionEntry  Any of the first level entries of the supersection.
+
+**/
+VOID
+ConvertSupersectionToSections (
+  IN volatile ARM_FIRST_LEVEL_DESCRIPTOR  *SectionEntry
+  )
+{
+  UINT32  SectionDescriptor;
+  UINT32  BaseAddress;
+  UINT32  Index;
+
+  // The first level table is 16KB aligned, so the entries of a supersection
+  // start on a 64 byte boundary
+  SectionEntry = (volatile ARM_FIRST_LEVEL_DESCRIPTOR *)((UINTN)SectionEntry &
+                                                         ~(TT_DESCRIPTOR_SUPERSECTION_COUNT * sizeof (*SectionEntry) - 1));
+
+  ASSERT (TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION (SectionEntry[0]));
+
+  BaseAddress       = TT_DESCRIPTOR_SUPERSECTION_BASE_ADDRESS (SectionEntry[0]);
+  SectionDescriptor = TT_DESCRIPTOR_CONVERT_SUPERSECTION_TO_SECTION (SectionEntry[0]);
+
+  for (Index = 0; Index < TT_DESCRIPTOR_SUPERSECTION_COUNT; Index++) {
+    SectionEntry[Index] = TT_DESCRIPTOR_SECTION_BASE_ADDRESS (BaseAddress + (Index << TT_DESCRIPTOR_SECTION_BASE_SHIFT)) |
+                          SectionDescriptor;
+  }
+}
+
+/**
+  Replace a large page by the 16 small pages it is made of, with the same
+  attributes.
+
+  @param[in]  PageEntry   Any of the second level entries of the large page.
+
+**/
+VOID
+ConvertLargePageToPages (
+  IN volatile ARM_PAGE_TABLE_ENTRY  *PageEntry
+  )
+{
+  UINT32  PageDescriptor;
+  UINT32  BaseAddress;
+  UINT32  Index;
+
+  // Second level tables are 1KB aligned, so the entries of a large page
+  // start on a 64 byte boundary
+  PageEntry = (volatile ARM_PAGE_TABLE_ENTRY *)((UINTN)PageEntry &
+                                                ~(TT_DESCRIPTOR_LARGEPAGE_COUNT * sizeof (*PageEntry) - 1));
+
+  ASSERT (TT_DESCRIPTOR_PAGE_TYPE_IS_LARGEPAGE (PageEntry[0]));
+
+  BaseAddress    = TT_DESCRIPTOR_LARGEPAGE_BASE_ADDRESS (PageEntry[0]);
+  PageDescriptor = TT_DESCRIPTOR_CONVERT_LARGEPAGE_TO_PAGE (PageEntry[0]);
+
+  for (Index = 0; Index < TT_DESCRIPTOR_LARGEPAGE_COUNT; Index++) {
+    PageEntry[Index] = TT_DESCRIPTOR_PAGE_BASE_ADDRESS (BaseAddress + (Index << TT_DESCRIPTOR_PAGE_BASE_SHIFT)) |
+                       PageDescriptor;
+  }
+}
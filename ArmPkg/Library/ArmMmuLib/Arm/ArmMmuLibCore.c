@@ -80,6 +80,28 @@ PreferNonshareableMemory (
   return Val != ID_MMFR0_SHR_IMP_HW_COHERENT;
 }
 
+STATIC
+VOID
+SplitSupersection (
+  IN UINT32  *SectionEntry
+  )
+{
+  UINT32  *FirstEntry;
+
+  FirstEntry = (UINT32 *)((UINTN)SectionEntry &
+                          ~(TT_DESCRIPTOR_SUPERSECTION_COUNT * sizeof (*SectionEntry) - 1));
+
+  ConvertSupersectionToSections (FirstEntry);
+
+  //
+  // Issue a DMB to ensure that the page table entry updates made it to
+  // memory before we issue the invalidate, otherwise, a subsequent
+  // speculative fetch could observe the old values.
+  //
+  ArmDataMemoryBarrier ();
+  InvalidateDataCacheRange (FirstEntry, TT_DESCRIPTOR_SUPERSECTION_COUNT * sizeof (*SectionEntry));
+}
+
 STATIC
 VOID
 PopulateLevel2PageTable (
@@ -92,11 +114,15 @@ PopulateLevel2PageTable (
   UINT32  *PageEntry;
   UINT32  Pages;
   UINT32  Index;
+  UINT32  Count;
   UINT32  PageAttributes;
+  UINT32  LargePageAttributes;
   UINT32  SectionDescriptor;
   UINT32  TranslationTable;
   UINT32  BaseSectionAddress;
   UINT32  FirstPageOffset;
+  UINT32  FirstEntry;
+  UINT32  LastEntry;
 
   switch (Attributes) {
     case ARM_MEMORY_REGION_ATTRIBUTE_WRITE_BACK:
@@ -129,9 +155,17 @@ PopulateLevel2PageTable (
     PageAttributes &= ~TT_DESCRIPTOR_PAGE_S_SHARED;
   }
 
+  LargePageAttributes = TT_DESCRIPTOR_CONVERT_PAGE_TO_LARGEPAGE (PageAttributes);
+
   // Check if the Section Entry has already been populated. Otherwise attach a
   // Level 2 Translation Table to it
   if (*SectionEntry != 0) {
+    if (TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION (*SectionEntry)) {
+      // Case where a virtual memory map descriptor overlapped a supersection
+      // entry: only the section holding the pages is turned into a page table
+      SplitSupersection (SectionEntry);
+    }
+
     // The entry must be a page table. Otherwise it exists an overlapping in the memory map
     if (TT_DESCRIPTOR_SECTION_TYPE_IS_PAGE_TABLE (*SectionEntry)) {
       TranslationTable = *SectionEntry & TT_DESCRIPTOR_SECTION_PAGETABLE_ADDRESS_MASK;
@@ -144,8 +178,8 @@ PopulateLevel2PageTable (
                                   TRANSLATION_TABLE_PAGE_ALIGNMENT
                                   );
 
-      // Translate the Section Descriptor into Page Descriptor
-      SectionDescriptor = TT_DESCRIPTOR_PAGE_TYPE_PAGE | ConvertSectionAttributesToPageAttributes (*SectionEntry, FALSE);
+      // Translate the Section Descriptor into Large Page Descriptor
+      SectionDescriptor = TT_DESCRIPTOR_PAGE_TYPE_LARGEPAGE | ConvertSectionAttributesToPageAttributes (*SectionEntry, TRUE);
 
       BaseSectionAddress = TT_DESCRIPTOR_SECTION_BASE_ADDRESS (*SectionEntry);
 
@@ -158,10 +192,11 @@ PopulateLevel2PageTable (
         TRANSLATION_TABLE_PAGE_SIZE
         );
 
-      // Populate the new Level2 Page Table for the section
+      // Populate the new Level2 Page Table for the section with large pages,
+      // which are split below where the new mapping only covers part of them
       PageEntry = (UINT32 *)TranslationTable;
       for (Index = 0; Index < TRANSLATION_TABLE_PAGE_COUNT; Index++) {
-        PageEntry[Index] = TT_DESCRIPTOR_PAGE_BASE_ADDRESS (BaseSectionAddress + (Index << 12)) | SectionDescriptor;
+        PageEntry[Index] = TT_DESCRIPTOR_LARGEPAGE_BASE_ADDRESS (BaseSectionAddress + (Index << 12)) | SectionDescriptor;
       }
 
       // Overwrite the section entry to point to the new Level2 Translation Table
@@ -169,7 +204,7 @@ PopulateLevel2PageTable (
                       (IS_ARM_MEMORY_REGION_ATTRIBUTES_SECURE (Attributes) ? (1 << 3) : 0) |
                       TT_DESCRIPTOR_SECTION_TYPE_PAGE_TABLE;
     } else {
-      // We do not support the other section type (16MB Section)
+      // Unknown section type
       ASSERT (0);
       return;
     }
@@ -199,19 +234,41 @@ PopulateLevel2PageTable (
 
   ASSERT (FirstPageOffset + Pages <= TRANSLATION_TABLE_PAGE_COUNT);
 
-  for (Index = 0; Index < Pages; Index++) {
-    *PageEntry++  =  TT_DESCRIPTOR_PAGE_BASE_ADDRESS (PhysicalBase) | PageAttributes;
-    PhysicalBase += TT_DESCRIPTOR_PAGE_SIZE;
+  for (Index = 0; Index < Pages; Index += Count) {
+    if ((PhysicalBase % TT_DESCRIPTOR_LARGEPAGE_SIZE == 0) &&
+        (Pages - Index >= TT_DESCRIPTOR_LARGEPAGE_COUNT))
+    {
+      // Case: Physical address aligned on the Large Page Size (64KB) && the
+      // length is greater than the Large Page Size
+      for (Count = 0; Count < TT_DESCRIPTOR_LARGEPAGE_COUNT; Count++) {
+        *PageEntry++ = TT_DESCRIPTOR_LARGEPAGE_BASE_ADDRESS (PhysicalBase) | LargePageAttributes;
+      }
+    } else {
+      // A small page can only replace part of a large page once the large
+      // page has been split
+      if (TT_DESCRIPTOR_PAGE_TYPE_IS_LARGEPAGE (*PageEntry)) {
+        ConvertLargePageToPages (PageEntry);
+      }
+
+      *PageEntry++ = TT_DESCRIPTOR_PAGE_BASE_ADDRESS (PhysicalBase) | PageAttributes;
+      Count        = 1;
+    }
+
+    PhysicalBase += Count * TT_DESCRIPTOR_PAGE_SIZE;
   }
 
   //
   // Invalidate again to ensure that any line fetches that may have occurred
-  // [speculatively] since the previous invalidate are evicted again.
+  // [speculatively] since the previous invalidate are evicted again. Include
+  // the whole of the large pages split at either end of the range.
   //
+  FirstEntry = FirstPageOffset & ~(TT_DESCRIPTOR_LARGEPAGE_COUNT - 1);
+  LastEntry  = ALIGN_VALUE (FirstPageOffset + Pages, TT_DESCRIPTOR_LARGEPAGE_COUNT);
+
   ArmDataMemoryBarrier ();
   InvalidateDataCacheRange (
-    (UINT32 *)TranslationTable + FirstPageOffset,
-    RemainLength / TT_DESCRIPTOR_PAGE_SIZE * sizeof (*PageEntry)
+    (UINT32 *)TranslationTable + FirstEntry,
+    (LastEntry - FirstEntry) * sizeof (*PageEntry)
     );
 }
 
@@ -219,14 +276,17 @@ STATIC
 VOID
 FillTranslationTable (
   IN  UINT32                        *TranslationTable,
-  IN  ARM_MEMORY_REGION_DESCRIPTOR  *MemoryRegion
+  IN  ARM_MEMORY_REGION_DESCRIPTOR  *MemoryRegion,
+  IN  BOOLEAN                       UseSupersections
   )
 {
   UINT32  *SectionEntry;
   UINT32  Attributes;
   UINT32  PhysicalBase;
+  UINT32  VirtualBase;
   UINT64  RemainLength;
   UINT32  PageMapLength;
+  UINT32  Index;
 
   ASSERT (MemoryRegion->Length > 0);
 
@@ -235,6 +295,7 @@ FillTranslationTable (
   }
 
   PhysicalBase = (UINT32)MemoryRegion->PhysicalBase;
+  VirtualBase  = (UINT32)MemoryRegion->VirtualBase;
   RemainLength = MIN (MemoryRegion->Length, SIZE_4GB - PhysicalBase);
 
   switch (MemoryRegion->Attributes) {
@@ -283,11 +344,40 @@ FillTranslationTable (
   SectionEntry = TRANSLATION_TABLE_ENTRY_FOR_VIRTUAL_ADDRESS (TranslationTable, MemoryRegion->VirtualBase);
 
   while (RemainLength != 0) {
-    if ((PhysicalBase % TT_DESCRIPTOR_SECTION_SIZE == 0) &&
-        (RemainLength >= TT_DESCRIPTOR_SECTION_SIZE))
+    if (UseSupersections &&
+        (PhysicalBase % TT_DESCRIPTOR_SUPERSECTION_SIZE == 0) &&
+        (VirtualBase % TT_DESCRIPTOR_SUPERSECTION_SIZE == 0) &&
+        (RemainLength >= TT_DESCRIPTOR_SUPERSECTION_SIZE))
+    {
+      // Case: Physical and virtual addresses aligned on the Supersection Size
+      // (16MB) && the length is greater than the Supersection Size
+      for (Index = 0; Index < TT_DESCRIPTOR_SUPERSECTION_COUNT; Index++) {
+        SectionEntry[Index] = TT_DESCRIPTOR_SUPERSECTION_BASE_ADDRESS (PhysicalBase) |
+                              TT_DESCRIPTOR_CONVERT_SECTION_TO_SUPERSECTION (Attributes);
+      }
+
+      //
+      // Issue a DMB to ensure that the page table entry update made it to
+      // memory before we issue the invalidate, otherwise, a subsequent
+      // speculative fetch could observe the old value.
+      //
+      ArmDataMemoryBarrier ();
+      InvalidateDataCacheRange (SectionEntry, TT_DESCRIPTOR_SUPERSECTION_COUNT * sizeof (*SectionEntry));
+
+      SectionEntry += TT_DESCRIPTOR_SUPERSECTION_COUNT;
+      PhysicalBase += TT_DESCRIPTOR_SUPERSECTION_SIZE;
+      VirtualBase  += TT_DESCRIPTOR_SUPERSECTION_SIZE;
+      RemainLength -= TT_DESCRIPTOR_SUPERSECTION_SIZE;
+    } else if ((PhysicalBase % TT_DESCRIPTOR_SECTION_SIZE == 0) &&
+               (RemainLength >= TT_DESCRIPTOR_SECTION_SIZE))
     {
       // Case: Physical address aligned on the Section Size (1MB) && the length
       // is greater than the Section Size
+      if (TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION (*SectionEntry)) {
+        // The other sections of an overlapped supersection keep its mapping
+        SplitSupersection (SectionEntry);
+      }
+
       *SectionEntry = TT_DESCRIPTOR_SECTION_BASE_ADDRESS (PhysicalBase) | Attributes;
 
       //
@@ -299,6 +389,7 @@ FillTranslationTable (
       ArmInvalidateDataCacheEntryByMVA ((UINTN)SectionEntry++);
 
       PhysicalBase += TT_DESCRIPTOR_SECTION_SIZE;
+      VirtualBase  += TT_DESCRIPTOR_SECTION_SIZE;
       RemainLength -= TT_DESCRIPTOR_SECTION_SIZE;
     } else {
       PageMapLength = MIN (
@@ -331,6 +422,7 @@ FillTranslationTable (
       }
 
       PhysicalBase += PageMapLength;
+      VirtualBase  += PageMapLength;
       RemainLength -= PageMapLength;
     }
   }
@@ -344,8 +436,9 @@ ArmConfigureMmu (
   OUT UINTN                         *TranslationTableSize OPTIONAL
   )
 {
-  VOID    *TranslationTable;
-  UINT32  TTBRAttributes;
+  VOID     *TranslationTable;
+  UINT32   TTBRAttributes;
+  BOOLEAN  UseSupersections;
 
   TranslationTable = AllocateAlignedPages (
                        EFI_SIZE_TO_PAGES (TRANSLATION_TABLE_SECTION_SIZE),
@@ -370,8 +463,10 @@ ArmConfigureMmu (
   InvalidateDataCacheRange (TranslationTable, TRANSLATION_TABLE_SECTION_SIZE);
   ZeroMem (TranslationTable, TRANSLATION_TABLE_SECTION_SIZE);
 
+  UseSupersections = ArmMmuSupersectionsSupported ();
+
   while (MemoryTable->Length != 0) {
-    FillTranslationTable (TranslationTable, MemoryTable);
+    FillTranslationTable (TranslationTable, MemoryTable, UseSupersections);
     MemoryTable++;
   }
 
@@ -42,7 +42,7 @@ ConvertSectionToPages (
   volatile ARM_FIRST_LEVEL_DESCRIPTOR  *FirstLevelTable;
   volatile ARM_PAGE_TABLE_ENTRY        *PageTable;
 
-  DEBUG ((DEBUG_PAGE, "Converting section at 0x%x to pages\n", (UINTN)BaseAddress));
+  DEBUG ((DEBUG_PAGE, "Converting section at 0x%x to large pages\n", (UINTN)BaseAddress));
 
   // Obtain page table base
   FirstLevelTable = (ARM_FIRST_LEVEL_DESCRIPTOR *)ArmGetTTBR0BaseAddress ();
@@ -51,9 +51,9 @@ ConvertSectionToPages (
   FirstLevelIdx = TT_DESCRIPTOR_SECTION_BASE_ADDRESS (BaseAddress) >> TT_DESCRIPTOR_SECTION_BASE_SHIFT;
   ASSERT (FirstLevelIdx < TRANSLATION_TABLE_SECTION_COUNT);
 
-  // Get section attributes and convert to page attributes
+  // Get section attributes and convert to large page attributes
   SectionDescriptor = FirstLevelTable[FirstLevelIdx];
-  PageDescriptor    = TT_DESCRIPTOR_PAGE_TYPE_PAGE | ConvertSectionAttributesToPageAttributes (SectionDescriptor, FALSE);
+  PageDescriptor    = TT_DESCRIPTOR_PAGE_TYPE_LARGEPAGE | ConvertSectionAttributesToPageAttributes (SectionDescriptor, TRUE);
 
   // Allocate a page table for the 4KB entries (we use up a full page even though we only need 1KB)
   PageTable = (volatile ARM_PAGE_TABLE_ENTRY *)AllocatePages (1);
@@ -61,9 +61,10 @@ ConvertSectionToPages (
     return EFI_OUT_OF_RESOURCES;
   }
 
-  // Write the page table entries out
+  // Write the page table entries out. Only the large pages whose attributes
+  // are partially changed are split into small pages later on.
   for (Index = 0; Index < TRANSLATION_TABLE_PAGE_COUNT; Index++) {
-    PageTable[Index] = TT_DESCRIPTOR_PAGE_BASE_ADDRESS (BaseAddress + (Index << 12)) | PageDescriptor;
+    PageTable[Index] = TT_DESCRIPTOR_LARGEPAGE_BASE_ADDRESS (BaseAddress + (Index << 12)) | PageDescriptor;
   }
 
   // Formulate page table entry, Domain=0, NS=0
@@ -87,11 +88,15 @@ UpdatePageEntries (
   EFI_STATUS  Status;
   UINT32      EntryValue;
   UINT32      EntryMask;
+  UINT32      LargePageEntryValue;
+  UINT32      LargePageEntryMask;
   UINT32      FirstLevelIdx;
   UINT32      Offset;
   UINT32      NumPageEntries;
   UINT32      Descriptor;
   UINT32      p;
+  UINT32      Count;
+  UINT32      Index;
   UINT32      PageTableIndex;
   UINT32      PageTableEntry;
   UINT32      CurrentPageTableEntry;
@@ -148,6 +153,11 @@ UpdatePageEntries (
     EntryValue |= TT_DESCRIPTOR_PAGE_AP_RW_RW;
   }
 
+  // Same for large page entries, whose XN bit and TEX field are located
+  // elsewhere
+  LargePageEntryMask  = TT_DESCRIPTOR_CONVERT_PAGE_TO_LARGEPAGE (EntryMask) | TT_DESCRIPTOR_PAGE_TYPE_MASK;
+  LargePageEntryValue = TT_DESCRIPTOR_CONVERT_PAGE_TO_LARGEPAGE (EntryValue);
+
   // Obtain page table base
   FirstLevelTable = (ARM_FIRST_LEVEL_DESCRIPTOR *)ArmGetTTBR0BaseAddress ();
 
@@ -156,7 +166,7 @@ UpdatePageEntries (
 
   // Iterate for the number of 4KB pages to change
   Offset = 0;
-  for (p = 0; p < NumPageEntries; p++) {
+  for (p = 0; p < NumPageEntries; p += Count) {
     // Calculate index into first level translation table for page table value
 
     FirstLevelIdx = TT_DESCRIPTOR_SECTION_BASE_ADDRESS (BaseAddress + Offset) >> TT_DESCRIPTOR_SECTION_BASE_SHIFT;
@@ -165,6 +175,17 @@ UpdatePageEntries (
     // Read the descriptor from the first level page table
     Descriptor = FirstLevelTable[FirstLevelIdx];
 
+    // Does this descriptor need to be converted from supersection to sections?
+    if (TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION (Descriptor)) {
+      ConvertSupersectionToSections (&FirstLevelTable[FirstLevelIdx]);
+
+      // Re-read descriptor
+      Descriptor = FirstLevelTable[FirstLevelIdx];
+      if (FlushTlbs != NULL) {
+        *FlushTlbs = TRUE;
+      }
+    }
+
     // Does this descriptor need to be converted from section entry to 4K pages?
     if (!TT_DESCRIPTOR_SECTION_TYPE_IS_PAGE_TABLE (Descriptor)) {
       Status = ConvertSectionToPages (FirstLevelIdx << TT_DESCRIPTOR_SECTION_BASE_SHIFT);
@@ -189,23 +210,45 @@ UpdatePageEntries (
 
     // Get the entry
     CurrentPageTableEntry = PageTable[PageTableIndex];
+    Count                 = 1;
+
+    if (TT_DESCRIPTOR_PAGE_TYPE_IS_LARGEPAGE (CurrentPageTableEntry)) {
+      if ((PageTableIndex % TT_DESCRIPTOR_LARGEPAGE_COUNT == 0) &&
+          (NumPageEntries - p >= TT_DESCRIPTOR_LARGEPAGE_COUNT))
+      {
+        // The whole large page is changed, so it can be kept
+        Count = TT_DESCRIPTOR_LARGEPAGE_COUNT;
+      } else {
+        ConvertLargePageToPages (&PageTable[PageTableIndex]);
 
-    // Mask off appropriate fields
-    PageTableEntry = CurrentPageTableEntry & ~EntryMask;
+        // Re-read the entry
+        CurrentPageTableEntry = PageTable[PageTableIndex];
+        if (FlushTlbs != NULL) {
+          *FlushTlbs = TRUE;
+        }
+      }
+    }
 
-    // Mask in new attributes and/or permissions
-    PageTableEntry |= EntryValue;
+    if (Count == 1) {
+      // Mask off appropriate fields, and mask in new attributes and/or
+      // permissions
+      PageTableEntry = (CurrentPageTableEntry & ~EntryMask) | EntryValue;
+    } else {
+      PageTableEntry = (CurrentPageTableEntry & ~LargePageEntryMask) | LargePageEntryValue;
+    }
 
     if (CurrentPageTableEntry  != PageTableEntry) {
-      Mva = (VOID *)(UINTN)((((UINTN)FirstLevelIdx) << TT_DESCRIPTOR_SECTION_BASE_SHIFT) + (PageTableIndex << TT_DESCRIPTOR_PAGE_BASE_SHIFT));
-
       // Only need to update if we are changing the entry
-      PageTable[PageTableIndex] = PageTableEntry;
-      ArmUpdateTranslationTableEntry ((VOID *)&PageTable[PageTableIndex], Mva);
+      for (Index = PageTableIndex; Index < PageTableIndex + Count; Index++) {
+        Mva = (VOID *)(UINTN)((((UINTN)FirstLevelIdx) << TT_DESCRIPTOR_SECTION_BASE_SHIFT) + (Index << TT_DESCRIPTOR_PAGE_BASE_SHIFT));
+
+        PageTable[Index] = PageTableEntry;
+        ArmUpdateTranslationTableEntry ((VOID *)&PageTable[Index], Mva);
+      }
     }
 
     Status  = EFI_SUCCESS;
-    Offset += TT_DESCRIPTOR_PAGE_SIZE;
+    Offset += Count * TT_DESCRIPTOR_PAGE_SIZE;
   } // End first level translation table loop
 
   return Status;
@@ -225,10 +268,13 @@ UpdateSectionEntries (
   UINT32                               FirstLevelIdx;
   UINT32                               NumSections;
   UINT32                               i;
+  UINT32                               Count;
+  UINT32                               Index;
   UINT32                               CurrentDescriptor;
   UINT32                               Descriptor;
   VOID                                 *Mva;
   volatile ARM_FIRST_LEVEL_DESCRIPTOR  *FirstLevelTable;
+  BOOLEAN                              UseSupersections;
 
   Status = EFI_SUCCESS;
 
@@ -291,12 +337,45 @@ UpdateSectionEntries (
   // calculate number of 1MB first level entries this applies to
   NumSections = (UINT32)(Length / TT_DESCRIPTOR_SECTION_SIZE);
 
+  // supersections are only kept if the MMU implements them
+  UseSupersections = ArmMmuSupersectionsSupported ();
+
   // iterate through each descriptor
-  for (i = 0; i < NumSections; i++) {
+  for (i = 0; i < NumSections; i += Count) {
     CurrentDescriptor = FirstLevelTable[FirstLevelIdx + i];
+    Count             = 1;
+
+    // is this descriptor part of a supersection that is only partially changed,
+    // or that the MMU does not implement?
+    if (TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION (CurrentDescriptor) &&
+        (!UseSupersections ||
+         ((FirstLevelIdx + i) % TT_DESCRIPTOR_SUPERSECTION_COUNT != 0) ||
+         (NumSections - i < TT_DESCRIPTOR_SUPERSECTION_COUNT)))
+    {
+      // split it so that the other sections keep their attributes
+      ConvertSupersectionToSections (&FirstLevelTable[FirstLevelIdx + i]);
+      CurrentDescriptor = FirstLevelTable[FirstLevelIdx + i];
+    }
 
-    // has this descriptor already been converted to pages?
-    if (TT_DESCRIPTOR_SECTION_TYPE_IS_PAGE_TABLE (CurrentDescriptor)) {
+    if (TT_DESCRIPTOR_SECTION_TYPE_IS_SUPERSECTION (CurrentDescriptor)) {
+      // the whole supersection is changed: update its 16 entries alike
+      Count = TT_DESCRIPTOR_SUPERSECTION_COUNT;
+
+      Descriptor  = CurrentDescriptor & ~EntryMask;
+      Descriptor |= EntryValue | TT_DESCRIPTOR_SECTION_TYPE_SUPERSECTION;
+
+      if (CurrentDescriptor != Descriptor) {
+        for (Index = FirstLevelIdx + i; Index < FirstLevelIdx + i + Count; Index++) {
+          Mva = (VOID *)(UINTN)((UINTN)Index << TT_DESCRIPTOR_SECTION_BASE_SHIFT);
+
+          FirstLevelTable[Index] = Descriptor;
+          ArmUpdateTranslationTableEntry ((VOID *)&FirstLevelTable[Index], Mva);
+        }
+      }
+
+      Status = EFI_SUCCESS;
+    } else if (TT_DESCRIPTOR_SECTION_TYPE_IS_PAGE_TABLE (CurrentDescriptor)) {
+      // this descriptor has already been converted to pages
       // forward this 1MB range to page table function instead
       Status = UpdatePageEntries (
                  (FirstLevelIdx + i) << TT_DESCRIPTOR_SECTION_BASE_SHIFT,
@@ -23,4 +23,8 @@
   mrc    p15, 0, r0, c0, c1, 4     ; Read ID_MMFR0 Register
   bx     lr
 
+ RVCT_ASM_EXPORT ArmReadIdMmfr3
+  mrc    p15, 0, r0, c0, c1, 7     ; Read ID_MMFR3 Register
+  bx     lr
+
   END
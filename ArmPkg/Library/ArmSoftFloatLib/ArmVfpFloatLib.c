@@ -0,0 +1,131 @@
+/** @file
+  AEABI floating-point helper functions that have no VFP instruction.
+
+  The VFP cannot convert between floating-point values and 64-bit integers,
+  so these conversions keep using Berkeley SoftFloat, as in ArmSoftFloatLib.
+  The other helpers are implemented in Arm/ArmVfpFloat.S.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "platform.h"
+#include <softfloat.h>
+
+/*
+ * The AEABI functions use the soft-float calling convention, see
+ * ArmSoftFloatLib.c.
+ */
+typedef uint32_t  aeabi_float_t;
+typedef uint64_t  aeabi_double_t;
+
+static aeabi_float_t
+f32_to_f (
+  float32_t  val
+  )
+{
+  return val.v;
+}
+
+static float32_t
+f32_from_f (
+  aeabi_float_t  val
+  )
+{
+  float32_t  res;
+
+  res.v = val;
+
+  return res;
+}
+
+static aeabi_double_t
+f64_to_d (
+  float64_t  val
+  )
+{
+  return val.v;
+}
+
+static float64_t
+f64_from_d (
+  aeabi_double_t  val
+  )
+{
+  float64_t  res;
+
+  res.v = val;
+
+  return res;
+}
+
+/*
+ * Table 6, Standard floating-point to integer conversions
+ */
+long long
+__aeabi_d2lz (
+  aeabi_double_t  a
+  )
+{
+  return f64_to_i64_r_minMag (f64_from_d (a), false);
+}
+
+unsigned long long
+__aeabi_d2ulz (
+  aeabi_double_t  a
+  )
+{
+  return f64_to_ui64_r_minMag (f64_from_d (a), false);
+}
+
+long long
+__aeabi_f2lz (
+  aeabi_float_t  a
+  )
+{
+  return f32_to_i64_r_minMag (f32_from_f (a), false);
+}
+
+unsigned long long
+__aeabi_f2ulz (
+  aeabi_float_t  a
+  )
+{
+  return f32_to_ui64_r_minMag (f32_from_f (a), false);
+}
+
+/*
+ * Table 8, Standard integer to floating-point conversions
+ */
+aeabi_double_t
+__aeabi_l2d (
+  long long  a
+  )
+{
+  return f64_to_d (i64_to_f64 (a));
+}
+
+aeabi_double_t
+__aeabi_ul2d (
+  unsigned long long  a
+  )
+{
+  return f64_to_d (ui64_to_f64 (a));
+}
+
+aeabi_float_t
+__aeabi_l2f (
+  long long  a
+  )
+{
+  return f32_to_f (i64_to_f32 (a));
+}
+
+aeabi_float_t
+__aeabi_ul2f (
+  unsigned long long  a
+  )
+{
+  return f32_to_f (ui64_to_f32 (a));
+}
@@ -12,12 +12,16 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/DebugAgentLib.h>
+#include <Library/FvFileIndexLib.h>
 #include <Library/PcdLib.h>
 #include <Library/PeCoffExtraActionLib.h>
 #include <Library/PeCoffLib.h>
 
-#include <Pi/PiFirmwareFile.h>
-#include <Pi/PiFirmwareVolume.h>
+//
+// Number of files of a firmware volume indexed on the stack. The files past
+// them are found by walking the rest of the firmware volume.
+//
+#define FV_FILE_INDEX_SIZE  32
 
 #define GET_OCCUPIED_SIZE(ActualSize, Alignment) \
   (ActualSize) + (((Alignment) - ((ActualSize) & ((Alignment) - 1))) & ((Alignment) - 1))
@@ -28,141 +32,6 @@ DebugAgentVectorTable (
   VOID
   );
 
-/**
-  Returns the highest bit set of the State field
-
-  @param ErasePolarity   Erase Polarity  as defined by EFI_FVB2_ERASE_POLARITY
-                         in the Attributes field.
-  @param FfsHeader       Pointer to FFS File Header
-
-
-  @retval the highest bit in the State field
-
-**/
-STATIC
-EFI_FFS_FILE_STATE
-GetFileState (
-  IN UINT8                ErasePolarity,
-  IN EFI_FFS_FILE_HEADER  *FfsHeader
-  )
-{
-  EFI_FFS_FILE_STATE  FileState;
-  EFI_FFS_FILE_STATE  HighestBit;
-
-  FileState = FfsHeader->State;
-
-  if (ErasePolarity != 0) {
-    FileState = (EFI_FFS_FILE_STATE) ~FileState;
-  }
-
-  HighestBit = 0x80;
-  while (HighestBit != 0 && (HighestBit & FileState) == 0) {
-    HighestBit >>= 1;
-  }
-
-  return HighestBit;
-}
-
-/**
-  Calculates the checksum of the header of a file.
-  The header is a zero byte checksum, so zero means header is good
-
-  @param FfsHeader       Pointer to FFS File Header
-
-  @retval Checksum of the header
-
-**/
-STATIC
-UINT8
-CalculateHeaderChecksum (
-  IN EFI_FFS_FILE_HEADER  *FileHeader
-  )
-{
-  UINT8  Sum;
-
-  // Calculate the sum of the header
-  Sum = CalculateSum8 ((CONST VOID *)FileHeader, sizeof (EFI_FFS_FILE_HEADER));
-
-  // State field (since this indicates the different state of file).
-  Sum = (UINT8)(Sum - FileHeader->State);
-
-  // Checksum field of the file is not part of the header checksum.
-  Sum = (UINT8)(Sum - FileHeader->IntegrityCheck.Checksum.File);
-
-  return Sum;
-}
-
-EFI_STATUS
-GetFfsFile (
-  IN  EFI_FIRMWARE_VOLUME_HEADER  *FwVolHeader,
-  IN  EFI_FV_FILETYPE             FileType,
-  OUT EFI_FFS_FILE_HEADER         **FileHeader
-  )
-{
-  UINT64               FvLength;
-  UINTN                FileOffset;
-  EFI_FFS_FILE_HEADER  *FfsFileHeader;
-  UINT8                ErasePolarity;
-  UINT8                FileState;
-  UINT32               FileLength;
-  UINT32               FileOccupiedSize;
-
-  ASSERT (FwVolHeader->Signature == EFI_FVH_SIGNATURE);
-
-  FvLength      = FwVolHeader->FvLength;
-  FfsFileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *)FwVolHeader + FwVolHeader->HeaderLength);
-  FileOffset    = FwVolHeader->HeaderLength;
-
-  if (FwVolHeader->Attributes & EFI_FVB2_ERASE_POLARITY) {
-    ErasePolarity = 1;
-  } else {
-    ErasePolarity = 0;
-  }
-
-  while (FileOffset < (FvLength - sizeof (EFI_FFS_FILE_HEADER))) {
-    // Get FileState which is the highest bit of the State
-    FileState = GetFileState (ErasePolarity, FfsFileHeader);
-
-    switch (FileState) {
-      case EFI_FILE_HEADER_INVALID:
-        FileOffset   += sizeof (EFI_FFS_FILE_HEADER);
-        FfsFileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *)FfsFileHeader + sizeof (EFI_FFS_FILE_HEADER));
-        break;
-
-      case EFI_FILE_DATA_VALID:
-      case EFI_FILE_MARKED_FOR_UPDATE:
-        if (CalculateHeaderChecksum (FfsFileHeader) != 0) {
-          ASSERT (FALSE);
-          return EFI_NOT_FOUND;
-        }
-
-        if (FfsFileHeader->Type == FileType) {
-          *FileHeader = FfsFileHeader;
-          return EFI_SUCCESS;
-        }
-
-        FileLength       = *(UINT32 *)(FfsFileHeader->Size) & 0x00FFFFFF;
-        FileOccupiedSize = GET_OCCUPIED_SIZE (FileLength, 8);
-
-        FileOffset   += FileOccupiedSize;
-        FfsFileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *)FfsFileHeader + FileOccupiedSize);
-        break;
-
-      case EFI_FILE_DELETED:
-        FileLength       = *(UINT32 *)(FfsFileHeader->Size) & 0x00FFFFFF;
-        FileOccupiedSize = GET_OCCUPIED_SIZE (FileLength, 8);
-        FileOffset      += FileOccupiedSize;
-        FfsFileHeader    = (EFI_FFS_FILE_HEADER *)((UINT8 *)FfsFileHeader + FileOccupiedSize);
-        break;
-
-      default:
-        return EFI_NOT_FOUND;
-    }
-  }
-
-  return EFI_NOT_FOUND;
-}
-
 EFI_STATUS
 GetImageContext (
   IN  EFI_FFS_FILE_HEADER           *FfsHeader,
@@ -179,24 +48,38 @@ GetImageContext (
   EFI_IMAGE_DEBUG_DIRECTORY_ENTRY  *DebugEntry;
   VOID                             *CodeViewEntryPointer;
 
-  Section      = (EFI_COMMON_SECTION_HEADER *)(FfsHeader + 1);
-  SectionSize  = *(UINT32 *)(FfsHeader->Size) & 0x00FFFFFF;
-  SectionSize -= sizeof (EFI_FFS_FILE_HEADER);
+  //
+  // Files larger than 16 MB use the extended header, whose size field
+  // replaces the 24-bit one.
+  //
+  if (IS_FFS_FILE2 (FfsHeader)) {
+    Section     = (EFI_COMMON_SECTION_HEADER *)((EFI_FFS_FILE_HEADER2 *)FfsHeader + 1);
+    SectionSize = FFS_FILE2_SIZE (FfsHeader) - sizeof (EFI_FFS_FILE_HEADER2);
+  } else {
+    Section     = (EFI_COMMON_SECTION_HEADER *)(FfsHeader + 1);
+    SectionSize = FFS_FILE_SIZE (FfsHeader) - sizeof (EFI_FFS_FILE_HEADER);
+  }
+
   ParsedLength = 0;
   EfiImage     = NULL;
 
   while (ParsedLength < SectionSize) {
     if ((Section->Type == EFI_SECTION_PE32) || (Section->Type == EFI_SECTION_TE)) {
-      EfiImage = (EFI_IMAGE_OPTIONAL_HEADER_UNION *)(Section + 1);
+      if (IS_SECTION2 (Section)) {
+        EfiImage = (EFI_IMAGE_OPTIONAL_HEADER_UNION *)((EFI_COMMON_SECTION_HEADER2 *)Section + 1);
+      } else {
+        EfiImage = (EFI_IMAGE_OPTIONAL_HEADER_UNION *)(Section + 1);
+      }
+
       break;
     }
 
     //
-    // Size is 24 bits wide so mask upper 8 bits.
+    // Sections larger than 16 MB use the extended header as well.
     // SectionLength is adjusted it is 4 byte aligned.
     // Go to the next section
     //
-    SectionLength = *(UINT32 *)Section->Size & 0x00FFFFFF;
+    SectionLength = IS_SECTION2 (Section) ? SECTION2_SIZE (Section) : SECTION_SIZE (Section);
     SectionLength = GET_OCCUPIED_SIZE (SectionLength, 4);
     ASSERT (SectionLength != 0);
     ParsedLength += SectionLength;
@@ -241,6 +124,33 @@ GetImageContext (
   return Status;
 }
 
+/**
+  Report the symbols of the first file of a given type of a firmware volume.
+
+  @param  Index     The index of the firmware volume.
+  @param  FileType  The type of the file.
+
+**/
+STATIC
+VOID
+ReportFileSymbols (
+  IN CONST FV_FILE_INDEX  *Index,
+  IN EFI_FV_FILETYPE      FileType
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_FFS_FILE_HEADER           *FfsHeader;
+  PE_COFF_LOADER_IMAGE_CONTEXT  ImageContext;
+
+  Status = FvFileIndexFindByType (Index, FileType, &FfsHeader);
+  if (!EFI_ERROR (Status)) {
+    Status = GetImageContext (FfsHeader, &ImageContext);
+    if (!EFI_ERROR (Status)) {
+      PeCoffLoaderRelocateImageExtraAction (&ImageContext);
+    }
+  }
+}
+
 /**
   Initialize debug agent.
 
@@ -271,9 +181,9 @@ InitializeDebugAgent (
   IN DEBUG_AGENT_CONTINUE  Function  OPTIONAL
   )
 {
-  EFI_STATUS                    Status;
-  EFI_FFS_FILE_HEADER           *FfsHeader;
-  PE_COFF_LOADER_IMAGE_CONTEXT  ImageContext;
+  EFI_STATUS           Status;
+  FV_FILE_INDEX        Index;
+  FV_FILE_INDEX_ENTRY  Entries[FV_FILE_INDEX_SIZE];
 
   // We use InitFlag to know if DebugAgent has been initialized from
   // Sec (DEBUG_AGENT_INIT_PREMEM_SEC) or PrePi (DEBUG_AGENT_INIT_POSTMEM_SEC)
@@ -282,34 +192,25 @@ InitializeDebugAgent (
     //
     // Get the Sec or PrePeiCore module (defined as SEC type module)
     //
-    Status = GetFfsFile ((EFI_FIRMWARE_VOLUME_HEADER *)(UINTN)PcdGet64 (PcdSecureFvBaseAddress), EFI_FV_FILETYPE_SECURITY_CORE, &FfsHeader);
-    if (!EFI_ERROR (Status)) {
-      Status = GetImageContext (FfsHeader, &ImageContext);
-      if (!EFI_ERROR (Status)) {
-        PeCoffLoaderRelocateImageExtraAction (&ImageContext);
-      }
+    Status = FvFileIndexInitialize ((EFI_FIRMWARE_VOLUME_HEADER *)(UINTN)PcdGet64 (PcdSecureFvBaseAddress), Entries, ARRAY_SIZE (Entries), &Index);
+    if (Status != EFI_INVALID_PARAMETER) {
+      ReportFileSymbols (&Index, EFI_FV_FILETYPE_SECURITY_CORE);
     }
   } else if (InitFlag == DEBUG_AGENT_INIT_POSTMEM_SEC) {
     //
-    // Get the PrePi or PrePeiCore module (defined as SEC type module)
+    // Index the firmware volume once for both lookups
     //
-    Status = GetFfsFile ((EFI_FIRMWARE_VOLUME_HEADER *)(UINTN)PcdGet64 (PcdFvBaseAddress), EFI_FV_FILETYPE_SECURITY_CORE, &FfsHeader);
-    if (!EFI_ERROR (Status)) {
-      Status = GetImageContext (FfsHeader, &ImageContext);
-      if (!EFI_ERROR (Status)) {
-        PeCoffLoaderRelocateImageExtraAction (&ImageContext);
-      }
-    }
-
-    //
-    // Get the PeiCore module (defined as PEI_CORE type module)
-    //
-    Status = GetFfsFile ((EFI_FIRMWARE_VOLUME_HEADER *)(UINTN)PcdGet64 (PcdFvBaseAddress), EFI_FV_FILETYPE_PEI_CORE, &FfsHeader);
-    if (!EFI_ERROR (Status)) {
-      Status = GetImageContext (FfsHeader, &ImageContext);
-      if (!EFI_ERROR (Status)) {
-        PeCoffLoaderRelocateImageExtraAction (&ImageContext);
-      }
+    Status = FvFileIndexInitialize ((EFI_FIRMWARE_VOLUME_HEADER *)(UINTN)PcdGet64 (PcdFvBaseAddress), Entries, ARRAY_SIZE (Entries), &Index);
+    if (Status != EFI_INVALID_PARAMETER) {
+      //
+      // Get the PrePi or PrePeiCore module (defined as SEC type module)
+      //
+      ReportFileSymbols (&Index, EFI_FV_FILETYPE_SECURITY_CORE);
+
+      //
+      // Get the PeiCore module (defined as PEI_CORE type module)
+      //
+      ReportFileSymbols (&Index, EFI_FV_FILETYPE_PEI_CORE);
     }
   }
 }
@@ -15,8 +15,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/PeCoffExtraActionLib.h>
+#include <Library/PeCoffSymbolBatchLib.h>
 #include <Library/PrintLib.h>
 
+//
+// The size of the buffer the DebugLib instances format each message into.
+//
+#define DEBUG_MESSAGE_LENGTH  0x100
+
 /**
   If the build is done on cygwin the paths are cygpaths.
   /cygdrive/c/tmp.txt vs c:\tmp.txt so we need to convert
@@ -41,7 +47,7 @@ DeCygwinPathIfNeeded (
     return Name;
   }
 
-  for (Index = 9, Index2 = 0; (Index < (Size + 9)) && (Ptr[Index] != '\0'); Index++, Index2++) {
+  for (Index = 9, Index2 = 0; (Index2 < (Size - 1)) && (Ptr[Index] != '\0'); Index++, Index2++) {
     Temp[Index2] = Ptr[Index];
     if (Temp[Index2] == '/') {
       Temp[Index2] = '\\';
@@ -53,9 +59,91 @@ DeCygwinPathIfNeeded (
     }
   }
 
+  Temp[Index2] = '\0';
+
   return Temp;
 }
 
+#if !defined (MDEPKG_NDEBUG) && (defined (__CC_ARM) || defined (__GNUC__))
+
+/**
+  Write a block of lines produced by the symbol batch library, in as few
+  debug messages as the message size of DebugLib allows.
+
+  @param[in]  String  The NULL-terminated lines to write.
+
+**/
+STATIC
+VOID
+EFIAPI
+WriteBatchedLines (
+  IN CONST CHAR8  *String
+  )
+{
+  CHAR8  Message[DEBUG_MESSAGE_LENGTH];
+  UINTN  Index;
+  UINTN  Length;
+
+  while (*String != '\0') {
+    //
+    // Take as many complete lines as fit, or cut a line that does not fit
+    // on its own.
+    //
+    Length = 0;
+    for (Index = 0; (String[Index] != '\0') && (Index < sizeof (Message) - 1); Index++) {
+      if (String[Index] == '\n') {
+        Length = Index + 1;
+      }
+    }
+
+    if (Length == 0) {
+      Length = Index;
+    }
+
+    CopyMem (Message, String, Length);
+    Message[Length] = '\0';
+    DEBUG ((DEBUG_LOAD | DEBUG_INFO, "%a", Message));
+
+    String += Length;
+  }
+}
+
+/**
+  Write the debugger command of an image load or unload, through the symbol
+  batch library if it batches records at this point of the boot.
+
+  @param  Command       The NULL-terminated debugger command.
+  @param  Load          TRUE if the image is loaded, FALSE if it is unloaded.
+  @param  ImagePath     The path of the symbol file of the image.
+  @param  ImageAddress  The address the symbols are loaded at.
+
+**/
+STATIC
+VOID
+WriteSymbolCommand (
+  IN  CHAR8             *Command,
+  IN  BOOLEAN           Load,
+  IN  CHAR8             *ImagePath,
+  IN  PHYSICAL_ADDRESS  ImageAddress
+  )
+{
+  RETURN_STATUS  Status;
+
+  Status = PeCoffSymbolBatchRecord (
+             WriteBatchedLines,
+             WriteBatchedLines,
+             Command,
+             Load,
+             ImagePath,
+             ImageAddress
+             );
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_LOAD | DEBUG_INFO, "%a", Command));
+  }
+}
+
+#endif
+
 /**
   Performs additional actions after a PE/COFF image has been loaded and relocated.
 
@@ -73,22 +161,30 @@ PeCoffLoaderRelocateImageExtraAction (
 {
  #if !defined (MDEPKG_NDEBUG)
  #if defined (__CC_ARM) || defined (__GNUC__)
-  CHAR8  Temp[512];
+  CHAR8             Temp[512];
+  CHAR8             Command[DEBUG_MESSAGE_LENGTH];
+  CHAR8             *ImagePath;
+  PHYSICAL_ADDRESS  Address;
  #endif
  #endif
 
   if (ImageContext->PdbPointer) {
+ #if !defined (MDEPKG_NDEBUG) && (defined (__CC_ARM) || defined (__GNUC__))
+    ImagePath = DeCygwinPathIfNeeded (ImageContext->PdbPointer, Temp, sizeof (Temp));
+    Address   = ImageContext->ImageAddress + ImageContext->SizeOfHeaders;
  #ifdef __CC_ARM
  #if (__ARMCC_VERSION < 500000)
     // Print out the command for the RVD debugger to load symbols for this image
-    DEBUG ((DEBUG_LOAD | DEBUG_INFO, "load /a /ni /np %a &0x%p\n", DeCygwinPathIfNeeded (ImageContext->PdbPointer, Temp, sizeof (Temp)), (UINTN)(ImageContext->ImageAddress + ImageContext->SizeOfHeaders)));
+    AsciiSPrint (Command, sizeof (Command), "load /a /ni /np %a &0x%p\n", ImagePath, (UINTN)Address);
  #else
     // Print out the command for the DS-5 to load symbols for this image
-    DEBUG ((DEBUG_LOAD | DEBUG_INFO, "add-symbol-file %a 0x%p\n", DeCygwinPathIfNeeded (ImageContext->PdbPointer, Temp, sizeof (Temp)), (UINTN)(ImageContext->ImageAddress + ImageContext->SizeOfHeaders)));
+    AsciiSPrint (Command, sizeof (Command), "add-symbol-file %a 0x%p\n", ImagePath, (UINTN)Address);
  #endif
- #elif __GNUC__
+ #else
     // This may not work correctly if you generate PE/COFF directly as then the Offset would not be required
-    DEBUG ((DEBUG_LOAD | DEBUG_INFO, "add-symbol-file %a 0x%p\n", DeCygwinPathIfNeeded (ImageContext->PdbPointer, Temp, sizeof (Temp)), (UINTN)(ImageContext->ImageAddress + ImageContext->SizeOfHeaders)));
+    AsciiSPrint (Command, sizeof (Command), "add-symbol-file %a 0x%p\n", ImagePath, (UINTN)Address);
+ #endif
+    WriteSymbolCommand (Command, TRUE, ImagePath, Address);
  #else
     DEBUG ((DEBUG_LOAD | DEBUG_INFO, "Loading driver at 0x%11p EntryPoint=0x%11p\n", (VOID *)(UINTN)ImageContext->ImageAddress, FUNCTION_ENTRY_POINT (ImageContext->EntryPoint)));
  #endif
@@ -115,18 +211,26 @@ PeCoffLoaderUnloadImageExtraAction (
 {
  #if !defined (MDEPKG_NDEBUG)
  #if defined (__CC_ARM) || defined (__GNUC__)
-  CHAR8  Temp[512];
+  CHAR8             Temp[512];
+  CHAR8             Command[DEBUG_MESSAGE_LENGTH];
+  CHAR8             *ImagePath;
+  PHYSICAL_ADDRESS  Address;
  #endif
  #endif
 
   if (ImageContext->PdbPointer) {
+ #if !defined (MDEPKG_NDEBUG) && (defined (__CC_ARM) || defined (__GNUC__))
+    ImagePath = DeCygwinPathIfNeeded (ImageContext->PdbPointer, Temp, sizeof (Temp));
+    Address   = ImageContext->ImageAddress + ImageContext->SizeOfHeaders;
  #ifdef __CC_ARM
     // Print out the command for the RVD debugger to load symbols for this image
-    DEBUG ((DEBUG_LOAD | DEBUG_INFO, "unload symbols_only %a\n", DeCygwinPathIfNeeded (ImageContext->PdbPointer, Temp, sizeof (Temp))));
- #elif __GNUC__
-    // This may not work correctly if you generate PE/COFF directly as then the Offset would not be required
-    DEBUG ((DEBUG_LOAD | DEBUG_INFO, "remove-symbol-file %a 0x%08x\n", DeCygwinPathIfNeeded (ImageContext->PdbPointer, Temp, sizeof (Temp)), (UINTN)(ImageContext->ImageAddress + ImageContext->SizeOfHeaders)));
+    AsciiSPrint (Command, sizeof (Command), "unload symbols_only %a\n", ImagePath);
  #else
+    // This may not work correctly if you generate PE/COFF directly as then the Offset would not be required
+    AsciiSPrint (Command, sizeof (Command), "remove-symbol-file %a 0x%08x\n", ImagePath, (UINTN)Address);
+ #endif
+    WriteSymbolCommand (Command, FALSE, ImagePath, Address);
+ #elif !defined (__CC_ARM) && !defined (__GNUC__)
     DEBUG ((DEBUG_LOAD | DEBUG_INFO, "Unloading %a\n", ImageContext->PdbPointer));
  #endif
   } else {
@@ -0,0 +1,339 @@
+/** @file
+  Batching of the symbol load records of the PE/COFF extra action libraries,
+  for the DXE core.
+
+  The debugger commands and the manifest lines are appended to two buffers of
+  PcdPeCoffSymbolBatchSize bytes each. They are written out when a buffer is
+  full, each time the DXE dispatcher completes a pass, at the end of DXE, on
+  ReadyToBoot and on ExitBootServices. Records produced after
+  ExitBootServices are not batched.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <Guid/EventGroup.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PeCoffSymbolBatchLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+//
+// Long enough for "unload 0x<16 digits> " and the line terminator.
+//
+#define MANIFEST_RECORD_PREFIX_LENGTH  32
+
+typedef struct {
+  CHAR8                         *Buffer;
+  UINTN                         Length;
+  PECOFF_SYMBOL_BATCH_OUTPUT    Output;
+} SYMBOL_BATCH;
+
+STATIC SYMBOL_BATCH  mCommands;
+STATIC SYMBOL_BATCH  mManifest;
+STATIC UINTN         mBatchSize;
+STATIC BOOLEAN       mManifestStarted;
+STATIC BOOLEAN       mInitialized;
+STATIC BOOLEAN       mBypass;
+
+STATIC EFI_GUID  *mFlushEventGroups[] = {
+  &gEfiEventDxeDispatchGuid,
+  &gEfiEndOfDxeEventGroupGuid,
+  &gEfiEventReadyToBootGuid,
+};
+
+/**
+  Write out the pending text of a batch.
+
+  @param[in, out]  Batch  The batch to write out.
+
+**/
+STATIC
+VOID
+FlushBatch (
+  IN OUT SYMBOL_BATCH  *Batch
+  )
+{
+  if ((Batch->Length == 0) || (Batch->Output == NULL)) {
+    return;
+  }
+
+  Batch->Output (Batch->Buffer);
+  Batch->Length    = 0;
+  Batch->Buffer[0] = '\0';
+}
+
+/**
+  Append a string to a batch, writing out the batch first if the string does
+  not fit.
+
+  A string longer than the batch buffer is written out on its own.
+
+  @param[in, out]  Batch   The batch to append to.
+  @param[in]       String  The NULL-terminated string to append.
+
+**/
+STATIC
+VOID
+AppendToBatch (
+  IN OUT SYMBOL_BATCH  *Batch,
+  IN     CONST CHAR8   *String
+  )
+{
+  UINTN  Length;
+
+  if (Batch->Output == NULL) {
+    return;
+  }
+
+  Length = AsciiStrLen (String);
+  if (Batch->Length + Length >= mBatchSize) {
+    FlushBatch (Batch);
+  }
+
+  if (Length >= mBatchSize) {
+    Batch->Output (String);
+    return;
+  }
+
+  CopyMem (&Batch->Buffer[Batch->Length], String, Length + 1);
+  Batch->Length += Length;
+}
+
+/**
+  Write out the pending debugger commands, then the pending manifest lines.
+**/
+STATIC
+VOID
+FlushRecords (
+  VOID
+  )
+{
+  FlushBatch (&mCommands);
+  FlushBatch (&mManifest);
+}
+
+/**
+  Write out the pending records at a boot milestone.
+
+  @param[in]  Event    The event being signaled.
+  @param[in]  Context  Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+OnFlushMilestone (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  FlushRecords ();
+}
+
+/**
+  Write out the pending records, and stop batching, as boot services are
+  about to go away.
+
+  @param[in]  Event    The event being signaled.
+  @param[in]  Context  Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+OnExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  FlushRecords ();
+  mBypass = TRUE;
+}
+
+/**
+  Allocate the batch buffers and register the milestone events.
+
+  @retval EFI_SUCCESS       Records can be batched.
+  @retval EFI_UNSUPPORTED   Batching is disabled by PcdPeCoffSymbolBatchSize.
+  @retval other             The buffers or the events could not be created.
+
+**/
+STATIC
+EFI_STATUS
+InitializeBatches (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   Event;
+  UINTN       Index;
+
+  mBatchSize = FixedPcdGet32 (PcdPeCoffSymbolBatchSize);
+  if (mBatchSize == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  mCommands.Buffer = AllocatePool (mBatchSize);
+  mManifest.Buffer = AllocatePool (mBatchSize);
+  if ((mCommands.Buffer == NULL) || (mManifest.Buffer == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeBuffers;
+  }
+
+  mCommands.Buffer[0] = '\0';
+  mManifest.Buffer[0] = '\0';
+
+  for (Index = 0; Index < ARRAY_SIZE (mFlushEventGroups); Index++) {
+    Status = gBS->CreateEventEx (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    OnFlushMilestone,
+                    NULL,
+                    mFlushEventGroups[Index],
+                    &Event
+                    );
+    if (EFI_ERROR (Status)) {
+      goto FreeBuffers;
+    }
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  OnExitBootServices,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &Event
+                  );
+  if (EFI_ERROR (Status)) {
+    goto FreeBuffers;
+  }
+
+  return EFI_SUCCESS;
+
+FreeBuffers:
+  //
+  // Events created before the failure stay registered, and find nothing to
+  // write out.
+  //
+  if (mCommands.Buffer != NULL) {
+    FreePool (mCommands.Buffer);
+    mCommands.Buffer = NULL;
+  }
+
+  if (mManifest.Buffer != NULL) {
+    FreePool (mManifest.Buffer);
+    mManifest.Buffer = NULL;
+  }
+
+  return Status;
+}
+
+/**
+  Queue the debugger command and the manifest record of an image load or
+  unload.
+
+  The queued records are written when the buffer is full, and at the boot
+  milestones supported by the library instance.
+
+  @param[in]  WriteCommands  Writes a block of debugger commands.
+  @param[in]  WriteManifest  Writes a block of manifest lines. Optional.
+  @param[in]  Command        The NULL-terminated debugger command for the
+                             image, including its line terminator.
+  @param[in]  Load           TRUE if the image is loaded, FALSE if it is
+                             unloaded.
+  @param[in]  ImagePath      The NULL-terminated path of the symbol file of
+                             the image, as the debugger sees it.
+  @param[in]  ImageAddress   The address the symbols are loaded at.
+
+  @retval RETURN_SUCCESS      The record was queued or written.
+  @retval RETURN_UNSUPPORTED  Records are not batched by this library
+                              instance, or not at this point of the boot.
+                              The caller must write the command itself.
+
+**/
+RETURN_STATUS
+EFIAPI
+PeCoffSymbolBatchRecord (
+  IN PECOFF_SYMBOL_BATCH_OUTPUT  WriteCommands,
+  IN PECOFF_SYMBOL_BATCH_OUTPUT  WriteManifest  OPTIONAL,
+  IN CONST CHAR8                 *Command,
+  IN BOOLEAN                     Load,
+  IN CONST CHAR8                 *ImagePath,
+  IN PHYSICAL_ADDRESS            ImageAddress
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+  CHAR8       Prefix[MANIFEST_RECORD_PREFIX_LENGTH];
+
+  ASSERT (WriteCommands != NULL);
+
+  if (!mInitialized) {
+    mInitialized = TRUE;
+    Status       = InitializeBatches ();
+    if (EFI_ERROR (Status)) {
+      DEBUG ((
+        (Status == EFI_UNSUPPORTED) ? DEBUG_VERBOSE : DEBUG_WARN,
+        "%a: symbol records are not batched - %r\n",
+        __func__,
+        Status
+        ));
+      mBypass = TRUE;
+    }
+  }
+
+  if (mBypass) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  //
+  // The milestone events write the batches out at TPL_CALLBACK, so keep them
+  // away while the batches are updated.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  mCommands.Output = WriteCommands;
+  mManifest.Output = WriteManifest;
+
+  AppendToBatch (&mCommands, Command);
+
+  if (mManifest.Output != NULL) {
+    if (!mManifestStarted) {
+      AppendToBatch (&mManifest, PECOFF_SYMBOL_MANIFEST_HEADER);
+      mManifestStarted = TRUE;
+    }
+
+    //
+    // Written in two parts, so that the length of the path is only bounded
+    // by the size of the batch.
+    //
+    AsciiSPrint (
+      Prefix,
+      sizeof (Prefix),
+      "%a 0x%016lx ",
+      Load ? "load" : "unload",
+      ImageAddress
+      );
+    if (mManifest.Length + AsciiStrLen (Prefix) + AsciiStrLen (ImagePath) + 1 >= mBatchSize) {
+      FlushBatch (&mManifest);
+    }
+
+    AppendToBatch (&mManifest, Prefix);
+    AppendToBatch (&mManifest, ImagePath);
+    AppendToBatch (&mManifest, "\n");
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,408 @@
+/** @file
+  Index of the files of a firmware volume.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FvFileIndexLib.h>
+
+#define FV_FILE_INDEX_END  MAX_UINT16
+
+#define TYPE_BUCKET(Type)  ((Type) & (FV_FILE_INDEX_BUCKETS - 1))
+#define NAME_BUCKET(Name)  ((Name)->Data1 & (FV_FILE_INDEX_BUCKETS - 1))
+
+#define GET_OCCUPIED_SIZE(ActualSize, Alignment) \
+  (ActualSize) + (((Alignment) - ((ActualSize) & ((Alignment) - 1))) & ((Alignment) - 1))
+
+/**
+  Returns the highest bit set of the State field
+
+  @param ErasePolarity   Erase Polarity  as defined by EFI_FVB2_ERASE_POLARITY
+                         in the Attributes field.
+  @param FfsHeader       Pointer to FFS File Header
+
+
+  @retval the highest bit in the State field
+
+**/
+STATIC
+EFI_FFS_FILE_STATE
+GetFileState (
+  IN UINT8                ErasePolarity,
+  IN EFI_FFS_FILE_HEADER  *FfsHeader
+  )
+{
+  EFI_FFS_FILE_STATE  FileState;
+  EFI_FFS_FILE_STATE  HighestBit;
+
+  FileState = FfsHeader->State;
+
+  if (ErasePolarity != 0) {
+    FileState = (EFI_FFS_FILE_STATE) ~FileState;
+  }
+
+  HighestBit = 0x80;
+  while (HighestBit != 0 && (HighestBit & FileState) == 0) {
+    HighestBit >>= 1;
+  }
+
+  return HighestBit;
+}
+
+/**
+  Calculates the checksum of the header of a file.
+  The header is a zero byte checksum, so zero means header is good
+
+  @param FfsHeader       Pointer to FFS File Header
+
+  @retval Checksum of the header
+
+**/
+STATIC
+UINT8
+CalculateHeaderChecksum (
+  IN EFI_FFS_FILE_HEADER  *FileHeader
+  )
+{
+  UINT8  Sum;
+
+  // Calculate the sum of the header
+  if (IS_FFS_FILE2 (FileHeader)) {
+    Sum = CalculateSum8 ((CONST VOID *)FileHeader, sizeof (EFI_FFS_FILE_HEADER2));
+  } else {
+    Sum = CalculateSum8 ((CONST VOID *)FileHeader, sizeof (EFI_FFS_FILE_HEADER));
+  }
+
+  // State field (since this indicates the different state of file).
+  Sum = (UINT8)(Sum - FileHeader->State);
+
+  // Checksum field of the file is not part of the header checksum.
+  Sum = (UINT8)(Sum - FileHeader->IntegrityCheck.Checksum.File);
+
+  return Sum;
+}
+
+/**
+  Get the size occupied by a file in the firmware volume, including its
+  header and the padding that aligns the next file.
+
+  @param  FileHeader  The header of the file.
+
+  @return The occupied size of the file.
+
+**/
+STATIC
+UINT32
+GetFileOccupiedSize (
+  IN EFI_FFS_FILE_HEADER  *FileHeader
+  )
+{
+  UINT32  FileLength;
+
+  if (IS_FFS_FILE2 (FileHeader)) {
+    FileLength = FFS_FILE2_SIZE (FileHeader);
+  } else {
+    FileLength = FFS_FILE_SIZE (FileHeader);
+  }
+
+  return GET_OCCUPIED_SIZE (FileLength, 8);
+}
+
+/**
+  Walk the files of a firmware volume, starting at a given offset.
+
+  @param[in]      FwVolHeader   The firmware volume.
+  @param[in, out] FileOffset    On input, the offset of the file to start
+                                from. On output, the offset of the next file
+                                to visit.
+  @param[out]     FileHeader    The header of the next valid file.
+
+  @retval EFI_SUCCESS           A valid file was found.
+  @retval EFI_NOT_FOUND         The end of the firmware volume was reached.
+  @retval EFI_VOLUME_CORRUPTED  The header of a file is invalid.
+
+**/
+STATIC
+EFI_STATUS
+GetNextFile (
+  IN     EFI_FIRMWARE_VOLUME_HEADER  *FwVolHeader,
+  IN OUT UINT32                      *FileOffset,
+  OUT    EFI_FFS_FILE_HEADER         **FileHeader
+  )
+{
+  UINT64               FvLength;
+  EFI_FFS_FILE_HEADER  *FfsFileHeader;
+  UINT8                ErasePolarity;
+  UINT8                FileState;
+
+  FvLength = FwVolHeader->FvLength;
+
+  if (FwVolHeader->Attributes & EFI_FVB2_ERASE_POLARITY) {
+    ErasePolarity = 1;
+  } else {
+    ErasePolarity = 0;
+  }
+
+  while (*FileOffset < (FvLength - sizeof (EFI_FFS_FILE_HEADER))) {
+    FfsFileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *)FwVolHeader + *FileOffset);
+
+    // Get FileState which is the highest bit of the State
+    FileState = GetFileState (ErasePolarity, FfsFileHeader);
+
+    switch (FileState) {
+      case EFI_FILE_HEADER_INVALID:
+        *FileOffset += sizeof (EFI_FFS_FILE_HEADER);
+        break;
+
+      case EFI_FILE_DATA_VALID:
+      case EFI_FILE_MARKED_FOR_UPDATE:
+        if (CalculateHeaderChecksum (FfsFileHeader) != 0) {
+          ASSERT (FALSE);
+          return EFI_VOLUME_CORRUPTED;
+        }
+
+        *FileOffset += GetFileOccupiedSize (FfsFileHeader);
+        *FileHeader  = FfsFileHeader;
+        return EFI_SUCCESS;
+
+      case EFI_FILE_DELETED:
+        *FileOffset += GetFileOccupiedSize (FfsFileHeader);
+        break;
+
+      default:
+        return EFI_NOT_FOUND;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Index the files of a firmware volume.
+
+  Files are indexed until the end of the firmware volume, a file with an
+  invalid header, or the end of the table. If the table is too small, the
+  files that did not fit are still found by the lookup functions, by walking
+  the rest of the firmware volume.
+
+  @param[in]  FwVolHeader   The firmware volume.
+  @param[in]  Entries       The table of the index.
+  @param[in]  MaxCount      The number of entries of the table, at most
+                            MAX_UINT16.
+  @param[out] Index         The index.
+
+  @retval EFI_SUCCESS             Every file of the firmware volume was
+                                  indexed.
+  @retval EFI_BUFFER_TOO_SMALL    The table is too small for every file.
+  @retval EFI_VOLUME_CORRUPTED    The header of a file is invalid. The files
+                                  before it were indexed.
+  @retval EFI_INVALID_PARAMETER   A parameter is NULL, or FwVolHeader is not a
+                                  firmware volume.
+
+**/
+EFI_STATUS
+EFIAPI
+FvFileIndexInitialize (
+  IN  EFI_FIRMWARE_VOLUME_HEADER  *FwVolHeader,
+  IN  FV_FILE_INDEX_ENTRY         *Entries,
+  IN  UINTN                       MaxCount,
+  OUT FV_FILE_INDEX               *Index
+  )
+{
+  EFI_STATUS           Status;
+  EFI_FFS_FILE_HEADER  *FileHeader;
+  UINT32               FileOffset;
+  UINT32               NextOffset;
+  UINT16               TypeTails[FV_FILE_INDEX_BUCKETS];
+  UINT16               NameTails[FV_FILE_INDEX_BUCKETS];
+  UINTN                TypeBucket;
+  UINTN                NameBucket;
+  FV_FILE_INDEX_ENTRY  *Entry;
+
+  if ((FwVolHeader == NULL) || (Index == NULL) ||
+      ((Entries == NULL) && (MaxCount != 0)) ||
+      (MaxCount > MAX_UINT16))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (FwVolHeader->Signature != EFI_FVH_SIGNATURE) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Index->FwVolHeader     = FwVolHeader;
+  Index->Entries         = Entries;
+  Index->MaxCount        = (UINT16)MaxCount;
+  Index->Count           = 0;
+  Index->UnindexedOffset = 0;
+  SetMem16 (Index->TypeHeads, sizeof (Index->TypeHeads), FV_FILE_INDEX_END);
+  SetMem16 (Index->NameHeads, sizeof (Index->NameHeads), FV_FILE_INDEX_END);
+  SetMem16 (TypeTails, sizeof (TypeTails), FV_FILE_INDEX_END);
+  SetMem16 (NameTails, sizeof (NameTails), FV_FILE_INDEX_END);
+
+  NextOffset = FwVolHeader->HeaderLength;
+  for ( ; ;) {
+    FileOffset = NextOffset;
+    Status     = GetNextFile (FwVolHeader, &NextOffset, &FileHeader);
+    if (Status == EFI_NOT_FOUND) {
+      return EFI_SUCCESS;
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (Index->Count == Index->MaxCount) {
+      //
+      // Resume the walk at this file on lookups, so that deleted and
+      // invalid headers are only skipped once, here.
+      //
+      Index->UnindexedOffset = (UINT32)((UINT8 *)FileHeader - (UINT8 *)FwVolHeader);
+      return EFI_BUFFER_TOO_SMALL;
+    }
+
+    Entry             = &Entries[Index->Count];
+    Entry->Offset     = (UINT32)((UINT8 *)FileHeader - (UINT8 *)FwVolHeader);
+    Entry->NextOfType = FV_FILE_INDEX_END;
+    Entry->NextOfName = FV_FILE_INDEX_END;
+
+    TypeBucket = TYPE_BUCKET (FileHeader->Type);
+    if (TypeTails[TypeBucket] == FV_FILE_INDEX_END) {
+      Index->TypeHeads[TypeBucket] = Index->Count;
+    } else {
+      Entries[TypeTails[TypeBucket]].NextOfType = Index->Count;
+    }
+
+    TypeTails[TypeBucket] = Index->Count;
+
+    NameBucket = NAME_BUCKET (&FileHeader->Name);
+    if (NameTails[NameBucket] == FV_FILE_INDEX_END) {
+      Index->NameHeads[NameBucket] = Index->Count;
+    } else {
+      Entries[NameTails[NameBucket]].NextOfName = Index->Count;
+    }
+
+    NameTails[NameBucket] = Index->Count;
+
+    Index->Count++;
+  }
+}
+
+/**
+  Get the header of an indexed file.
+
+  @param  Index   The index.
+  @param  Entry   The index of the entry of the file.
+
+  @return The header of the file.
+
+**/
+STATIC
+EFI_FFS_FILE_HEADER *
+GetIndexedFile (
+  IN CONST FV_FILE_INDEX  *Index,
+  IN UINT16               Entry
+  )
+{
+  return (EFI_FFS_FILE_HEADER *)((UINT8 *)Index->FwVolHeader + Index->Entries[Entry].Offset);
+}
+
+/**
+  Find the first file of a given type.
+
+  @param[in]  Index       The index.
+  @param[in]  FileType    The type of the file.
+  @param[out] FileHeader  The header of the file.
+
+  @retval EFI_SUCCESS     The file was found.
+  @retval EFI_NOT_FOUND   The firmware volume has no file of this type.
+
+**/
+EFI_STATUS
+EFIAPI
+FvFileIndexFindByType (
+  IN  CONST FV_FILE_INDEX  *Index,
+  IN  EFI_FV_FILETYPE      FileType,
+  OUT EFI_FFS_FILE_HEADER  **FileHeader
+  )
+{
+  UINT16               Entry;
+  UINT32               FileOffset;
+  EFI_FFS_FILE_HEADER  *FfsFileHeader;
+
+  for (Entry = Index->TypeHeads[TYPE_BUCKET (FileType)];
+       Entry != FV_FILE_INDEX_END;
+       Entry = Index->Entries[Entry].NextOfType)
+  {
+    FfsFileHeader = GetIndexedFile (Index, Entry);
+    if (FfsFileHeader->Type == FileType) {
+      *FileHeader = FfsFileHeader;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (Index->UnindexedOffset != 0) {
+    FileOffset = Index->UnindexedOffset;
+    while (!EFI_ERROR (GetNextFile (Index->FwVolHeader, &FileOffset, &FfsFileHeader))) {
+      if (FfsFileHeader->Type == FileType) {
+        *FileHeader = FfsFileHeader;
+        return EFI_SUCCESS;
+      }
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Find a file by name.
+
+  @param[in]  Index       The index.
+  @param[in]  Name        The name of the file.
+  @param[out] FileHeader  The header of the file.
+
+  @retval EFI_SUCCESS     The file was found.
+  @retval EFI_NOT_FOUND   The firmware volume has no file of this name.
+
+**/
+EFI_STATUS
+EFIAPI
+FvFileIndexFindByName (
+  IN  CONST FV_FILE_INDEX  *Index,
+  IN  CONST EFI_GUID       *Name,
+  OUT EFI_FFS_FILE_HEADER  **FileHeader
+  )
+{
+  UINT16               Entry;
+  UINT32               FileOffset;
+  EFI_FFS_FILE_HEADER  *FfsFileHeader;
+
+  for (Entry = Index->NameHeads[NAME_BUCKET (Name)];
+       Entry != FV_FILE_INDEX_END;
+       Entry = Index->Entries[Entry].NextOfName)
+  {
+    FfsFileHeader = GetIndexedFile (Index, Entry);
+    if (CompareGuid (&FfsFileHeader->Name, Name)) {
+      *FileHeader = FfsFileHeader;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (Index->UnindexedOffset != 0) {
+    FileOffset = Index->UnindexedOffset;
+    while (!EFI_ERROR (GetNextFile (Index->FwVolHeader, &FileOffset, &FfsFileHeader))) {
+      if (CompareGuid (&FfsFileHeader->Name, Name)) {
+        *FileHeader = FfsFileHeader;
+        return EFI_SUCCESS;
+      }
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
@@ -0,0 +1,44 @@
+/** @file
+  Null instance of the PE/COFF symbol batch library. Records are not batched,
+  and the PE/COFF extra action libraries write each command as it is produced.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+
+#include <Library/PeCoffSymbolBatchLib.h>
+
+/**
+  Queue the debugger command and the manifest record of an image load or
+  unload.
+
+  @param[in]  WriteCommands  Writes a block of debugger commands.
+  @param[in]  WriteManifest  Writes a block of manifest lines. Optional.
+  @param[in]  Command        The NULL-terminated debugger command for the
+                             image, including its line terminator.
+  @param[in]  Load           TRUE if the image is loaded, FALSE if it is
+                             unloaded.
+  @param[in]  ImagePath      The NULL-terminated path of the symbol file of
+                             the image, as the debugger sees it.
+  @param[in]  ImageAddress   The address the symbols are loaded at.
+
+  @retval RETURN_UNSUPPORTED  Records are not batched by this library
+                              instance.
+
+**/
+RETURN_STATUS
+EFIAPI
+PeCoffSymbolBatchRecord (
+  IN PECOFF_SYMBOL_BATCH_OUTPUT  WriteCommands,
+  IN PECOFF_SYMBOL_BATCH_OUTPUT  WriteManifest  OPTIONAL,
+  IN CONST CHAR8                 *Command,
+  IN BOOLEAN                     Load,
+  IN CONST CHAR8                 *ImagePath,
+  IN PHYSICAL_ADDRESS            ImageAddress
+  )
+{
+  return RETURN_UNSUPPORTED;
+}
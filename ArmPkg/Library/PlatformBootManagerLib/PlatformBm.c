@@ -17,6 +17,7 @@
 #include <Library/DevicePathLib.h>
 #include <Library/HobLib.h>
 #include <Library/PcdLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/UefiBootManagerLib.h>
 #include <Library/UefiLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
@@ -123,12 +124,55 @@ STATIC PLATFORM_USB_KEYBOARD  mUsbKeyboard = {
   }
 };
 
+//
+// The device path text of a handle, for reporting purposes. Converting a
+// device path to text allocates memory and walks the device path, so it is
+// only done by GetReportText(), the first time the text is actually needed.
+//
+typedef struct {
+  EFI_HANDLE    Handle;
+  CHAR16        *Text;
+} HANDLE_REPORT;
+
+/**
+  Retrieve the device path text of a handle for reporting purposes, converting
+  the device path on first use.
+
+  This is meant to be called from the arguments of DEBUG(), which are only
+  evaluated if the message is going to be printed.
+
+  @param[in,out] Report  The report context of the handle.
+
+  @return The device path text. It is never NULL.
+**/
+STATIC
+CONST CHAR16 *
+GetReportText (
+  IN OUT HANDLE_REPORT  *Report
+  )
+{
+  STATIC CHAR16  Fallback[] = L"<device path unavailable>";
+
+  if (Report->Text == NULL) {
+    //
+    // The ConvertDevicePathToText() function handles NULL input transparently.
+    //
+    Report->Text = ConvertDevicePathToText (
+                     DevicePathFromHandle (Report->Handle),
+                     FALSE, // DisplayOnly
+                     FALSE  // AllowShortcuts
+                     );
+  }
+
+  return (Report->Text != NULL) ? Report->Text : Fallback;
+}
+
 /**
   Check if the handle satisfies a particular condition.
 
-  @param[in] Handle      The handle to check.
-  @param[in] ReportText  A caller-allocated string passed in for reporting
-                         purposes. It must never be NULL.
+  @param[in] Handle  The handle to check.
+  @param[in] Report  The report context of the handle. Pass it to
+                     GetReportText() to get its device path text.
 
   @retval TRUE   The condition is satisfied.
   @retval FALSE  Otherwise. This includes the case when the condition could not
@@ -137,22 +181,22 @@ STATIC PLATFORM_USB_KEYBOARD  mUsbKeyboard = {
 typedef
 BOOLEAN
 (EFIAPI *FILTER_FUNCTION)(
-  IN EFI_HANDLE   Handle,
-  IN CONST CHAR16 *ReportText
+  IN EFI_HANDLE        Handle,
+  IN OUT HANDLE_REPORT *Report
   );
 
 /**
   Process a handle.
 
-  @param[in] Handle      The handle to process.
-  @param[in] ReportText  A caller-allocated string passed in for reporting
-                         purposes. It must never be NULL.
+  @param[in] Handle  The handle to process.
+  @param[in] Report  The report context of the handle. Pass it to
+                     GetReportText() to get its device path text.
 **/
 typedef
 VOID
 (EFIAPI *CALLBACK_FUNCTION)(
-  IN EFI_HANDLE   Handle,
-  IN CONST CHAR16 *ReportText
+  IN EFI_HANDLE        Handle,
+  IN OUT HANDLE_REPORT *Report
   );
 
 /**
@@ -204,27 +248,17 @@ FilterAndProcess (
 
   ASSERT (NoHandles > 0);
   for (Idx = 0; Idx < NoHandles; ++Idx) {
-    CHAR16         *DevicePathText;
-    STATIC CHAR16  Fallback[] = L"<device path unavailable>";
+    HANDLE_REPORT  Report;
 
-    //
-    // The ConvertDevicePathToText() function handles NULL input transparently.
-    //
-    DevicePathText = ConvertDevicePathToText (
-                       DevicePathFromHandle (Handles[Idx]),
-                       FALSE, // DisplayOnly
-                       FALSE  // AllowShortcuts
-                       );
-    if (DevicePathText == NULL) {
-      DevicePathText = Fallback;
-    }
+    Report.Handle = Handles[Idx];
+    Report.Text   = NULL;
 
-    if ((Filter == NULL) || Filter (Handles[Idx], DevicePathText)) {
-      Process (Handles[Idx], DevicePathText);
+    if ((Filter == NULL) || Filter (Handles[Idx], &Report)) {
+      Process (Handles[Idx], &Report);
     }
 
-    if (DevicePathText != Fallback) {
-      FreePool (DevicePathText);
+    if (Report.Text != NULL) {
+      FreePool (Report.Text);
     }
   }
 
@@ -238,13 +272,13 @@ STATIC
 BOOLEAN
 EFIAPI
 IsPciDisplay (
-  IN EFI_HANDLE    Handle,
-  IN CONST CHAR16  *ReportText
+  IN EFI_HANDLE         Handle,
+  IN OUT HANDLE_REPORT  *Report
   )
 {
   EFI_STATUS           Status;
   EFI_PCI_IO_PROTOCOL  *PciIo;
-  PCI_TYPE00           Pci;
+  UINT8                RevisionAndClass[4];
 
   Status = gBS->HandleProtocol (
                   Handle,
@@ -258,19 +292,23 @@ IsPciDisplay (
     return FALSE;
   }
 
+  //
+  // Only the base class is needed, so read the single dword that holds the
+  // revision ID and the class code rather than the whole configuration header.
+  //
   Status = PciIo->Pci.Read (
                         PciIo,
                         EfiPciIoWidthUint32,
-                        0 /* Offset */,
-                        sizeof Pci / sizeof (UINT32),
-                        &Pci
+                        PCI_REVISION_ID_OFFSET,
+                        1,
+                        RevisionAndClass
                         );
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: %s: %r\n", __FUNCTION__, ReportText, Status));
+    DEBUG ((DEBUG_ERROR, "%a: %s: %r\n", __FUNCTION__, GetReportText (Report), Status));
     return FALSE;
   }
 
-  return IS_PCI_DISPLAY (&Pci);
+  return RevisionAndClass[3] == PCI_CLASS_DISPLAY;
 }
 
 /**
@@ -281,8 +319,8 @@ STATIC
 BOOLEAN
 EFIAPI
 IsUsbHost (
-  IN EFI_HANDLE    Handle,
-  IN CONST CHAR16  *ReportText
+  IN EFI_HANDLE         Handle,
+  IN OUT HANDLE_REPORT  *Report
   )
 {
   NON_DISCOVERABLE_DEVICE  *Device;
@@ -315,8 +353,8 @@ STATIC
 VOID
 EFIAPI
 Connect (
-  IN EFI_HANDLE    Handle,
-  IN CONST CHAR16  *ReportText
+  IN EFI_HANDLE         Handle,
+  IN OUT HANDLE_REPORT  *Report
   )
 {
   EFI_STATUS  Status;
@@ -331,11 +369,97 @@ Connect (
     EFI_ERROR (Status) ? DEBUG_ERROR : DEBUG_VERBOSE,
     "%a: %s: %r\n",
     __FUNCTION__,
-    ReportText,
+    GetReportText (Report),
+    Status
+    ));
+}
+
+//
+// Controllers the console does not depend on are queued by DeferConnect() and
+// connected by PlatformBmConnectDeferred() once the console is up, at
+// TPL_APPLICATION, in the order they were queued.
+//
+STATIC EFI_HANDLE  *mDeferredConnects;
+STATIC UINTN       mDeferredConnectCount;
+
+/**
+  Connect a handle recursively on behalf of DeferConnect().
+
+  @param[in] Handle  The handle to connect.
+**/
+STATIC
+VOID
+ConnectDeferred (
+  IN EFI_HANDLE  Handle
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gBS->ConnectController (Handle, NULL, NULL, TRUE);
+  DEBUG ((
+    EFI_ERROR (Status) ? DEBUG_ERROR : DEBUG_VERBOSE,
+    "%a: handle %p: %r\n",
+    __FUNCTION__,
+    Handle,
     Status
     ));
 }
 
+/**
+  This CALLBACK_FUNCTION queues a handle for a recursive connect by
+  PlatformBmConnectDeferred(), and returns without connecting it.
+**/
+STATIC
+VOID
+EFIAPI
+DeferConnect (
+  IN EFI_HANDLE         Handle,
+  IN OUT HANDLE_REPORT  *Report
+  )
+{
+  EFI_HANDLE  *Queue;
+
+  Queue = ReallocatePool (
+            mDeferredConnectCount * sizeof (EFI_HANDLE),
+            (mDeferredConnectCount + 1) * sizeof (EFI_HANDLE),
+            mDeferredConnects
+            );
+  if (Queue == NULL) {
+    //
+    // Fall back to connecting the handle right away.
+    //
+    ConnectDeferred (Handle);
+    return;
+  }
+
+  mDeferredConnects                          = Queue;
+  mDeferredConnects[mDeferredConnectCount++] = Handle;
+
+  DEBUG ((DEBUG_VERBOSE, "%a: %s: deferred\n", __FUNCTION__, GetReportText (Report)));
+}
+
+/**
+  Connect all the handles queued by DeferConnect().
+**/
+STATIC
+VOID
+PlatformBmConnectDeferred (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mDeferredConnectCount; Index++) {
+    ConnectDeferred (mDeferredConnects[Index]);
+  }
+
+  if (mDeferredConnects != NULL) {
+    FreePool (mDeferredConnects);
+    mDeferredConnects     = NULL;
+    mDeferredConnectCount = 0;
+  }
+}
+
 /**
   This CALLBACK_FUNCTION retrieves the EFI_DEVICE_PATH_PROTOCOL from the
   handle, and adds it to ConOut and ErrOut.
@@ -344,8 +468,8 @@ STATIC
 VOID
 EFIAPI
 AddOutput (
-  IN EFI_HANDLE    Handle,
-  IN CONST CHAR16  *ReportText
+  IN EFI_HANDLE         Handle,
+  IN OUT HANDLE_REPORT  *Report
   )
 {
   EFI_STATUS                Status;
@@ -357,7 +481,7 @@ AddOutput (
       DEBUG_ERROR,
       "%a: %s: handle %p: device path not found\n",
       __FUNCTION__,
-      ReportText,
+      GetReportText (Report),
       Handle
       ));
     return;
@@ -369,7 +493,7 @@ AddOutput (
       DEBUG_ERROR,
       "%a: %s: adding to ConOut: %r\n",
       __FUNCTION__,
-      ReportText,
+      GetReportText (Report),
       Status
       ));
     return;
@@ -381,7 +505,7 @@ AddOutput (
       DEBUG_ERROR,
       "%a: %s: adding to ErrOut: %r\n",
       __FUNCTION__,
-      ReportText,
+      GetReportText (Report),
       Status
       ));
     return;
@@ -391,7 +515,7 @@ AddOutput (
     DEBUG_VERBOSE,
     "%a: %s: added to ConOut and ErrOut\n",
     __FUNCTION__,
-    ReportText
+    GetReportText (Report)
     ));
 }
 
@@ -672,14 +796,18 @@ PlatformBootManagerBeforeConsole (
   // non-recursively. This will produce a number of child handles with PciIo on
   // them.
   //
+  PERF_INMODULE_BEGIN ("PlatformBmConnectPciRoot");
   FilterAndProcess (&gEfiPciRootBridgeIoProtocolGuid, NULL, Connect);
+  PERF_INMODULE_END ("PlatformBmConnectPciRoot");
 
   //
   // Find all display class PCI devices (using the handles from the previous
   // step), and connect them non-recursively. This should produce a number of
   // child handles with GOPs on them.
   //
+  PERF_INMODULE_BEGIN ("PlatformBmConnectDisplay");
   FilterAndProcess (&gEfiPciIoProtocolGuid, IsPciDisplay, Connect);
+  PERF_INMODULE_END ("PlatformBmConnectDisplay");
 
   //
   // Now add the device path of all handles with GOP on them to ConOut and
@@ -694,7 +822,11 @@ PlatformBootManagerBeforeConsole (
   // non-discoverable USB host controllers need to have the non-discoverable
   // PCI driver attached first.
   //
-  FilterAndProcess (&gEdkiiNonDiscoverableDeviceProtocolGuid, IsUsbHost, Connect);
+  // Console output does not depend on these controllers, and a USB keyboard
+  // that appears later is still picked up by ConPlatform, so connect them
+  // once the console is up rather than waiting for USB enumeration here.
+  //
+  FilterAndProcess (&gEdkiiNonDiscoverableDeviceProtocolGuid, IsUsbHost, DeferConnect);
 
   //
   // Add the hardcoded short-form USB keyboard device path to ConIn.
@@ -743,6 +875,10 @@ PlatformBootManagerBeforeConsole (
   // Register platform-specific boot options and keyboard shortcuts.
   //
   PlatformRegisterOptionsAndKeys ();
+
+  if (FeaturePcdGet (PcdPlatformBootManagerFastBoot)) {
+    PlatformBmFastBootInit ();
+  }
 }
 
 STATIC
@@ -983,11 +1119,23 @@ PlatformBootManagerAfterConsole (
     }
   }
 
+  //
+  // The console is up. Connect the controllers queued by
+  // PlatformBootManagerBeforeConsole(), which boot discovery and boot option
+  // enumeration need.
+  //
+  PlatformBmConnectDeferred ();
+
   //
   // Connect device specified by BootDiscoverPolicy variable and
-  // refresh Boot order for newly discovered boot devices
+  // refresh Boot order for newly discovered boot devices, unless the last
+  // boot target can be booted directly.
   //
-  BootDiscoveryPolicyHandler ();
+  if (!FeaturePcdGet (PcdPlatformBootManagerFastBoot) ||
+      !PlatformBmTryFastBoot ())
+  {
+    BootDiscoveryPolicyHandler ();
+  }
 
   //
   // On ARM, there is currently no reason to use the phased capsule
@@ -1072,6 +1220,10 @@ PlatformBootManagerUnableToBoot (
   UINTN                         OldBootOptionCount;
   UINTN                         NewBootOptionCount;
 
+  if (FeaturePcdGet (PcdPlatformBootManagerFastBoot)) {
+    PlatformBmInvalidateFastBoot ();
+  }
+
   //
   // Record the total number of boot configured boot options
   //
@@ -1084,7 +1236,9 @@ PlatformBootManagerUnableToBoot (
   //
   // Connect all devices, and regenerate all boot options
   //
+  PERF_INMODULE_BEGIN ("PlatformBmConnectAll");
   EfiBootManagerConnectAll ();
+  PERF_INMODULE_END ("PlatformBmConnectAll");
   EfiBootManagerRefreshAllBootOption ();
 
   //
@@ -1146,7 +1300,14 @@ PlatformBootManagerProcessBootCompletion (
   IN EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
   )
 {
-  return;
+  //
+  // A boot option that returned with an error must not be fast booted again.
+  //
+  if (FeaturePcdGet (PcdPlatformBootManagerFastBoot) &&
+      EFI_ERROR (BootOption->Status))
+  {
+    PlatformBmInvalidateFastBoot ();
+  }
 }
 
 // MU_CHANGE - Project Mu BDS has this function
@@ -50,4 +50,34 @@ DisableQuietBoot (
   VOID
   );
 
+/**
+  Arrange for the boot option that is about to be launched to be recorded as
+  the fast boot target.
+**/
+VOID
+PlatformBmFastBootInit (
+  VOID
+  );
+
+/**
+  Connect only the controllers on the path to the recorded fast boot target,
+  if the platform configuration has not changed since it was recorded.
+
+  @retval TRUE   The target is connected and will be booted next. Boot
+                 discovery can be skipped.
+  @retval FALSE  Full boot discovery is required.
+**/
+BOOLEAN
+PlatformBmTryFastBoot (
+  VOID
+  );
+
+/**
+  Forget the fast boot target, so that the next boot runs full discovery.
+**/
+VOID
+PlatformBmInvalidateFastBoot (
+  VOID
+  );
+
 #endif // PLATFORM_BM_H_
@@ -0,0 +1,543 @@
+/** @file
+  Fast boot path for PlatformBootManagerLib.
+
+  When a boot option is launched, its device path is recorded together with a
+  fingerprint of the platform configuration. On the next boot, if the
+  fingerprint still matches, only the controllers on that device path are
+  connected and boot discovery is skipped. Any mismatch or failure falls back
+  to the full discovery path.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/PcdLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UefiBootManagerLib.h>
+#include <Protocol/PciIo.h>
+#include <Guid/GlobalVariable.h>
+#include <Guid/PlatformBootManagerFastBoot.h>
+
+#include "PlatformBm.h"
+
+/**
+  Append a block of data to the fingerprint buffer.
+
+  @param[in,out] Buffer    The fingerprint buffer, reallocated as needed.
+  @param[in,out] Size      The size of the fingerprint buffer.
+  @param[in]     Data      The data to append.
+  @param[in]     DataSize  The size of Data.
+
+  @retval EFI_SUCCESS           The data was appended.
+  @retval EFI_OUT_OF_RESOURCES  The buffer could not be grown.
+**/
+STATIC
+EFI_STATUS
+AppendFingerprintData (
+  IN OUT UINT8       **Buffer,
+  IN OUT UINTN       *Size,
+  IN     CONST VOID  *Data,
+  IN     UINTN       DataSize
+  )
+{
+  UINT8  *NewBuffer;
+
+  NewBuffer = ReallocatePool (*Size, *Size + DataSize, *Buffer);
+  if (NewBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (NewBuffer + *Size, Data, DataSize);
+  *Buffer = NewBuffer;
+  *Size  += DataSize;
+  return EFI_SUCCESS;
+}
+
+/**
+  Append the contents of an EFI global variable to the fingerprint buffer.
+
+  @param[in,out] Buffer    The fingerprint buffer, reallocated as needed.
+  @param[in,out] Size      The size of the fingerprint buffer.
+  @param[in]     Name      The name of the variable.
+
+  @retval EFI_SUCCESS  The variable was appended.
+  @return              Errors from GetEfiGlobalVariable2() or
+                       AppendFingerprintData().
+**/
+STATIC
+EFI_STATUS
+AppendFingerprintVariable (
+  IN OUT UINT8         **Buffer,
+  IN OUT UINTN         *Size,
+  IN     CONST CHAR16  *Name
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Data;
+  UINTN       DataSize;
+
+  Status = GetEfiGlobalVariable2 (Name, &Data, &DataSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = AppendFingerprintData (Buffer, Size, Data, DataSize);
+  FreePool (Data);
+  return Status;
+}
+
+/**
+  Check whether a device path is that of a PCI device on the root bus of a
+  PCI root bridge, i.e. an ACPI node followed by a single PCI node.
+
+  @param[in] DevicePath  The device path to check.
+
+  @retval TRUE   The device path is that of a root bus PCI device.
+  @retval FALSE  Otherwise.
+**/
+STATIC
+BOOLEAN
+IsRootBusPciDevice (
+  IN EFI_DEVICE_PATH_PROTOCOL  *DevicePath
+  )
+{
+  if (DevicePathType (DevicePath) != ACPI_DEVICE_PATH) {
+    return FALSE;
+  }
+
+  DevicePath = NextDevicePathNode (DevicePath);
+  if ((DevicePathType (DevicePath) != HARDWARE_DEVICE_PATH) ||
+      (DevicePathSubType (DevicePath) != HW_PCI_DP))
+  {
+    return FALSE;
+  }
+
+  return IsDevicePathEnd (NextDevicePathNode (DevicePath));
+}
+
+/**
+  Order two device paths by size, then by contents.
+
+  @param[in] DevicePath1  The first device path.
+  @param[in] DevicePath2  The second device path.
+
+  @return  A negative value, zero or a positive value if DevicePath1 sorts
+           before, with or after DevicePath2.
+**/
+STATIC
+INTN
+CompareDevicePaths (
+  IN EFI_DEVICE_PATH_PROTOCOL  *DevicePath1,
+  IN EFI_DEVICE_PATH_PROTOCOL  *DevicePath2
+  )
+{
+  UINTN  Size1;
+  UINTN  Size2;
+
+  Size1 = GetDevicePathSize (DevicePath1);
+  Size2 = GetDevicePathSize (DevicePath2);
+  if (Size1 != Size2) {
+    return (Size1 < Size2) ? -1 : 1;
+  }
+
+  return CompareMem (DevicePath1, DevicePath2, Size1);
+}
+
+/**
+  Compute a fingerprint of the platform configuration relevant to booting a
+  given boot option: the firmware version, BootOrder, the Boot#### option
+  itself and the device paths of the PCI devices on the root buses.
+
+  @param[in]  OptionNumber  The number of the boot option.
+  @param[out] Fingerprint   The CRC32 of the platform configuration.
+
+  @retval EFI_SUCCESS  The fingerprint was computed.
+  @return              The configuration could not be retrieved.
+**/
+STATIC
+EFI_STATUS
+ComputeFingerprint (
+  IN  UINT16  OptionNumber,
+  OUT UINT32  *Fingerprint
+  )
+{
+  EFI_STATUS                Status;
+  UINT8                     *Buffer;
+  UINTN                     Size;
+  CHAR16                    OptionName[sizeof ("Boot####")];
+  EFI_HANDLE                *Handles;
+  UINTN                     NoHandles;
+  UINTN                     Idx;
+  UINTN                     Idx2;
+  UINTN                     NoDevicePaths;
+  EFI_DEVICE_PATH_PROTOCOL  **DevicePaths;
+  EFI_DEVICE_PATH_PROTOCOL  *DevicePath;
+
+  Buffer      = NULL;
+  Size        = 0;
+  DevicePaths = NULL;
+
+  Status = AppendFingerprintData (
+             &Buffer,
+             &Size,
+             PcdGetPtr (PcdFirmwareVersionString),
+             StrSize (PcdGetPtr (PcdFirmwareVersionString))
+             );
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = AppendFingerprintVariable (&Buffer, &Size, EFI_BOOT_ORDER_VARIABLE_NAME);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  UnicodeSPrint (OptionName, sizeof OptionName, L"Boot%04x", OptionNumber);
+  Status = AppendFingerprintVariable (&Buffer, &Size, OptionName);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  //
+  // Only the PCI devices on the root buses are fingerprinted. They have a
+  // PciIo handle as soon as the root bridges are connected, so the set is
+  // the same when the target is checked, before the full connect, and when
+  // it is recorded, after it. Devices that only get a PciIo handle later,
+  // such as non-discoverable ones, are left out. A root bus device that was
+  // added, removed or moved changes the fingerprint.
+  //
+  // LocateHandleBuffer() returns the handles in no particular order, so the
+  // device paths are sorted before they are appended.
+  //
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiPciIoProtocolGuid,
+                  NULL,
+                  &NoHandles,
+                  &Handles
+                  );
+  if (!EFI_ERROR (Status)) {
+    DevicePaths = AllocatePool (NoHandles * sizeof (*DevicePaths));
+    if (DevicePaths == NULL) {
+      gBS->FreePool (Handles);
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Done;
+    }
+
+    NoDevicePaths = 0;
+    for (Idx = 0; Idx < NoHandles; ++Idx) {
+      DevicePath = DevicePathFromHandle (Handles[Idx]);
+      if ((DevicePath == NULL) || !IsRootBusPciDevice (DevicePath)) {
+        continue;
+      }
+
+      //
+      // Insertion sort, as there are only a few root bus devices.
+      //
+      for (Idx2 = NoDevicePaths;
+           Idx2 > 0 && CompareDevicePaths (DevicePaths[Idx2 - 1], DevicePath) > 0;
+           --Idx2)
+      {
+        DevicePaths[Idx2] = DevicePaths[Idx2 - 1];
+      }
+
+      DevicePaths[Idx2] = DevicePath;
+      NoDevicePaths++;
+    }
+
+    gBS->FreePool (Handles);
+
+    for (Idx = 0; Idx < NoDevicePaths && !EFI_ERROR (Status); ++Idx) {
+      Status = AppendFingerprintData (
+                 &Buffer,
+                 &Size,
+                 DevicePaths[Idx],
+                 GetDevicePathSize (DevicePaths[Idx])
+                 );
+    }
+
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+  }
+
+  Status = gBS->CalculateCrc32 (Buffer, Size, Fingerprint);
+
+Done:
+  if (DevicePaths != NULL) {
+    FreePool (DevicePaths);
+  }
+
+  if (Buffer != NULL) {
+    FreePool (Buffer);
+  }
+
+  return Status;
+}
+
+/**
+  Check whether a boot option points at a full device path whose controllers
+  can be connected directly, rather than at a short-form device path or at an
+  application in a firmware volume.
+
+  @param[in] DevicePath  The device path of the boot option.
+
+  @retval TRUE   The device path starts at a root bridge or other hardware.
+  @retval FALSE  Otherwise.
+**/
+STATIC
+BOOLEAN
+IsFullDevicePath (
+  IN EFI_DEVICE_PATH_PROTOCOL  *DevicePath
+  )
+{
+  return (DevicePathType (DevicePath) == ACPI_DEVICE_PATH) ||
+         (DevicePathType (DevicePath) == HARDWARE_DEVICE_PATH &&
+          DevicePathSubType (DevicePath) != HW_VENDOR_DP);
+}
+
+/**
+  Record the boot option being launched as the fast boot target. Called from
+  the ReadyToBoot event, when BootCurrent has been set.
+
+  @param[in] Event    The ReadyToBoot event.
+  @param[in] Context  Unused.
+**/
+STATIC
+VOID
+EFIAPI
+RecordFastBootTarget (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS                              Status;
+  UINT16                                  *BootCurrent;
+  UINTN                                   Size;
+  CHAR16                                  OptionName[sizeof ("Boot####")];
+  EFI_BOOT_MANAGER_LOAD_OPTION            Option;
+  PLATFORM_BOOT_MANAGER_FAST_BOOT_TARGET  *Target;
+  PLATFORM_BOOT_MANAGER_FAST_BOOT_TARGET  *OldTarget;
+  UINTN                                   TargetSize;
+  UINTN                                   OldTargetSize;
+
+  Status = GetEfiGlobalVariable2 (L"BootCurrent", (VOID **)&BootCurrent, &Size);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  if (Size != sizeof (UINT16)) {
+    FreePool (BootCurrent);
+    return;
+  }
+
+  UnicodeSPrint (OptionName, sizeof OptionName, L"Boot%04x", *BootCurrent);
+  FreePool (BootCurrent);
+
+  Status = EfiBootManagerVariableToLoadOption (OptionName, &Option);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Target = NULL;
+  if (((Option.Attributes & LOAD_OPTION_CATEGORY) != LOAD_OPTION_CATEGORY_BOOT) ||
+      !IsFullDevicePath (Option.FilePath))
+  {
+    goto Done;
+  }
+
+  TargetSize = sizeof (*Target) + GetDevicePathSize (Option.FilePath);
+  Target     = AllocateZeroPool (TargetSize);
+  if (Target == NULL) {
+    goto Done;
+  }
+
+  Target->OptionNumber = (UINT16)Option.OptionNumber;
+  CopyMem (Target + 1, Option.FilePath, TargetSize - sizeof (*Target));
+
+  Status = ComputeFingerprint (Target->OptionNumber, &Target->Fingerprint);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  //
+  // Avoid a non-volatile variable write on every boot of the same target.
+  //
+  Status = GetVariable2 (
+             PLATFORM_BOOT_MANAGER_FAST_BOOT_VARIABLE_NAME,
+             &gPlatformBootManagerFastBootGuid,
+             (VOID **)&OldTarget,
+             &OldTargetSize
+             );
+  if (!EFI_ERROR (Status)) {
+    if ((OldTargetSize == TargetSize) &&
+        (CompareMem (OldTarget, Target, TargetSize) == 0))
+    {
+      FreePool (OldTarget);
+      goto Done;
+    }
+
+    FreePool (OldTarget);
+  }
+
+  Status = gRT->SetVariable (
+                  PLATFORM_BOOT_MANAGER_FAST_BOOT_VARIABLE_NAME,
+                  &gPlatformBootManagerFastBootGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  TargetSize,
+                  Target
+                  );
+  DEBUG ((
+    EFI_ERROR (Status) ? DEBUG_ERROR : DEBUG_INFO,
+    "%a: %s: %r\n",
+    __FUNCTION__,
+    OptionName,
+    Status
+    ));
+
+Done:
+  if (Target != NULL) {
+    FreePool (Target);
+  }
+
+  EfiBootManagerFreeLoadOption (&Option);
+}
+
+/**
+  Forget the fast boot target, so that the next boot runs full discovery.
+**/
+VOID
+PlatformBmInvalidateFastBoot (
+  VOID
+  )
+{
+  gRT->SetVariable (
+         PLATFORM_BOOT_MANAGER_FAST_BOOT_VARIABLE_NAME,
+         &gPlatformBootManagerFastBootGuid,
+         0,
+         0,
+         NULL
+         );
+}
+
+/**
+  Arrange for the boot option that is about to be launched to be recorded as
+  the fast boot target.
+**/
+VOID
+PlatformBmFastBootInit (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   Event;
+
+  Status = EfiCreateEventReadyToBootEx (
+             TPL_CALLBACK,
+             RecordFastBootTarget,
+             NULL,
+             &Event
+             );
+  ASSERT_EFI_ERROR (Status);
+}
+
+/**
+  Connect only the controllers on the path to the recorded fast boot target,
+  if the platform configuration has not changed since it was recorded.
+
+  @retval TRUE   The target is connected and will be booted next. Boot
+                 discovery can be skipped.
+  @retval FALSE  Full boot discovery is required.
+**/
+BOOLEAN
+PlatformBmTryFastBoot (
+  VOID
+  )
+{
+  EFI_STATUS                              Status;
+  PLATFORM_BOOT_MANAGER_FAST_BOOT_TARGET  *Target;
+  UINTN                                   TargetSize;
+  EFI_DEVICE_PATH_PROTOCOL                *DevicePath;
+  UINT16                                  *BootOrder;
+  UINTN                                   BootOrderSize;
+  UINT32                                  Fingerprint;
+  BOOLEAN                                 FastBoot;
+
+  Status = GetVariable2 (
+             PLATFORM_BOOT_MANAGER_FAST_BOOT_VARIABLE_NAME,
+             &gPlatformBootManagerFastBootGuid,
+             (VOID **)&Target,
+             &TargetSize
+             );
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  FastBoot   = FALSE;
+  DevicePath = (EFI_DEVICE_PATH_PROTOCOL *)(Target + 1);
+  if ((TargetSize <= sizeof (*Target)) ||
+      !IsDevicePathValid (DevicePath, TargetSize - sizeof (*Target)))
+  {
+    PlatformBmInvalidateFastBoot ();
+    goto Done;
+  }
+
+  Status = ComputeFingerprint (Target->OptionNumber, &Fingerprint);
+  if (EFI_ERROR (Status) || (Fingerprint != Target->Fingerprint)) {
+    DEBUG ((
+      DEBUG_INFO,
+      "%a: platform configuration changed, running full discovery\n",
+      __FUNCTION__
+      ));
+    goto Done;
+  }
+
+  Status = EfiBootManagerConnectDevicePath (DevicePath, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_WARN,
+      "%a: failed to connect Boot%04x: %r\n",
+      __FUNCTION__,
+      Target->OptionNumber,
+      Status
+      ));
+    PlatformBmInvalidateFastBoot ();
+    goto Done;
+  }
+
+  //
+  // Boot the target first. BootNext is only needed if it is not already at
+  // the head of BootOrder, which saves a variable write in the common case.
+  //
+  Status = GetEfiGlobalVariable2 (
+             EFI_BOOT_ORDER_VARIABLE_NAME,
+             (VOID **)&BootOrder,
+             &BootOrderSize
+             );
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  if ((BootOrderSize < sizeof (UINT16)) || (BootOrder[0] != Target->OptionNumber)) {
+    Status = gRT->SetVariable (
+                    EFI_BOOT_NEXT_VARIABLE_NAME,
+                    &gEfiGlobalVariableGuid,
+                    EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS |
+                    EFI_VARIABLE_RUNTIME_ACCESS,
+                    sizeof (Target->OptionNumber),
+                    &Target->OptionNumber
+                    );
+  }
+
+  FreePool (BootOrder);
+
+  if (!EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "%a: fast boot to Boot%04x\n", __FUNCTION__, Target->OptionNumber));
+    FastBoot = TRUE;
+  }
+
+Done:
+  FreePool (Target);
+  return FastBoot;
+}
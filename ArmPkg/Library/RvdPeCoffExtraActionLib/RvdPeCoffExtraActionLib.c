@@ -14,10 +14,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
 #include <Library/PeCoffExtraActionLib.h>
+#include <Library/PeCoffSymbolBatchLib.h>
 #include <Library/SemihostLib.h>
 #include <Library/PrintLib.h>
 
+STATIC BOOLEAN  mManifestCreated;
+
 /**
   Append string to debugger script file, create file if needed.
 
@@ -95,6 +99,113 @@ DeCygwinPathIfNeeded (
   return Name;
 }
 
+/**
+  Write a block of debugger commands produced by the symbol batch library.
+
+  @param[in]  String  The NULL-terminated commands to write.
+
+**/
+STATIC
+VOID
+EFIAPI
+WriteBatchedCommands (
+  IN CONST CHAR8  *String
+  )
+{
+  WriteStringToFile ((VOID *)String, (UINT32)AsciiStrSize (String));
+}
+
+/**
+  Write a block of manifest lines produced by the symbol batch library to the
+  host file named by PcdPeCoffSymbolManifestFile.
+
+  The file is recreated by the first write of the boot, and appended to
+  afterwards.
+
+  @param[in]  String  The NULL-terminated manifest lines to write.
+
+**/
+STATIC
+VOID
+EFIAPI
+WriteBatchedManifest (
+  IN CONST CHAR8  *String
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         SemihostMode;
+  UINTN          SemihostHandle;
+  UINTN          Length;
+
+  SemihostMode = SEMIHOST_FILE_MODE_BINARY;
+  if (mManifestCreated) {
+    SemihostMode |= SEMIHOST_FILE_MODE_APPEND;
+  } else {
+    SemihostMode |= SEMIHOST_FILE_MODE_WRITE;
+  }
+
+  Status = SemihostFileOpen ((CHAR8 *)FixedPcdGetPtr (PcdPeCoffSymbolManifestFile), SemihostMode, &SemihostHandle);
+  if (RETURN_ERROR (Status)) {
+    return;
+  }
+
+  mManifestCreated = TRUE;
+
+  Length = AsciiStrLen (String);
+  SemihostFileWrite (SemihostHandle, &Length, (VOID *)String);
+  SemihostFileClose (SemihostHandle);
+}
+
+/**
+  Write the debugger command of an image load or unload, through the symbol
+  batch library if it batches records at this point of the boot.
+
+  @param  Command       The NULL-terminated debugger command.
+  @param  Load          TRUE if the image is loaded, FALSE if it is unloaded.
+  @param  ImageContext  The image context of the image.
+
+**/
+STATIC
+VOID
+WriteSymbolCommand (
+  IN  CHAR8                         *Command,
+  IN  BOOLEAN                       Load,
+  IN  PE_COFF_LOADER_IMAGE_CONTEXT  *ImageContext
+  )
+{
+  RETURN_STATUS               Status;
+  PECOFF_SYMBOL_BATCH_OUTPUT  WriteManifest;
+  CHAR8                       Path[256];
+  CHAR8                       *ImagePath;
+
+  Status = RETURN_UNSUPPORTED;
+  if (ImageContext->PdbPointer != NULL) {
+    AsciiStrnCpyS (Path, sizeof (Path), ImageContext->PdbPointer, sizeof (Path) - 1);
+    ImagePath = DeCygwinPathIfNeeded (Path);
+    while (*ImagePath == ' ') {
+      ImagePath++;
+    }
+
+    WriteManifest = NULL;
+    if (*(CHAR8 *)FixedPcdGetPtr (PcdPeCoffSymbolManifestFile) != '\0') {
+      WriteManifest = WriteBatchedManifest;
+    }
+
+    Status = PeCoffSymbolBatchRecord (
+               WriteBatchedCommands,
+               WriteManifest,
+               Command,
+               Load,
+               ImagePath,
+               ImageContext->ImageAddress + ImageContext->SizeOfHeaders
+               );
+  }
+
+  if (RETURN_ERROR (Status)) {
+    WriteStringToFile (Command, AsciiStrSize (Command));
+  }
+}
+
 /**
   Performs additional actions after a PE/COFF image has been loaded and relocated.
 
@@ -119,7 +230,7 @@ PeCoffLoaderRelocateImageExtraAction (
  #endif
   DeCygwinPathIfNeeded (&Buffer[16]);
 
-  WriteStringToFile (Buffer, AsciiStrSize (Buffer));
+  WriteSymbolCommand (Buffer, TRUE, ImageContext);
 }
 
 /**
@@ -143,5 +254,5 @@ PeCoffLoaderUnloadImageExtraAction (
   AsciiSPrint (Buffer, sizeof (Buffer), "unload symbols_only \"%a\"\n", ImageContext->PdbPointer);
   DeCygwinPathIfNeeded (Buffer);
 
-  WriteStringToFile (Buffer, AsciiStrSize (Buffer));
+  WriteSymbolCommand (Buffer, FALSE, ImageContext);
 }
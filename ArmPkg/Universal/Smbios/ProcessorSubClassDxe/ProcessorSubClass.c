@@ -52,6 +52,31 @@ typedef enum {
   CacheLocationMax
 } CACHE_LOCATION;
 
+//
+// Strings of the Type 4 records that are shared by all sockets, in the order
+// in which they follow the Processor Designation string.
+//
+typedef enum {
+  ProcessorStringManufacturer,
+  ProcessorStringVersion,
+  ProcessorStringSerialNumber,
+  ProcessorStringAssetTag,
+  ProcessorStringPartNumber,
+  ProcessorStringMax
+} PROCESSOR_STRING;
+
+//
+// A Type 7 record describing one cache of the boot processor, to which the
+// platform specific information of each socket is added.
+//
+typedef struct {
+  UINT8                 CacheLevel;
+  BOOLEAN               DataCache;
+  BOOLEAN               UnifiedCache;
+  UINTN                 RecordSize;
+  SMBIOS_TABLE_TYPE7    *Record;
+} CACHE_TEMPLATE;
+
 EFI_HII_HANDLE  mHiiHandle;
 
 EFI_SMBIOS_PROTOCOL  *mSmbios;
@@ -99,6 +124,14 @@ SMBIOS_TABLE_TYPE4  mSmbiosProcessorTableTemplate = {
   0                           // ThreadCount2
 };
 
+STATIC CHAR8  *mProcessorStrings[ProcessorStringMax];
+STATIC UINTN  mProcessorStringsSize;
+
+STATIC UINT16  mProcessorCharacteristics;
+
+STATIC CACHE_TEMPLATE  mCacheTemplates[MAX_ARM_CACHE_LEVEL * 2];
+STATIC UINTN           mCacheTemplateCount;
+
 /** Sets the HII variable `StringId` is `Pcd` isn't empty.
 
     @param Pcd       The FixedAtBuild PCD that contains the string to fetch.
@@ -347,33 +380,26 @@ AllocateAndInitCacheInformation (
 }
 
 /**
-  Add Type 7 SMBIOS Record for Cache Information.
+  Build the Type 7 templates of the caches of the boot processor.
 
-  @param[in]    ProcessorIndex      Processor number of specified processor.
-  @param[out]   L1CacheHandle       Pointer to the handle of the L1 Cache SMBIOS record.
-  @param[out]   L2CacheHandle       Pointer to the handle of the L2 Cache SMBIOS record.
-  @param[out]   L3CacheHandle       Pointer to the handle of the L3 Cache SMBIOS record.
+  The cache geometry is read from the CPU registers of the processor this
+  driver runs on, so it is the same for all sockets, and only needs to be
+  read once.
 
 **/
 VOID
-AddSmbiosCacheTypeTable (
-  IN UINTN               ProcessorIndex,
-  OUT EFI_SMBIOS_HANDLE  *L1CacheHandle,
-  OUT EFI_SMBIOS_HANDLE  *L2CacheHandle,
-  OUT EFI_SMBIOS_HANDLE  *L3CacheHandle
+InitializeCacheTemplates (
+  VOID
   )
 {
-  EFI_STATUS          Status;
   SMBIOS_TABLE_TYPE7  *Type7Record;
-  EFI_SMBIOS_HANDLE   SmbiosHandle;
+  CACHE_TEMPLATE      *Template;
   UINT8               CacheLevel;
   UINT8               MaxCacheLevel;
   BOOLEAN             DataCacheType;
   BOOLEAN             SeparateCaches;
 
-  Status = EFI_SUCCESS;
-
-  MaxCacheLevel = 0;
+  mCacheTemplateCount = 0;
 
   // See if there's an L1 cache present.
   MaxCacheLevel = SmbiosProcessorGetMaxCacheLevel ();
@@ -383,8 +409,6 @@ AddSmbiosCacheTypeTable (
   }
 
   for (CacheLevel = 1; CacheLevel <= MaxCacheLevel; CacheLevel++) {
-    Type7Record = NULL;
-
     SeparateCaches = SmbiosProcessorHasSeparateCaches (CacheLevel);
 
     // At each level of cache, we can have a single type (unified, instruction or data),
@@ -413,221 +437,233 @@ AddSmbiosCacheTypeTable (
         Type7Record
         );
 
-      // Allow the platform to fill in other information such as speed, SRAM type etc.
-      if (!OemGetCacheInformation (
-             ProcessorIndex,
-             CacheLevel,
-             DataCacheType,
-             !SeparateCaches,
-             Type7Record
-             ))
-      {
-        continue;
-      }
+      Template               = &mCacheTemplates[mCacheTemplateCount++];
+      Template->CacheLevel   = CacheLevel;
+      Template->DataCache    = DataCacheType;
+      Template->UnifiedCache = !SeparateCaches;
+      Template->Record       = Type7Record;
+      Template->RecordSize   = sizeof (SMBIOS_TABLE_TYPE7) +
+                               AsciiStrSize ((CHAR8 *)(Type7Record + 1)) + 1;
+    }
+  }
+}
 
-      SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
-      // Finally, install the table
-      Status = mSmbios->Add (
-                          mSmbios,
-                          NULL,
-                          &SmbiosHandle,
-                          (EFI_SMBIOS_TABLE_HEADER *)Type7Record
-                          );
-      if (EFI_ERROR (Status)) {
-        continue;
-      }
+/**
+  Add Type 7 SMBIOS Record for Cache Information.
 
-      // Config L1/L2/L3 Cache Handle
-      switch (CacheLevel) {
-        case CpuCacheL1:
-          *L1CacheHandle = SmbiosHandle;
-          break;
-        case CpuCacheL2:
-          *L2CacheHandle = SmbiosHandle;
-          break;
-        case CpuCacheL3:
-          *L3CacheHandle = SmbiosHandle;
-          break;
-        default:
-          break;
-      }
+  @param[in]    ProcessorIndex      Processor number of specified processor.
+  @param[out]   L1CacheHandle       Pointer to the handle of the L1 Cache SMBIOS record.
+  @param[out]   L2CacheHandle       Pointer to the handle of the L2 Cache SMBIOS record.
+  @param[out]   L3CacheHandle       Pointer to the handle of the L3 Cache SMBIOS record.
+
+**/
+VOID
+AddSmbiosCacheTypeTable (
+  IN UINTN               ProcessorIndex,
+  OUT EFI_SMBIOS_HANDLE  *L1CacheHandle,
+  OUT EFI_SMBIOS_HANDLE  *L2CacheHandle,
+  OUT EFI_SMBIOS_HANDLE  *L3CacheHandle
+  )
+{
+  EFI_STATUS          Status;
+  SMBIOS_TABLE_TYPE7  *Type7Record;
+  EFI_SMBIOS_HANDLE   SmbiosHandle;
+  CACHE_TEMPLATE      *Template;
+  UINTN               Index;
+
+  for (Index = 0; Index < mCacheTemplateCount; Index++) {
+    Template = &mCacheTemplates[Index];
+
+    Type7Record = AllocateCopyPool (Template->RecordSize, Template->Record);
+    if (Type7Record == NULL) {
+      continue;
+    }
+
+    // Allow the platform to fill in other information such as speed, SRAM type etc.
+    if (!OemGetCacheInformation (
+           ProcessorIndex,
+           Template->CacheLevel,
+           Template->DataCache,
+           Template->UnifiedCache,
+           Type7Record
+           ))
+    {
+      FreePool (Type7Record);
+      continue;
+    }
+
+    SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+    // Finally, install the table
+    Status = mSmbios->Add (
+                        mSmbios,
+                        NULL,
+                        &SmbiosHandle,
+                        (EFI_SMBIOS_TABLE_HEADER *)Type7Record
+                        );
+    FreePool (Type7Record);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    // Config L1/L2/L3 Cache Handle
+    switch (Template->CacheLevel) {
+      case CpuCacheL1:
+        *L1CacheHandle = SmbiosHandle;
+        break;
+      case CpuCacheL2:
+        *L2CacheHandle = SmbiosHandle;
+        break;
+      case CpuCacheL3:
+        *L3CacheHandle = SmbiosHandle;
+        break;
+      default:
+        break;
     }
   }
 }
 
-/** Allocates a Type 4 Processor Information structure and sets the
-    strings following the data fields.
+/** Fetches the strings of the Type 4 records that are shared by all sockets.
 
-  @param[out] Type4Record    The Type 4 structure to allocate and initialize
-  @param[in]  ProcessorIndex The index of the processor
-  @param[in]  Populated      Whether the specified processor is
-                             populated.
+  The strings are updated in, and read back from, the HII database once, and
+  kept in ASCII form, ready to be copied into each record.
 
-  @retval EFI_SUCCESS          The Type 4 structure was successfully
-                               allocated and the strings initialized.
+  @retval EFI_SUCCESS          The strings were fetched.
   @retval EFI_OUT_OF_RESOURCES Could not allocate memory needed.
 **/
 EFI_STATUS
-AllocateType4AndSetProcessorInformationStrings (
-  SMBIOS_TABLE_TYPE4  **Type4Record,
-  UINT8               ProcessorIndex,
-  BOOLEAN             Populated
+InitializeProcessorStrings (
+  VOID
   )
 {
-  EFI_STATUS     Status;
-  EFI_STRING_ID  ProcessorManu;
-  EFI_STRING_ID  ProcessorVersion;
-  EFI_STRING_ID  SerialNumber;
-  EFI_STRING_ID  AssetTag;
-  EFI_STRING_ID  PartNumber;
-  EFI_STRING     ProcessorStr;
-  EFI_STRING     ProcessorManuStr;
-  EFI_STRING     ProcessorVersionStr;
-  EFI_STRING     SerialNumberStr;
-  EFI_STRING     AssetTagStr;
-  EFI_STRING     PartNumberStr;
-  CHAR8          *OptionalStrStart;
-  CHAR8          *StrStart;
-  UINTN          ProcessorStrLen;
-  UINTN          ProcessorManuStrLen;
-  UINTN          ProcessorVersionStrLen;
-  UINTN          SerialNumberStrLen;
-  UINTN          AssetTagStrLen;
-  UINTN          PartNumberStrLen;
-  UINTN          TotalSize;
-  UINTN          StringBufferSize;
-
-  Status = EFI_SUCCESS;
-
-  ProcessorManuStr    = NULL;
-  ProcessorVersionStr = NULL;
-  SerialNumberStr     = NULL;
-  AssetTagStr         = NULL;
-  PartNumberStr       = NULL;
-
-  ProcessorManu    = STRING_TOKEN (STR_PROCESSOR_MANUFACTURE);
-  ProcessorVersion = STRING_TOKEN (STR_PROCESSOR_VERSION);
-  SerialNumber     = STRING_TOKEN (STR_PROCESSOR_SERIAL_NUMBER);
-  AssetTag         = STRING_TOKEN (STR_PROCESSOR_ASSET_TAG);
-  PartNumber       = STRING_TOKEN (STR_PROCESSOR_PART_NUMBER);
-
-  SET_HII_STRING_IF_PCD_NOT_EMPTY (PcdProcessorManufacturer, ProcessorManu);
-  SET_HII_STRING_IF_PCD_NOT_EMPTY (PcdProcessorVersion, ProcessorVersion);
-  SET_HII_STRING_IF_PCD_NOT_EMPTY (PcdProcessorAssetTag, AssetTag);
+  EFI_STRING_ID  StringIds[ProcessorStringMax];
+  EFI_STRING     String;
+  UINTN          StringSize;
+  UINTN          Index;
+
+  StringIds[ProcessorStringManufacturer] = STRING_TOKEN (STR_PROCESSOR_MANUFACTURE);
+  StringIds[ProcessorStringVersion]      = STRING_TOKEN (STR_PROCESSOR_VERSION);
+  StringIds[ProcessorStringSerialNumber] = STRING_TOKEN (STR_PROCESSOR_SERIAL_NUMBER);
+  StringIds[ProcessorStringAssetTag]     = STRING_TOKEN (STR_PROCESSOR_ASSET_TAG);
+  StringIds[ProcessorStringPartNumber]   = STRING_TOKEN (STR_PROCESSOR_PART_NUMBER);
+
+  SET_HII_STRING_IF_PCD_NOT_EMPTY (PcdProcessorManufacturer, StringIds[ProcessorStringManufacturer]);
+  SET_HII_STRING_IF_PCD_NOT_EMPTY (PcdProcessorVersion, StringIds[ProcessorStringVersion]);
+  SET_HII_STRING_IF_PCD_NOT_EMPTY (PcdProcessorAssetTag, StringIds[ProcessorStringAssetTag]);
 
   if (StrLen ((CHAR16 *)FixedPcdGetPtr (PcdProcessorSerialNumber)) > 0) {
-    HiiSetString (mHiiHandle, SerialNumber, (CHAR16 *)FixedPcdGetPtr (PcdProcessorSerialNumber), NULL);
+    HiiSetString (mHiiHandle, StringIds[ProcessorStringSerialNumber], (CHAR16 *)FixedPcdGetPtr (PcdProcessorSerialNumber), NULL);
   } else {
-    OemUpdateSmbiosInfo (mHiiHandle, SerialNumber, ProcessorSerialNumType04);
+    OemUpdateSmbiosInfo (mHiiHandle, StringIds[ProcessorStringSerialNumber], ProcessorSerialNumType04);
   }
 
   if (StrLen ((CHAR16 *)FixedPcdGetPtr (PcdProcessorPartNumber)) > 0) {
-    HiiSetString (mHiiHandle, PartNumber, (CHAR16 *)FixedPcdGetPtr (PcdProcessorPartNumber), NULL);
+    HiiSetString (mHiiHandle, StringIds[ProcessorStringPartNumber], (CHAR16 *)FixedPcdGetPtr (PcdProcessorPartNumber), NULL);
   } else {
-    OemUpdateSmbiosInfo (mHiiHandle, PartNumber, ProcessorPartNumType04);
+    OemUpdateSmbiosInfo (mHiiHandle, StringIds[ProcessorStringPartNumber], ProcessorPartNumType04);
   }
 
-  // Processor Designation
-  StringBufferSize = sizeof (CHAR16) * SMBIOS_STRING_MAX_LENGTH;
-  ProcessorStr     = AllocateZeroPool (StringBufferSize);
-  if (ProcessorStr == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  mProcessorStringsSize = 0;
+  for (Index = 0; Index < ProcessorStringMax; Index++) {
+    String = HiiGetPackageString (&gEfiCallerIdGuid, StringIds[Index], NULL);
+    if (String == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    StringSize               = StrLen (String) + 1;
+    mProcessorStrings[Index] = AllocatePool (StringSize);
+    if (mProcessorStrings[Index] == NULL) {
+      FreePool (String);
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    UnicodeStrToAsciiStrS (String, mProcessorStrings[Index], StringSize);
+    FreePool (String);
+
+    mProcessorStringsSize += StringSize;
   }
 
-  ProcessorStrLen = UnicodeSPrint (
-                      ProcessorStr,
-                      StringBufferSize,
-                      L"CPU%02d",
-                      ProcessorIndex + 1
-                      );
+  return EFI_SUCCESS;
+}
 
-  // Processor Manufacture
-  ProcessorManuStr    = HiiGetPackageString (&gEfiCallerIdGuid, ProcessorManu, NULL);
-  ProcessorManuStrLen = StrLen (ProcessorManuStr);
+/** Fills in the fields of the Type 4 template that are read from the boot
+    processor, including those obtained with SMCCC calls.
 
-  // Processor Version
-  ProcessorVersionStr    = HiiGetPackageString (&gEfiCallerIdGuid, ProcessorVersion, NULL);
-  ProcessorVersionStrLen = StrLen (ProcessorVersionStr);
+**/
+VOID
+InitializeProcessorTemplate (
+  VOID
+  )
+{
+  UINT64                          *ProcessorId;
+  PROCESSOR_CHARACTERISTIC_FLAGS  ProcessorCharacteristics;
 
-  // Serial Number
-  SerialNumberStr    = HiiGetPackageString (&gEfiCallerIdGuid, SerialNumber, NULL);
-  SerialNumberStrLen = StrLen (SerialNumberStr);
+  mSmbiosProcessorTableTemplate.ExternalClock =
+    (UINT16)(SmbiosGetExternalClockFrequency () / 1000 / 1000);
 
-  // Asset Tag
-  AssetTagStr    = HiiGetPackageString (&gEfiCallerIdGuid, AssetTag, NULL);
-  AssetTagStrLen = StrLen (AssetTagStr);
+  ProcessorId  = (UINT64 *)&mSmbiosProcessorTableTemplate.ProcessorId;
+  *ProcessorId = SmbiosGetProcessorId ();
 
-  // Part Number
-  PartNumberStr    = HiiGetPackageString (&gEfiCallerIdGuid, PartNumber, NULL);
-  PartNumberStrLen = StrLen (PartNumberStr);
+  ProcessorCharacteristics = SmbiosGetProcessorCharacteristics ();
+  CopyMem (&mProcessorCharacteristics, &ProcessorCharacteristics, sizeof (mProcessorCharacteristics));
 
-  TotalSize = sizeof (SMBIOS_TABLE_TYPE4) +
-              ProcessorStrLen        + 1 +
-              ProcessorManuStrLen    + 1 +
-              ProcessorVersionStrLen + 1 +
-              SerialNumberStrLen     + 1 +
-              AssetTagStrLen         + 1 +
-              PartNumberStrLen       + 1 + 1;
+  mSmbiosProcessorTableTemplate.ProcessorFamily  = SmbiosGetProcessorFamily ();
+  mSmbiosProcessorTableTemplate.ProcessorFamily2 = SmbiosGetProcessorFamily2 ();
+}
 
-  *Type4Record = AllocateZeroPool (TotalSize);
-  if (*Type4Record == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Exit;
-  }
+/** Allocates a Type 4 Processor Information structure from the template and
+    sets the strings following the data fields.
 
-  CopyMem (*Type4Record, &mSmbiosProcessorTableTemplate, sizeof (SMBIOS_TABLE_TYPE4));
+  @param[out] Type4Record    The Type 4 structure to allocate and initialize
+  @param[in]  ProcessorIndex The index of the processor
+  @param[in]  Populated      Whether the specified processor is
+                             populated.
 
-  OptionalStrStart = (CHAR8 *)(*Type4Record + 1);
-  UnicodeStrToAsciiStrS (
-    ProcessorStr,
-    OptionalStrStart,
-    ProcessorStrLen + 1
-    );
+  @retval EFI_SUCCESS          The Type 4 structure was successfully
+                               allocated and the strings initialized.
+  @retval EFI_OUT_OF_RESOURCES Could not allocate memory needed.
+**/
+EFI_STATUS
+AllocateType4AndSetProcessorInformationStrings (
+  SMBIOS_TABLE_TYPE4  **Type4Record,
+  UINT8               ProcessorIndex,
+  BOOLEAN             Populated
+  )
+{
+  CHAR8  ProcessorStr[SMBIOS_STRING_MAX_LENGTH];
+  CHAR8  *StrStart;
+  UINTN  ProcessorStrLen;
+  UINTN  TotalSize;
+  UINTN  Index;
 
-  StrStart = OptionalStrStart + ProcessorStrLen + 1;
-  UnicodeStrToAsciiStrS (
-    ProcessorManuStr,
-    StrStart,
-    ProcessorManuStrLen + 1
-    );
+  // Processor Designation
+  ProcessorStrLen = AsciiSPrint (
+                      ProcessorStr,
+                      sizeof (ProcessorStr),
+                      "CPU%02d",
+                      ProcessorIndex + 1
+                      );
 
-  StrStart += ProcessorManuStrLen + 1;
-  UnicodeStrToAsciiStrS (
-    ProcessorVersionStr,
-    StrStart,
-    ProcessorVersionStrLen + 1
-    );
+  TotalSize = sizeof (SMBIOS_TABLE_TYPE4) +
+              ProcessorStrLen + 1 +
+              mProcessorStringsSize + 1;
 
-  StrStart += ProcessorVersionStrLen + 1;
-  UnicodeStrToAsciiStrS (
-    SerialNumberStr,
-    StrStart,
-    SerialNumberStrLen + 1
-    );
+  *Type4Record = AllocateZeroPool (TotalSize);
+  if (*Type4Record == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  StrStart += SerialNumberStrLen + 1;
-  UnicodeStrToAsciiStrS (
-    AssetTagStr,
-    StrStart,
-    AssetTagStrLen + 1
-    );
+  CopyMem (*Type4Record, &mSmbiosProcessorTableTemplate, sizeof (SMBIOS_TABLE_TYPE4));
 
-  StrStart += AssetTagStrLen + 1;
-  UnicodeStrToAsciiStrS (
-    PartNumberStr,
-    StrStart,
-    PartNumberStrLen + 1
-    );
+  StrStart = (CHAR8 *)(*Type4Record + 1);
+  CopyMem (StrStart, ProcessorStr, ProcessorStrLen + 1);
+  StrStart += ProcessorStrLen + 1;
 
-Exit:
-  FreePool (ProcessorStr);
-  FreePool (ProcessorManuStr);
-  FreePool (ProcessorVersionStr);
-  FreePool (SerialNumberStr);
-  FreePool (AssetTagStr);
-  FreePool (PartNumberStr);
+  for (Index = 0; Index < ProcessorStringMax; Index++) {
+    AsciiStrCpyS (StrStart, AsciiStrSize (mProcessorStrings[Index]), mProcessorStrings[Index]);
+    StrStart += AsciiStrSize (mProcessorStrings[Index]);
+  }
 
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -641,18 +677,16 @@ AddSmbiosProcessorTypeTable (
   IN UINTN  ProcessorIndex
   )
 {
-  EFI_STATUS                      Status;
-  SMBIOS_TABLE_TYPE4              *Type4Record;
-  EFI_SMBIOS_HANDLE               SmbiosHandle;
-  EFI_SMBIOS_HANDLE               L1CacheHandle;
-  EFI_SMBIOS_HANDLE               L2CacheHandle;
-  EFI_SMBIOS_HANDLE               L3CacheHandle;
-  UINT8                           *LegacyVoltage;
-  PROCESSOR_STATUS_DATA           ProcessorStatus;
-  UINT64                          *ProcessorId;
-  PROCESSOR_CHARACTERISTIC_FLAGS  ProcessorCharacteristics;
-  OEM_MISC_PROCESSOR_DATA         MiscProcessorData;
-  BOOLEAN                         ProcessorPopulated;
+  EFI_STATUS               Status;
+  SMBIOS_TABLE_TYPE4       *Type4Record;
+  EFI_SMBIOS_HANDLE        SmbiosHandle;
+  EFI_SMBIOS_HANDLE        L1CacheHandle;
+  EFI_SMBIOS_HANDLE        L2CacheHandle;
+  EFI_SMBIOS_HANDLE        L3CacheHandle;
+  UINT8                    *LegacyVoltage;
+  PROCESSOR_STATUS_DATA    ProcessorStatus;
+  OEM_MISC_PROCESSOR_DATA  MiscProcessorData;
+  BOOLEAN                  ProcessorPopulated;
 
   Type4Record = NULL;
 
@@ -710,18 +744,9 @@ AddSmbiosProcessorTypeTable (
   Type4Record->ThreadCount       = MiscProcessorData.ThreadCount;
   Type4Record->ThreadCount2      = MiscProcessorData.ThreadCount;
 
-  Type4Record->CurrentSpeed  = GetCpuFrequency (ProcessorIndex);
-  Type4Record->ExternalClock =
-    (UINT16)(SmbiosGetExternalClockFrequency () / 1000 / 1000);
-
-  ProcessorId  = (UINT64 *)&Type4Record->ProcessorId;
-  *ProcessorId = SmbiosGetProcessorId ();
+  Type4Record->CurrentSpeed = GetCpuFrequency (ProcessorIndex);
 
-  ProcessorCharacteristics               = SmbiosGetProcessorCharacteristics ();
-  Type4Record->ProcessorCharacteristics |= *((UINT64 *)&ProcessorCharacteristics);
-
-  Type4Record->ProcessorFamily  = SmbiosGetProcessorFamily ();
-  Type4Record->ProcessorFamily2 = SmbiosGetProcessorFamily2 ();
+  Type4Record->ProcessorCharacteristics |= mProcessorCharacteristics;
 
   SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
   Status       = mSmbios->Add (
@@ -764,6 +789,7 @@ ProcessorSubClassEntryPoint (
 {
   EFI_STATUS  Status;
   UINT32      ProcessorIndex;
+  UINT32      MaxProcessors;
 
   //
   // Locate dependent protocols
@@ -788,10 +814,23 @@ ProcessorSubClassEntryPoint (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Gather the descriptions that are shared by all sockets once, then stamp
+  // out the records of each socket from them.
+  //
+  Status = InitializeProcessorStrings ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  InitializeProcessorTemplate ();
+  InitializeCacheTemplates ();
+
   //
   // Add SMBIOS tables for populated sockets.
   //
-  for (ProcessorIndex = 0; ProcessorIndex < OemGetMaxProcessors (); ProcessorIndex++) {
+  MaxProcessors = OemGetMaxProcessors ();
+  for (ProcessorIndex = 0; ProcessorIndex < MaxProcessors; ProcessorIndex++) {
     Status = AddSmbiosProcessorTypeTable (ProcessorIndex);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "Add Processor Type Table Failed!  %r.\n", Status));
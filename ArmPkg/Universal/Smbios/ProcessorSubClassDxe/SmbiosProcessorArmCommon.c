@@ -18,6 +18,13 @@
 
 #include "SmbiosProcessor.h"
 
+//
+// Result of the SMCCC_ARCH_FEATURES query for SMCCC_ARCH_SOC_ID, which is
+// needed both for the Processor ID and the Processor Characteristics.
+//
+STATIC BOOLEAN  mArm64SocIdProbed;
+STATIC BOOLEAN  mArm64SocIdSupported;
+
 /** Returns the maximum cache level implemented by the current CPU.
 
     @return The maximum cache level implemented.
@@ -92,6 +99,10 @@ HasSmcArm64SocId (
   BOOLEAN  Arm64SocIdSupported;
   UINTN    SmcParam;
 
+  if (mArm64SocIdProbed) {
+    return mArm64SocIdSupported;
+  }
+
   Arm64SocIdSupported = FALSE;
 
   SmcCallStatus = ArmCallSmc0 (SMCCC_VERSION, NULL, NULL, NULL);
@@ -104,6 +115,9 @@ HasSmcArm64SocId (
     }
   }
 
+  mArm64SocIdSupported = Arm64SocIdSupported;
+  mArm64SocIdProbed    = TRUE;
+
   return Arm64SocIdSupported;
 }
 
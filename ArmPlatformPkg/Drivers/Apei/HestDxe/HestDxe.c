@@ -24,39 +24,77 @@
 #include <Protocol/AcpiTable.h>
 #include <Protocol/HestTable.h>
 
+//
+// Initial size of the buffer holding the HEST ACPI table. The buffer is
+// doubled whenever it runs out of space, so that appending N descriptor lists
+// costs O(log N) reallocations rather than one copy of the table per list.
+//
+#define HEST_TABLE_INITIAL_CAPACITY  SIZE_4KB
+
 typedef struct {
   VOID      *HestTable;       /// Pointer to HEST ACPI table.
   UINT32    CurrentTableSize; /// Current size of HEST ACPI table.
+  UINT32    Capacity;         /// Size of the buffer holding the HEST ACPI table.
 } HEST_DXE_DRIVER_DATA;
 
 STATIC EFI_ACPI_TABLE_PROTOCOL  *mAcpiTableProtocol = NULL;
 STATIC HEST_DXE_DRIVER_DATA     mHestDriverData;
 
 /**
-  Helper function to reallocate memory pool for every new error source descriptor
-  added.
+  Helper function to make room for the HEST table data in the memory pool.
+
+  The capacity of the pool grows geometrically, so the table is only copied
+  when the required size exceeds the current capacity.
 
-  @param[in]      OldTableSize  Old memory pool size.
-  @param[in]      NewTableSize  Required memory pool size.
-  @param[in, out] OldBuffer     Current memory buffer pointer holding the HEST
-                                table data.
+  @param[in]  RequiredSize  Required size of the HEST table data.
 
-  @retval                       New pointer to reallocated memory pool.
+  @retval EFI_SUCCESS           The pool can hold RequiredSize bytes.
+  @retval EFI_OUT_OF_RESOURCES  The pool could not be reallocated. The
+                                existing table data is preserved.
 
 **/
 STATIC
-VOID *
-ReallocateHestTableMemory (
-  IN     UINT32  OldTableSize,
-  IN     UINT32  NewTableSize,
-  IN OUT VOID    *OldBuffer
+EFI_STATUS
+ReserveHestTableMemory (
+  IN UINTN  RequiredSize
   )
 {
-  return ReallocateReservedPool (
-           OldTableSize,
-           NewTableSize,
-           OldBuffer
-           );
+  UINTN  NewCapacity;
+  VOID   *NewBuffer;
+
+  if (RequiredSize > MAX_UINT32) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (RequiredSize <= mHestDriverData.Capacity) {
+    return EFI_SUCCESS;
+  }
+
+  NewCapacity = MAX (mHestDriverData.Capacity, HEST_TABLE_INITIAL_CAPACITY);
+  while (NewCapacity < RequiredSize) {
+    //
+    // The capacity is kept in a UINT32, and UINTN may be no wider.
+    //
+    if (NewCapacity > MAX_UINT32 / 2) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    NewCapacity *= 2;
+  }
+
+  NewBuffer = ReallocateReservedPool (
+                mHestDriverData.CurrentTableSize,
+                NewCapacity,
+                mHestDriverData.HestTable
+                );
+  if (NewBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mHestDriverData.HestTable = NewBuffer;
+  mHestDriverData.Capacity  = (UINT32)NewCapacity;
+
+  return EFI_SUCCESS;
 }
 
 /**
@@ -74,18 +112,16 @@ BuildHestHeader (
 {
   EFI_ACPI_6_3_HARDWARE_ERROR_SOURCE_TABLE_HEADER  HestHeader;
   UINT64                                           TempOemTableId;
+  EFI_STATUS                                       Status;
 
   //
   // Allocate memory for the HEST ACPI table header.
   //
-  mHestDriverData.HestTable =
-    ReallocateHestTableMemory (
-      0,
-      sizeof (EFI_ACPI_6_3_HARDWARE_ERROR_SOURCE_TABLE_HEADER),
-      NULL
-      );
-  if (mHestDriverData.HestTable == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  Status = ReserveHestTableMemory (
+             sizeof (EFI_ACPI_6_3_HARDWARE_ERROR_SOURCE_TABLE_HEADER)
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   mHestDriverData.CurrentTableSize =
@@ -143,7 +179,7 @@ AppendErrorSourceDescriptor (
 {
   EFI_ACPI_6_3_HARDWARE_ERROR_SOURCE_TABLE_HEADER  *HestHeaderPtr;
   EFI_STATUS                                       Status;
-  UINT32                                           NewTableSize;
+  UINTN                                            NewTableSize;
   VOID                                             *ErrorDescriptorPtr;
 
   if (  (ErrorSourceDescriptorList == NULL)
@@ -168,19 +204,15 @@ AppendErrorSourceDescriptor (
   }
 
   //
-  // Resize the existing HEST table buffer to accommodate the incoming error source
-  // descriptors.
+  // Grow the existing HEST table buffer, if needed, to accommodate the incoming
+  // error source descriptors.
   //
   NewTableSize = mHestDriverData.CurrentTableSize +
                  ErrorSourceDescriptorListSize;
-  mHestDriverData.HestTable = ReallocateHestTableMemory (
-                                mHestDriverData.CurrentTableSize,
-                                NewTableSize,
-                                mHestDriverData.HestTable
-                                );
-  if (mHestDriverData.HestTable == NULL) {
+  Status = ReserveHestTableMemory (NewTableSize);
+  if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "HestDxe: Failed to reallocate memory for HEST table\n"));
-    return EFI_OUT_OF_RESOURCES;
+    return Status;
   }
 
   //
@@ -195,7 +227,7 @@ AppendErrorSourceDescriptor (
     ErrorSourceDescriptorList,
     ErrorSourceDescriptorListSize
     );
-  mHestDriverData.CurrentTableSize = NewTableSize;
+  mHestDriverData.CurrentTableSize = (UINT32)NewTableSize;
   HestHeaderPtr->Header.Length     = mHestDriverData.CurrentTableSize;
   HestHeaderPtr->ErrorSourceCount += ErrorSourceDescriptorCount;
 
@@ -264,6 +296,7 @@ InstallHestAcpiTable (
   // Free the HEST table buffer.
   //
   FreePool (mHestDriverData.HestTable);
+  ZeroMem (&mHestDriverData, sizeof (mHestDriverData));
   DEBUG ((DEBUG_INFO, "HestDxe: Installed HEST ACPI table \n"));
   return EFI_SUCCESS;
 }
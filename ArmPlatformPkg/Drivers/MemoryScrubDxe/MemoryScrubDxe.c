@@ -0,0 +1,445 @@
+/** @file
+  Clear all free system memory on every enabled processor in parallel.
+
+  Free memory is claimed from the memory map in batches, split into 2 MB
+  chunks, and the chunks are handed out through a shared counter to the boot
+  processor and to the application processors started by the MP services
+  protocol. The application processors run with the MMU and caches on, so
+  the chunks are zeroed with DC ZVA at the speed of the memory system rather
+  than of a single core. The throughput of each processor is reported when
+  the pass completes.
+
+  Memory is cleared when PcdMemoryScrubOnBoot is set, or when the OS
+  requested it with the ClearMemory bit of the MemoryOverwriteRequestControl
+  variable.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#include <Guid/MemoryOverwriteControl.h>
+#include <Protocol/MpService.h>
+
+#include "MemoryScrubDxe.h"
+
+STATIC EFI_MP_SERVICES_PROTOCOL  *mMpServices;
+STATIC EFI_EVENT                 mBatchDoneEvent;
+
+STATIC SCRUB_RANGE      mRanges[SCRUB_MAX_RANGES];
+STATIC UINTN            mRangeCount;
+STATIC UINT32           mChunkCount;
+STATIC volatile UINT32  mNextChunk;
+
+STATIC SCRUB_CPU_STATS  *mCpuStats;
+STATIC UINTN            mCpuCount;
+
+/**
+  Clear chunks of the current batch until none are left. Runs on the boot
+  processor and on all enabled application processors at the same time.
+
+  @param[in, out]  Buffer    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+ScrubWorker (
+  IN OUT VOID  *Buffer
+  )
+{
+  UINTN   CpuIndex;
+  UINTN   Range;
+  UINT32  Chunk;
+  UINT64  Offset;
+  UINT64  Length;
+  UINT64  Bytes;
+  UINT64  Start;
+
+  CpuIndex = 0;
+  if (mMpServices != NULL) {
+    mMpServices->WhoAmI (mMpServices, &CpuIndex);
+  }
+
+  Start = GetPerformanceCounter ();
+  Range = 0;
+  Bytes = 0;
+
+  for ( ; ;) {
+    Chunk = InterlockedIncrement (&mNextChunk) - 1;
+    if (Chunk >= mChunkCount) {
+      break;
+    }
+
+    //
+    // Each processor takes chunks in increasing order, so the range can be
+    // looked up from where the previous chunk was found.
+    //
+    while ((Range + 1 < mRangeCount) && (Chunk >= mRanges[Range + 1].FirstChunk)) {
+      Range++;
+    }
+
+    Offset = MultU64x32 (Chunk - mRanges[Range].FirstChunk, SCRUB_CHUNK_SIZE);
+    Length = MIN (SCRUB_CHUNK_SIZE, mRanges[Range].Length - Offset);
+    ScrubZeroBlocks ((VOID *)(UINTN)(mRanges[Range].Base + Offset), (UINTN)Length);
+    Bytes += Length;
+  }
+
+  if (CpuIndex < mCpuCount) {
+    mCpuStats[CpuIndex].Bytes += Bytes;
+    mCpuStats[CpuIndex].Ticks += GetPerformanceCounter () - Start;
+  }
+}
+
+/**
+  Clear the ranges of the current batch on all processors, and release them.
+
+**/
+STATIC
+VOID
+ScrubBatch (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+
+  if (mRangeCount == 0) {
+    return;
+  }
+
+  mChunkCount = 0;
+  for (Index = 0; Index < mRangeCount; Index++) {
+    mRanges[Index].FirstChunk = mChunkCount;
+    mChunkCount              += (UINT32)DivU64x32 (
+                                          mRanges[Index].Length + SCRUB_CHUNK_SIZE - 1,
+                                          SCRUB_CHUNK_SIZE
+                                          );
+  }
+
+  mNextChunk = 0;
+
+  Status = EFI_NOT_STARTED;
+  if (mMpServices != NULL) {
+    Status = mMpServices->StartupAllAPs (
+                            mMpServices,
+                            ScrubWorker,
+                            FALSE,
+                            mBatchDoneEvent,
+                            0,
+                            NULL,
+                            NULL
+                            );
+  }
+
+  ScrubWorker (NULL);
+
+  if (!EFI_ERROR (Status)) {
+    gBS->WaitForEvent (1, &mBatchDoneEvent, &Index);
+  }
+
+  for (Index = 0; Index < mRangeCount; Index++) {
+    gBS->FreePages (
+           mRanges[Index].Base,
+           EFI_SIZE_TO_PAGES ((UINTN)mRanges[Index].Length)
+           );
+  }
+
+  mRangeCount = 0;
+}
+
+/**
+  Claim a free memory range, and add it to the current batch. The batch is
+  cleared first if it is full.
+
+  @param[in]  Base      The base of the range.
+  @param[in]  Length    The size of the range, at most SCRUB_BATCH_SIZE.
+  @param[in]  Batched   The number of bytes in the current batch.
+
+  @return The number of bytes in the current batch after adding the range.
+
+**/
+STATIC
+UINT64
+AddRangeToBatch (
+  IN EFI_PHYSICAL_ADDRESS  Base,
+  IN UINT64                Length,
+  IN UINT64                Batched
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((mRangeCount == SCRUB_MAX_RANGES) || (Batched + Length > SCRUB_BATCH_SIZE)) {
+    ScrubBatch ();
+    Batched = 0;
+  }
+
+  //
+  // The range may have been allocated since the memory map was retrieved.
+  //
+  Status = gBS->AllocatePages (
+                  AllocateAddress,
+                  EfiBootServicesData,
+                  EFI_SIZE_TO_PAGES ((UINTN)Length),
+                  &Base
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_WARN,
+      "%a: skipping 0x%lx - 0x%lx: %r\n",
+      __FUNCTION__,
+      Base,
+      Base + Length - 1,
+      Status
+      ));
+    return Batched;
+  }
+
+  mRanges[mRangeCount].Base   = Base;
+  mRanges[mRangeCount].Length = Length;
+  mRangeCount++;
+
+  return Batched + Length;
+}
+
+/**
+  Retrieve a snapshot of the memory map.
+
+  @param[out]  MemoryMapSize    The size of the memory map in bytes.
+  @param[out]  DescriptorSize   The size of a descriptor in bytes.
+
+  @return The memory map, or NULL on failure. It must be freed by the caller.
+
+**/
+STATIC
+EFI_MEMORY_DESCRIPTOR *
+GetMemoryMapSnapshot (
+  OUT UINTN  *MemoryMapSize,
+  OUT UINTN  *DescriptorSize
+  )
+{
+  EFI_STATUS             Status;
+  EFI_MEMORY_DESCRIPTOR  *MemoryMap;
+  UINTN                  MapKey;
+  UINT32                 DescriptorVersion;
+
+  *MemoryMapSize = 0;
+  MemoryMap      = NULL;
+  do {
+    Status = gBS->GetMemoryMap (
+                    MemoryMapSize,
+                    MemoryMap,
+                    &MapKey,
+                    DescriptorSize,
+                    &DescriptorVersion
+                    );
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      if (MemoryMap != NULL) {
+        FreePool (MemoryMap);
+      }
+
+      //
+      // Leave room for the descriptors the allocation itself may add.
+      //
+      *MemoryMapSize += 4 * *DescriptorSize;
+      MemoryMap       = AllocatePool (*MemoryMapSize);
+      if (MemoryMap == NULL) {
+        return NULL;
+      }
+    }
+  } while (Status == EFI_BUFFER_TOO_SMALL);
+
+  if (EFI_ERROR (Status)) {
+    if (MemoryMap != NULL) {
+      FreePool (MemoryMap);
+    }
+
+    return NULL;
+  }
+
+  return MemoryMap;
+}
+
+/**
+  Report the amount of memory each processor cleared and its throughput.
+
+  @param[in]  ElapsedTicks    The duration of the whole pass.
+
+**/
+STATIC
+VOID
+ReportThroughput (
+  IN UINT64  ElapsedTicks
+  )
+{
+  UINTN   Index;
+  UINT64  Nanoseconds;
+  UINT64  Total;
+
+  Total = 0;
+  for (Index = 0; Index < mCpuCount; Index++) {
+    if (mCpuStats[Index].Bytes == 0) {
+      continue;
+    }
+
+    Total      += mCpuStats[Index].Bytes;
+    Nanoseconds = MAX (GetTimeInNanoSecond (mCpuStats[Index].Ticks), 1);
+    DEBUG ((
+      DEBUG_INFO,
+      "%a: CPU %u cleared %Lu MB in %Lu ms (%Lu MB/s)\n",
+      __FUNCTION__,
+      (UINT32)Index,
+      RShiftU64 (mCpuStats[Index].Bytes, 20),
+      DivU64x32 (Nanoseconds, 1000000),
+      DivU64x64Remainder (MultU64x32 (mCpuStats[Index].Bytes, 1000), Nanoseconds, NULL)
+      ));
+  }
+
+  Nanoseconds = MAX (GetTimeInNanoSecond (ElapsedTicks), 1);
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: cleared %Lu MB in %Lu ms (%Lu MB/s) on %u processors\n",
+    __FUNCTION__,
+    RShiftU64 (Total, 20),
+    DivU64x32 (Nanoseconds, 1000000),
+    DivU64x64Remainder (MultU64x32 (Total, 1000), Nanoseconds, NULL),
+    (UINT32)mCpuCount
+    ));
+}
+
+/**
+  Clear all the free memory in the memory map.
+
+  @retval EFI_SUCCESS             The free memory was cleared.
+  @retval EFI_OUT_OF_RESOURCES    Memory allocation failed.
+
+**/
+STATIC
+EFI_STATUS
+ScrubFreeMemory (
+  VOID
+  )
+{
+  EFI_STATUS             Status;
+  EFI_MEMORY_DESCRIPTOR  *MemoryMap;
+  EFI_MEMORY_DESCRIPTOR  *Desc;
+  UINTN                  MemoryMapSize;
+  UINTN                  DescriptorSize;
+  UINTN                  EnabledCount;
+  UINTN                  Offset;
+  EFI_PHYSICAL_ADDRESS   Base;
+  UINT64                 Remaining;
+  UINT64                 Length;
+  UINT64                 Batched;
+  UINT64                 Start;
+
+  mCpuCount = 1;
+  Status    = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **)&mMpServices);
+  if (!EFI_ERROR (Status)) {
+    Status = mMpServices->GetNumberOfProcessors (mMpServices, &mCpuCount, &EnabledCount);
+    ASSERT_EFI_ERROR (Status);
+  } else {
+    mMpServices = NULL;
+  }
+
+  mCpuStats = AllocateZeroPool (mCpuCount * sizeof (SCRUB_CPU_STATS));
+  if (mCpuStats == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &mBatchDoneEvent);
+  if (EFI_ERROR (Status)) {
+    FreePool (mCpuStats);
+    return Status;
+  }
+
+  MemoryMap = GetMemoryMapSnapshot (&MemoryMapSize, &DescriptorSize);
+  if (MemoryMap == NULL) {
+    gBS->CloseEvent (mBatchDoneEvent);
+    FreePool (mCpuStats);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Start   = GetPerformanceCounter ();
+  Batched = 0;
+  for (Offset = 0; Offset < MemoryMapSize; Offset += DescriptorSize) {
+    Desc = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)MemoryMap + Offset);
+    if ((Desc->Type != EfiConventionalMemory) ||
+        ((Desc->Attribute & EFI_MEMORY_WB) == 0))
+    {
+      continue;
+    }
+
+    Base      = Desc->PhysicalStart;
+    Remaining = EFI_PAGES_TO_SIZE (Desc->NumberOfPages);
+    while (Remaining > 0) {
+      Length     = MIN (Remaining, SCRUB_BATCH_SIZE);
+      Batched    = AddRangeToBatch (Base, Length, Batched);
+      Base      += Length;
+      Remaining -= Length;
+    }
+  }
+
+  ScrubBatch ();
+
+  ReportThroughput (GetPerformanceCounter () - Start);
+
+  FreePool (MemoryMap);
+  gBS->CloseEvent (mBatchDoneEvent);
+  FreePool (mCpuStats);
+  return EFI_SUCCESS;
+}
+
+/**
+  Entry point of the driver. Clears the free memory if the platform or the
+  OS requested it.
+
+  @param[in]  ImageHandle   The image handle of this driver.
+  @param[in]  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   Memory was cleared, or did not need to be.
+  @retval other         Memory could not be cleared.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryScrubDxeInitialize (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       MorControl;
+  UINTN       Size;
+
+  if (!FeaturePcdGet (PcdMemoryScrubOnBoot)) {
+    Size   = sizeof (MorControl);
+    Status = gRT->GetVariable (
+                    MEMORY_OVERWRITE_REQUEST_VARIABLE_NAME,
+                    &gEfiMemoryOverwriteControlDataGuid,
+                    NULL,
+                    &Size,
+                    &MorControl
+                    );
+    if (EFI_ERROR (Status) || (Size != sizeof (MorControl)) ||
+        (MOR_CLEAR_MEMORY_VALUE (MorControl) == 0))
+    {
+      return EFI_SUCCESS;
+    }
+
+    DEBUG ((DEBUG_INFO, "%a: memory overwrite requested\n", __FUNCTION__));
+  }
+
+  return ScrubFreeMemory ();
+}
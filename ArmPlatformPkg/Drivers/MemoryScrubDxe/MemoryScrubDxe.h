@@ -0,0 +1,53 @@
+/** @file
+  Internal definitions of the parallel memory scrubbing driver.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MEMORY_SCRUB_DXE_H_
+#define MEMORY_SCRUB_DXE_H_
+
+//
+// Unit of work handed to a processor. Free memory is claimed and cleared in
+// batches of at most SCRUB_BATCH_SIZE bytes, so that the rest of the free
+// memory stays available to the event notification functions that may run
+// while a batch is being cleared.
+//
+#define SCRUB_CHUNK_SIZE  SIZE_2MB
+#define SCRUB_BATCH_SIZE  SIZE_1GB
+#define SCRUB_MAX_RANGES  64
+
+typedef struct {
+  EFI_PHYSICAL_ADDRESS    Base;
+  UINT64                  Length;
+  //
+  // Index of the first chunk of this range in the batch.
+  //
+  UINT32                  FirstChunk;
+} SCRUB_RANGE;
+
+typedef struct {
+  UINT64    Bytes;
+  UINT64    Ticks;
+} SCRUB_CPU_STATS;
+
+/**
+  Zero a page aligned memory region with DC ZVA, or with 64 byte stores of
+  the zero register when DC ZVA is prohibited.
+
+  The region must be mapped as Normal memory.
+
+  @param[in]  Base      The base of the region, aligned to 4 KB.
+  @param[in]  Length    The size of the region, a non-zero multiple of 4 KB.
+
+**/
+VOID
+EFIAPI
+ScrubZeroBlocks (
+  IN VOID   *Base,
+  IN UINTN  Length
+  );
+
+#endif // MEMORY_SCRUB_DXE_H_
@@ -11,6 +11,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PcdLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/HobLib.h>
 #include <Library/DxeServicesTableLib.h>
 
@@ -340,16 +341,18 @@ NorFlashInitialise (
   NOR_FLASH_DESCRIPTION  *NorFlashDevices;
   BOOLEAN                ContainVariableStorage;
 
+  PERF_INMODULE_BEGIN ("NorFlashInit");
+
   Status = NorFlashPlatformInitialization ();
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "NorFlashInitialise: Fail to initialize Nor Flash devices\n"));
-    return Status;
+    goto Exit;
   }
 
   Status = NorFlashPlatformGetDevices (&NorFlashDevices, &mNorFlashDeviceCount);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "NorFlashInitialise: Fail to get Nor Flash devices\n"));
-    return Status;
+    goto Exit;
   }
 
   mNorFlashInstances = AllocateRuntimePool (sizeof (NOR_FLASH_INSTANCE *) * mNorFlashDeviceCount);
@@ -396,6 +399,8 @@ NorFlashInitialise (
                   );
   ASSERT_EFI_ERROR (Status);
 
+Exit:
+  PERF_INMODULE_END ("NorFlashInit");
   return Status;
 }
 
@@ -0,0 +1,533 @@
+/** @file
+  Buffered, interrupt driven transmit engine for the PL011 UART.
+
+  Serial output produced in the DXE phase is copied into a RAM ring buffer and
+  drained into the PL011 transmit FIFO from the UART transmit interrupt. When
+  no interrupt is wired up for the UART, a periodic timer event is used to
+  drain the ring instead.
+
+  The ring buffer is always manipulated at TPL_HIGH_LEVEL. Output that the
+  asynchronous drain could not send while its writer keeps running flushes the
+  ring and is then sent synchronously. That is output produced with interrupts
+  disabled (exception handlers, interrupt handlers, code running at
+  TPL_HIGH_LEVEL), and, when the ring is drained from the timer, output
+  produced at or above the TPL of the timer.
+
+  ASSERT messages written through DxePL011SerialPortLib flush the ring and are
+  sent synchronously. Other output, including DEBUG_ERROR messages, is only
+  queued. The transmit buffer is also published as a configuration table, so
+  that modules linked against DxePL011SerialPortLib find it without boot
+  services. This includes CpuDxe, whose exception handler, e.g. for
+  CpuBreakpoint(), writes with interrupts disabled and so flushes the ring
+  first. A debugger that halts the CPU directly, on the other hand, may find
+  part of the last messages still in the ring.
+
+  Modules that are not linked against DxePL011SerialPortLib, such as the DXE
+  core and runtime drivers, write straight to the transmit FIFO, so their
+  output may appear ahead of output still queued in the ring.
+
+  The ring is also flushed at ResetSystem() and ExitBootServices(), after
+  which all output is polled.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PL011UartLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include <Protocol/HardwareInterrupt.h>
+#include <Protocol/PL011TxBuffer.h>
+#include <Protocol/ResetNotification.h>
+
+//
+// TPL of the timer event that drains the ring when no interrupt is wired.
+//
+#define PL011_DRAIN_TPL  TPL_NOTIFY
+
+STATIC UINTN                            mUartBase;
+STATIC UINT8                            *mRing;
+STATIC UINT32                           mRingSize;
+STATIC UINT32                           mRingMask;
+
+//
+// Free running producer and consumer indices. The number of pending bytes is
+// always (mHead - mTail), the ring offset is obtained by masking.
+//
+STATIC UINT32                           mHead;
+STATIC UINT32                           mTail;
+
+STATIC UINT64                           mOverrunCount;
+STATIC BOOLEAN                          mPassThrough;
+
+STATIC EFI_HARDWARE_INTERRUPT_PROTOCOL  *mInterrupt;
+STATIC EFI_EVENT                        mDrainEvent;
+STATIC EFI_EVENT                        mExitBootServicesEvent;
+STATIC VOID                             *mInterruptRegistration;
+STATIC VOID                             *mResetNotifyRegistration;
+
+/**
+  Move as many pending bytes as possible from the ring into the transmit FIFO
+  without waiting, and arm the transmit interrupt if data is left behind.
+
+  Must be called at TPL_HIGH_LEVEL or with interrupts disabled.
+**/
+STATIC
+VOID
+DrainToFifo (
+  VOID
+  )
+{
+  UINT32  Offset;
+  UINT32  Chunk;
+  UINTN   Written;
+
+  while (mHead != mTail) {
+    Offset  = mTail & mRingMask;
+    Chunk   = MIN (mHead - mTail, mRingSize - Offset);
+    Written = PL011UartWriteNoWait (mUartBase, &mRing[Offset], Chunk);
+    mTail  += (UINT32)Written;
+    if (Written < Chunk) {
+      break;
+    }
+  }
+
+  if (mInterrupt != NULL) {
+    PL011UartSetTxInterrupt (mUartBase, (BOOLEAN)(mHead != mTail));
+  }
+}
+
+/**
+  Send all the pending bytes in the ring, waiting for the transmit FIFO as
+  needed.
+
+  Must be called at TPL_HIGH_LEVEL or with interrupts disabled.
+**/
+STATIC
+VOID
+FlushRing (
+  VOID
+  )
+{
+  UINT32  Offset;
+  UINT32  Chunk;
+
+  while (mHead != mTail) {
+    Offset = mTail & mRingMask;
+    Chunk  = MIN (mHead - mTail, mRingSize - Offset);
+    mTail += (UINT32)PL011UartWrite (mUartBase, &mRing[Offset], Chunk);
+  }
+
+  if (mInterrupt != NULL) {
+    PL011UartSetTxInterrupt (mUartBase, FALSE);
+  }
+}
+
+/**
+  Check whether the asynchronous drain can make progress for a caller.
+
+  @param[out] OldTpl  The TPL to restore if TRUE is returned.
+
+  @retval TRUE   The ring is now locked at TPL_HIGH_LEVEL and may be used.
+  @retval FALSE  The caller runs with interrupts disabled, at a TPL that
+                 blocks the drain timer, or after ExitBootServices(), and
+                 must send its output synchronously.
+**/
+STATIC
+BOOLEAN
+AcquireRing (
+  OUT EFI_TPL  *OldTpl
+  )
+{
+  if (mPassThrough || !GetInterruptState ()) {
+    return FALSE;
+  }
+
+  *OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  if ((*OldTpl == TPL_HIGH_LEVEL) ||
+      ((mInterrupt == NULL) && (*OldTpl >= PL011_DRAIN_TPL)))
+  {
+    gBS->RestoreTPL (*OldTpl);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Queue data for transmission on the serial device.
+
+  @param[in]  Buffer         Point of data buffer which need to be written.
+  @param[in]  NumberOfBytes  Number of output bytes which are cached in Buffer.
+
+  @retval  The number of bytes accepted, which is always NumberOfBytes.
+
+**/
+STATIC
+UINTN
+EFIAPI
+PL011TxBufferWrite (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  EFI_TPL  OldTpl;
+  UINT32   Offset;
+  UINT32   Chunk;
+  UINTN    Remaining;
+
+  if ((Buffer == NULL) || (NumberOfBytes == 0)) {
+    return 0;
+  }
+
+  if (!AcquireRing (&OldTpl)) {
+    FlushRing ();
+    return PL011UartWrite (mUartBase, Buffer, NumberOfBytes);
+  }
+
+  Remaining = NumberOfBytes;
+  if (Remaining > mRingSize - (mHead - mTail)) {
+    mOverrunCount++;
+    FlushRing ();
+
+    //
+    // Whatever exceeds the ring capacity goes out synchronously, so that the
+    // tail end of the message is what remains queued.
+    //
+    if (Remaining > mRingSize) {
+      PL011UartWrite (mUartBase, Buffer, Remaining - mRingSize);
+      Buffer   += Remaining - mRingSize;
+      Remaining = mRingSize;
+    }
+  }
+
+  while (Remaining > 0) {
+    Offset = mHead & mRingMask;
+    Chunk  = (UINT32)MIN (Remaining, mRingSize - Offset);
+    CopyMem (&mRing[Offset], Buffer, Chunk);
+    mHead     += Chunk;
+    Buffer    += Chunk;
+    Remaining -= Chunk;
+  }
+
+  DrainToFifo ();
+
+  gBS->RestoreTPL (OldTpl);
+  return NumberOfBytes;
+}
+
+/**
+  Synchronously send all the data queued in the ring buffer.
+**/
+STATIC
+VOID
+EFIAPI
+PL011TxBufferFlush (
+  VOID
+  )
+{
+  EFI_TPL  OldTpl;
+
+  if (!AcquireRing (&OldTpl)) {
+    FlushRing ();
+    return;
+  }
+
+  FlushRing ();
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Retrieve the number of times the ring buffer was found full and had to be
+  drained synchronously by a writer.
+
+  @retval  The overrun count.
+**/
+STATIC
+UINT64
+EFIAPI
+PL011TxBufferGetOverrunCount (
+  VOID
+  )
+{
+  return mOverrunCount;
+}
+
+STATIC PL011_TX_BUFFER_PROTOCOL  mPL011TxBuffer = {
+  PL011TxBufferWrite,
+  PL011TxBufferFlush,
+  PL011TxBufferGetOverrunCount
+};
+
+/**
+  PL011 interrupt handler, refills the transmit FIFO from the ring.
+
+  @param  Source          Source of the interrupt.
+  @param  SystemContext   System context at the time of the interrupt.
+**/
+STATIC
+VOID
+EFIAPI
+PL011TxInterruptHandler (
+  IN  HARDWARE_INTERRUPT_SOURCE  Source,
+  IN  EFI_SYSTEM_CONTEXT         SystemContext
+  )
+{
+  DrainToFifo ();
+  mInterrupt->EndOfInterrupt (mInterrupt, Source);
+}
+
+/**
+  Periodic timer callback used to drain the ring when the UART interrupt is
+  not wired up, or not yet registered.
+
+  @param  Event     The timer event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+DrainTimerNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  DrainToFifo ();
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Switch from timer to interrupt driven draining once the interrupt
+  controller is available.
+
+  @param  Event     The protocol notification event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+OnHardwareInterruptInstalled (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_HARDWARE_INTERRUPT_PROTOCOL  *Interrupt;
+  EFI_TPL                          OldTpl;
+
+  Status = gBS->LocateProtocol (
+                  &gHardwareInterruptProtocolGuid,
+                  NULL,
+                  (VOID **)&Interrupt
+                  );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  gBS->CloseEvent (Event);
+
+  Status = Interrupt->RegisterInterruptSource (
+                        Interrupt,
+                        FixedPcdGet32 (PL011UartInterrupt),
+                        PL011TxInterruptHandler
+                        );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: failed to register UART interrupt - %r, draining on timer\n",
+      __FUNCTION__,
+      Status
+      ));
+    return;
+  }
+
+  OldTpl     = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  mInterrupt = Interrupt;
+  DrainToFifo ();
+  gBS->RestoreTPL (OldTpl);
+
+  gBS->SetTimer (mDrainEvent, TimerCancel, 0);
+}
+
+/**
+  Flush pending output before the platform is reset.
+
+  @param[in]  ResetType     The type of reset to perform.
+  @param[in]  ResetStatus   The status code for the reset.
+  @param[in]  DataSize      The size, in bytes, of ResetData.
+  @param[in]  ResetData     Optional reset data.
+**/
+STATIC
+VOID
+EFIAPI
+OnResetSystem (
+  IN EFI_RESET_TYPE  ResetType,
+  IN EFI_STATUS      ResetStatus,
+  IN UINTN           DataSize,
+  IN VOID            *ResetData OPTIONAL
+  )
+{
+  PL011TxBufferFlush ();
+}
+
+/**
+  Register the reset notification once the protocol is available.
+
+  @param  Event     The protocol notification event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+OnResetNotificationInstalled (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_RESET_NOTIFICATION_PROTOCOL  *ResetNotify;
+
+  Status = gBS->LocateProtocol (
+                  &gEfiResetNotificationProtocolGuid,
+                  NULL,
+                  (VOID **)&ResetNotify
+                  );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  gBS->CloseEvent (Event);
+
+  Status = ResetNotify->RegisterResetNotify (ResetNotify, OnResetSystem);
+  ASSERT_EFI_ERROR (Status);
+}
+
+/**
+  On exiting boot services, flush the ring and fall back to polled output.
+
+  @param  Event     The ExitBootServices event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+OnExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  gBS->SetTimer (mDrainEvent, TimerCancel, 0);
+
+  PL011TxBufferFlush ();
+  mPassThrough = TRUE;
+
+  if (mInterrupt != NULL) {
+    mInterrupt->DisableInterruptSource (mInterrupt, FixedPcdGet32 (PL011UartInterrupt));
+  }
+}
+
+/**
+  Allocate the ring buffer and install the PL011 transmit buffer protocol.
+
+  @param  ImageHandle   of the loaded driver
+  @param  SystemTable   Pointer to the System Table
+
+  @retval EFI_SUCCESS           Protocol installed
+  @retval EFI_UNSUPPORTED       No UART or no ring buffer configured
+  @retval EFI_OUT_OF_RESOURCES  Cannot allocate the ring buffer
+
+**/
+EFI_STATUS
+EFIAPI
+PL011SerialBufferInitialize (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  EFI_HANDLE  Handle;
+
+  mUartBase = (UINTN)PcdGet64 (PcdSerialRegisterBase);
+  mRingSize = FixedPcdGet32 (PcdPL011TxBufferSize);
+  if ((mUartBase == 0) || (mRingSize == 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ASSERT ((mRingSize & (mRingSize - 1)) == 0);
+  mRingMask = mRingSize - 1;
+
+  mRing = AllocatePool (mRingSize);
+  if (mRing == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  PL011_DRAIN_TPL,
+                  DrainTimerNotify,
+                  NULL,
+                  &mDrainEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->SetTimer (
+                  mDrainEvent,
+                  TimerPeriodic,
+                  FixedPcdGet32 (PcdPL011TxBufferDrainPeriod)
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  OnExitBootServices,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &mExitBootServicesEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  if (FixedPcdGet32 (PL011UartInterrupt) != 0) {
+    EfiCreateProtocolNotifyEvent (
+      &gHardwareInterruptProtocolGuid,
+      TPL_CALLBACK,
+      OnHardwareInterruptInstalled,
+      NULL,
+      &mInterruptRegistration
+      );
+  }
+
+  EfiCreateProtocolNotifyEvent (
+    &gEfiResetNotificationProtocolGuid,
+    TPL_CALLBACK,
+    OnResetNotificationInstalled,
+    NULL,
+    &mResetNotifyRegistration
+    );
+
+  Handle = NULL;
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Handle,
+                  &gPL011TxBufferProtocolGuid,
+                  &mPL011TxBuffer,
+                  NULL
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->InstallConfigurationTable (&gPL011TxBufferProtocolGuid, &mPL011TxBuffer);
+  ASSERT_EFI_ERROR (Status);
+
+  return Status;
+}
@@ -25,6 +25,49 @@
 
 PLATFORM_GPIO_CONTROLLER  *mPL061PlatformGpio;
 
+STATIC PL061_INTERRUPT_STATE            *mPL061Interrupts;
+STATIC UINTN                            mPL061LastController;
+STATIC EFI_HARDWARE_INTERRUPT_PROTOCOL  *mInterrupt;
+STATIC EFI_EVENT                        mDispatchEvent;
+STATIC EFI_EVENT                        mPollEvent;
+STATIC BOOLEAN                          mPolling;
+STATIC EFI_EVENT                        mExitBootServicesEvent;
+STATIC VOID                             *mInterruptRegistration;
+
+STATIC
+BOOLEAN
+PL061OwnsPin (
+  IN UINTN              Index,
+  IN EMBEDDED_GPIO_PIN  Gpio
+  )
+{
+  GPIO_CONTROLLER  *Controller;
+
+  Controller = &mPL061PlatformGpio->GpioController[Index];
+  return (BOOLEAN)(  (Gpio >= Controller->GpioIndex)
+                  && (Gpio < Controller->GpioIndex + Controller->InternalGpioCount));
+}
+
+/**
+  Get the bits of the pins a controller implements.
+
+  @param[in]  Index   The index of the controller.
+
+  @return The mask of the pins of the controller.
+
+**/
+STATIC
+UINT8
+PL061ControllerPins (
+  IN UINTN  Index
+  )
+{
+  UINTN  Count;
+
+  Count = MIN (mPL061PlatformGpio->GpioController[Index].InternalGpioCount, PL061_GPIO_PINS);
+  return (UINT8)((1U << Count) - 1);
+}
+
 EFI_STATUS
 EFIAPI
 PL061Locate (
@@ -34,20 +77,29 @@ PL061Locate (
   OUT UINTN              *RegisterBase
   )
 {
-  UINT32  Index;
+  UINTN  Index;
 
-  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
-    if (  (Gpio >= mPL061PlatformGpio->GpioController[Index].GpioIndex)
-       &&  (Gpio < mPL061PlatformGpio->GpioController[Index].GpioIndex
-            + mPL061PlatformGpio->GpioController[Index].InternalGpioCount))
-    {
-      *ControllerIndex  = Index;
-      *ControllerOffset = Gpio % mPL061PlatformGpio->GpioController[Index].InternalGpioCount;
-      *RegisterBase     = mPL061PlatformGpio->GpioController[Index].RegisterBase;
-      return EFI_SUCCESS;
+  //
+  // Consecutive calls usually target the same controller, e.g. when bit
+  // banging a bus, so try the last one first.
+  //
+  Index = mPL061LastController;
+  if ((Index >= mPL061PlatformGpio->GpioControllerCount) || !PL061OwnsPin (Index, Gpio)) {
+    for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+      if (PL061OwnsPin (Index, Gpio)) {
+        break;
+      }
     }
   }
 
+  if (Index < mPL061PlatformGpio->GpioControllerCount) {
+    mPL061LastController = Index;
+    *ControllerIndex     = Index;
+    *ControllerOffset    = Gpio - mPL061PlatformGpio->GpioController[Index].GpioIndex;
+    *RegisterBase        = mPL061PlatformGpio->GpioController[Index].RegisterBase;
+    return EFI_SUCCESS;
+  }
+
   DEBUG ((DEBUG_ERROR, "%a, failed to locate gpio %d\n", __func__, Gpio));
   return EFI_INVALID_PARAMETER;
 }
@@ -103,6 +155,136 @@ PL061SetPins (
   MmioWrite8 (PL061EffectiveAddress (Address, Mask), Value);
 }
 
+/**
+  Make pins outputs, skipping the write of the direction register when they
+  already are, which is the common case when bit banging.
+
+  @param[in]  Address   The base of the controller.
+  @param[in]  Mask      The pins to make outputs.
+
+**/
+STATIC
+VOID
+PL061SetOutputs (
+  IN UINTN  Address,
+  IN UINTN  Mask
+  )
+{
+  UINT8  Direction;
+
+  Direction = MmioRead8 (Address + PL061_GPIO_DIR_REG);
+  if ((Direction & Mask) != Mask) {
+    MmioWrite8 (Address + PL061_GPIO_DIR_REG, (UINT8)(Direction | Mask));
+  }
+}
+
+/**
+  Convert the bits of a pin set into the bits of a controller.
+
+  @param[in]  Index   The index of the controller.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Bits    The bits of the pin set.
+
+  @return The bits of the controller matching the bits of the pin set.
+
+**/
+STATIC
+UINT8
+PL061ControllerBits (
+  IN UINTN              Index,
+  IN EMBEDDED_GPIO_PIN  Gpio,
+  IN UINT64             Bits
+  )
+{
+  EMBEDDED_GPIO_PIN  First;
+
+  First = mPL061PlatformGpio->GpioController[Index].GpioIndex;
+  if (First >= Gpio) {
+    if (First - Gpio >= 64) {
+      return 0;
+    }
+
+    return (UINT8)RShiftU64 (Bits, First - Gpio) & PL061ControllerPins (Index);
+  }
+
+  if (Gpio - First >= mPL061PlatformGpio->GpioController[Index].InternalGpioCount) {
+    return 0;
+  }
+
+  return (UINT8)LShiftU64 (Bits, Gpio - First) & PL061ControllerPins (Index);
+}
+
+/**
+  Convert the bits of a controller into the bits of a pin set.
+
+  @param[in]  Index   The index of the controller.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Bits    The bits of the controller.
+
+  @return The bits of the pin set matching the bits of the controller.
+
+**/
+STATIC
+UINT64
+PL061PinSetBits (
+  IN UINTN              Index,
+  IN EMBEDDED_GPIO_PIN  Gpio,
+  IN UINT8              Bits
+  )
+{
+  EMBEDDED_GPIO_PIN  First;
+
+  Bits &= PL061ControllerPins (Index);
+
+  First = mPL061PlatformGpio->GpioController[Index].GpioIndex;
+  if (First >= Gpio) {
+    if (First - Gpio >= 64) {
+      return 0;
+    }
+
+    return LShiftU64 (Bits, First - Gpio);
+  }
+
+  if (Gpio - First >= mPL061PlatformGpio->GpioController[Index].InternalGpioCount) {
+    return 0;
+  }
+
+  return Bits >> (Gpio - First);
+}
+
+/**
+  Check that all the pins of a set exist.
+
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Mask    The pins of the set.
+
+  @retval EFI_SUCCESS             All the pins exist.
+  @retval EFI_INVALID_PARAMETER   A pin does not exist.
+
+**/
+STATIC
+EFI_STATUS
+PL061CheckPinSet (
+  IN EMBEDDED_GPIO_PIN  Gpio,
+  IN UINT64             Mask
+  )
+{
+  UINTN   Index;
+  UINT64  Covered;
+
+  Covered = 0;
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    Covered |= PL061PinSetBits (Index, Gpio, PL061ControllerPins (Index));
+  }
+
+  if ((Mask & ~Covered) != 0) {
+    DEBUG ((DEBUG_ERROR, "%a, invalid gpio set %d/0x%lx\n", __func__, Gpio, Mask));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Function implementations
 **/
@@ -121,7 +303,9 @@ PL061Identify (
   }
 
   for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
-    if (mPL061PlatformGpio->GpioController[Index].InternalGpioCount != PL061_GPIO_PINS) {
+    if (  (mPL061PlatformGpio->GpioController[Index].InternalGpioCount == 0)
+       || (mPL061PlatformGpio->GpioController[Index].InternalGpioCount > PL061_GPIO_PINS))
+    {
       return EFI_INVALID_PARAMETER;
     }
 
@@ -236,14 +420,14 @@ Set (
 
     case GPIO_MODE_OUTPUT_0:
       // Set the corresponding direction bit to HIGH for output
-      MmioOr8 (RegisterBase + PL061_GPIO_DIR_REG, GPIO_PIN_MASK (Offset));
+      PL061SetOutputs (RegisterBase, GPIO_PIN_MASK (Offset));
       // Set the corresponding data bit to LOW for 0
       PL061SetPins (RegisterBase, GPIO_PIN_MASK (Offset), 0);
       break;
 
     case GPIO_MODE_OUTPUT_1:
       // Set the corresponding direction bit to HIGH for output
-      MmioOr8 (RegisterBase + PL061_GPIO_DIR_REG, GPIO_PIN_MASK (Offset));
+      PL061SetOutputs (RegisterBase, GPIO_PIN_MASK (Offset));
       // Set the corresponding data bit to HIGH for 1
       PL061SetPins (RegisterBase, GPIO_PIN_MASK (Offset), 0xff);
       break;
@@ -347,6 +531,661 @@ EMBEDDED_GPIO  gGpio = {
   SetPull
 };
 
+/**
+  Read the state of a set of pins.
+
+  @param[in]  This    The protocol instance.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Mask    The pins of the set.
+  @param[out] Value   The state of the pins of the set.
+
+  @retval EFI_SUCCESS             The state of the pins was returned.
+  @retval EFI_INVALID_PARAMETER   Value is NULL, or a pin does not exist.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PL061GetPinSet (
+  IN  PL061_GPIO_PROTOCOL  *This,
+  IN  EMBEDDED_GPIO_PIN    Gpio,
+  IN  UINT64               Mask,
+  OUT UINT64               *Value
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINT8       Bits;
+
+  if (Value == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = PL061CheckPinSet (Gpio, Mask);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  *Value = 0;
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    Bits = PL061ControllerBits (Index, Gpio, Mask);
+    if (Bits != 0) {
+      Bits    = (UINT8)PL061GetPins (mPL061PlatformGpio->GpioController[Index].RegisterBase, Bits);
+      *Value |= PL061PinSetBits (Index, Gpio, Bits);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Drive a set of output pins, with one write per controller.
+
+  @param[in]  This    The protocol instance.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Mask    The pins of the set.
+  @param[in]  Value   The levels to drive on the pins of the set.
+
+  @retval EFI_SUCCESS             The pins were set.
+  @retval EFI_INVALID_PARAMETER   A pin does not exist.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PL061SetPinSet (
+  IN PL061_GPIO_PROTOCOL  *This,
+  IN EMBEDDED_GPIO_PIN    Gpio,
+  IN UINT64               Mask,
+  IN UINT64               Value
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINT8       Bits;
+
+  Status = PL061CheckPinSet (Gpio, Mask);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    Bits = PL061ControllerBits (Index, Gpio, Mask);
+    if (Bits != 0) {
+      PL061SetPins (
+        mPL061PlatformGpio->GpioController[Index].RegisterBase,
+        Bits,
+        PL061ControllerBits (Index, Gpio, Value)
+        );
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Set the direction of a set of pins.
+
+  @param[in]  This    The protocol instance.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Mask    The pins of the set.
+  @param[in]  Output  The pins of the set to make outputs.
+
+  @retval EFI_SUCCESS             The directions were set.
+  @retval EFI_INVALID_PARAMETER   A pin does not exist.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PL061SetDirection (
+  IN PL061_GPIO_PROTOCOL  *This,
+  IN EMBEDDED_GPIO_PIN    Gpio,
+  IN UINT64               Mask,
+  IN UINT64               Output
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       RegisterBase;
+  UINT8       Bits;
+  UINT8       Direction;
+  UINT8       NewDirection;
+
+  Status = PL061CheckPinSet (Gpio, Mask);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    Bits = PL061ControllerBits (Index, Gpio, Mask);
+    if (Bits == 0) {
+      continue;
+    }
+
+    RegisterBase = mPL061PlatformGpio->GpioController[Index].RegisterBase;
+    Direction    = MmioRead8 (RegisterBase + PL061_GPIO_DIR_REG);
+    NewDirection = (Direction & ~Bits) | (PL061ControllerBits (Index, Gpio, Output) & Bits);
+    if (NewDirection != Direction) {
+      MmioWrite8 (RegisterBase + PL061_GPIO_DIR_REG, NewDirection);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Latch the pending interrupts of a controller.
+
+  Edge triggered interrupts are cleared, and level triggered ones are masked
+  until their handler has run. Must be called at TPL_HIGH_LEVEL.
+
+  @param[in]  Index   The index of the controller.
+
+**/
+STATIC
+VOID
+PL061LatchInterrupts (
+  IN UINTN  Index
+  )
+{
+  PL061_INTERRUPT_STATE  *State;
+  UINTN                  RegisterBase;
+  UINT8                  Status;
+  UINT8                  Level;
+
+  State = &mPL061Interrupts[Index];
+  if (State->Enabled == 0) {
+    return;
+  }
+
+  RegisterBase = mPL061PlatformGpio->GpioController[Index].RegisterBase;
+  Status       = MmioRead8 (RegisterBase + PL061_GPIO_MIS_REG) & State->Enabled;
+  if (Status == 0) {
+    return;
+  }
+
+  Level = Status & State->Level;
+  if (Level != 0) {
+    MmioAnd8 (RegisterBase + PL061_GPIO_IE_REG, (UINT8)~Level);
+  }
+
+  if (Status != Level) {
+    MmioWrite8 (RegisterBase + PL061_GPIO_IC_REG, Status & ~Level);
+  }
+
+  State->Pending |= Status;
+}
+
+/**
+  Call the handlers of the latched interrupts, and unmask the level triggered
+  ones again. Runs at TPL_NOTIFY.
+
+**/
+STATIC
+VOID
+PL061DispatchInterrupts (
+  VOID
+  )
+{
+  PL061_INTERRUPT_STATE  *State;
+  UINTN                  Index;
+  UINTN                  Pin;
+  UINT8                  Pending;
+  UINT8                  Rearm;
+  EFI_TPL                OldTpl;
+
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    State = &mPL061Interrupts[Index];
+
+    OldTpl         = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    Pending        = State->Pending;
+    State->Pending = 0;
+    gBS->RestoreTPL (OldTpl);
+
+    for (Pin = 0; Pending >> Pin != 0; Pin++) {
+      if (((Pending & GPIO_PIN_MASK (Pin)) != 0) && (State->Handler[Pin] != NULL)) {
+        State->Handler[Pin] (
+                 mPL061PlatformGpio->GpioController[Index].GpioIndex + Pin,
+                 State->Context[Pin]
+                 );
+      }
+    }
+
+    //
+    // Handlers may have unregistered themselves, only unmask the pins that
+    // are still enabled.
+    //
+    if ((Pending & State->Level) != 0) {
+      OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+      Rearm  = Pending & State->Level & State->Enabled;
+      if (Rearm != 0) {
+        MmioOr8 (
+          mPL061PlatformGpio->GpioController[Index].RegisterBase + PL061_GPIO_IE_REG,
+          Rearm
+          );
+      }
+
+      gBS->RestoreTPL (OldTpl);
+    }
+  }
+}
+
+/**
+  Check whether the interrupts of a controller must be polled.
+
+  @param[in]  Index   The index of the controller.
+
+  @retval TRUE    The controller has no usable interrupt line.
+  @retval FALSE   Interrupts are taken from the interrupt line.
+
+**/
+STATIC
+BOOLEAN
+PL061IsPolled (
+  IN UINTN  Index
+  )
+{
+  return (BOOLEAN)((mInterrupt == NULL) || (mPL061Interrupts[Index].Interrupt == 0));
+}
+
+/**
+  Start or stop the poll timer, depending on whether a controller without a
+  usable interrupt line has enabled interrupts. Must be called at TPL_NOTIFY.
+
+**/
+STATIC
+VOID
+PL061UpdatePollTimer (
+  VOID
+  )
+{
+  UINTN    Index;
+  BOOLEAN  Poll;
+
+  Poll = FALSE;
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    if ((mPL061Interrupts[Index].Enabled != 0) && PL061IsPolled (Index)) {
+      Poll = TRUE;
+      break;
+    }
+  }
+
+  if (Poll != mPolling) {
+    gBS->SetTimer (
+           mPollEvent,
+           Poll ? TimerPeriodic : TimerCancel,
+           Poll ? FixedPcdGet32 (PcdPL061GpioPollPeriod) : 0
+           );
+    mPolling = Poll;
+  }
+}
+
+/**
+  Register or unregister the interrupt handler of a pin.
+
+  @param[in]  This      The protocol instance.
+  @param[in]  Gpio      The pin.
+  @param[in]  Trigger   The condition triggering the interrupt.
+  @param[in]  Handler   The handler, or NULL to unregister the current one.
+  @param[in]  Context   The context passed to the handler.
+
+  @retval EFI_SUCCESS             The handler was registered or unregistered.
+  @retval EFI_INVALID_PARAMETER   The pin does not exist, or Trigger is
+                                  invalid.
+  @retval EFI_ALREADY_STARTED     A handler is already registered for the pin.
+  @retval EFI_NOT_FOUND           No handler is registered for the pin.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+PL061RegisterInterrupt (
+  IN PL061_GPIO_PROTOCOL           *This,
+  IN EMBEDDED_GPIO_PIN             Gpio,
+  IN PL061_GPIO_TRIGGER            Trigger,
+  IN PL061_GPIO_INTERRUPT_HANDLER  Handler OPTIONAL,
+  IN VOID                          *Context OPTIONAL
+  )
+{
+  EFI_STATUS             Status;
+  UINTN                  Index, Offset, RegisterBase;
+  PL061_INTERRUPT_STATE  *State;
+  UINT8                  PinMask;
+  EFI_TPL                OldTpl;
+  EFI_TPL                HighTpl;
+
+  if ((UINTN)Trigger >= Pl061GpioTriggerMax) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = PL061Locate (Gpio, &Index, &Offset, &RegisterBase);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  State   = &mPL061Interrupts[Index];
+  PinMask = (UINT8)GPIO_PIN_MASK (Offset);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (Handler == NULL) {
+    if (State->Handler[Offset] == NULL) {
+      gBS->RestoreTPL (OldTpl);
+      return EFI_NOT_FOUND;
+    }
+
+    HighTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    MmioAnd8 (RegisterBase + PL061_GPIO_IE_REG, (UINT8)~PinMask);
+    State->Enabled &= ~PinMask;
+    State->Pending &= ~PinMask;
+    gBS->RestoreTPL (HighTpl);
+
+    State->Handler[Offset] = NULL;
+    State->Context[Offset] = NULL;
+  } else {
+    if (State->Handler[Offset] != NULL) {
+      gBS->RestoreTPL (OldTpl);
+      return EFI_ALREADY_STARTED;
+    }
+
+    State->Handler[Offset] = Handler;
+    State->Context[Offset] = Context;
+
+    //
+    // Reconfigure the pin with its interrupt masked, and clear any edge
+    // detected under the previous configuration before unmasking it.
+    //
+    HighTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    MmioAnd8 (RegisterBase + PL061_GPIO_IE_REG, (UINT8)~PinMask);
+    MmioAnd8 (RegisterBase + PL061_GPIO_DIR_REG, (UINT8)~PinMask);
+
+    if ((Trigger == Pl061GpioTriggerLevelHigh) || (Trigger == Pl061GpioTriggerLevelLow)) {
+      MmioOr8 (RegisterBase + PL061_GPIO_IS_REG, PinMask);
+      State->Level |= PinMask;
+    } else {
+      MmioAnd8 (RegisterBase + PL061_GPIO_IS_REG, (UINT8)~PinMask);
+      State->Level &= ~PinMask;
+    }
+
+    if (Trigger == Pl061GpioTriggerEdgeBoth) {
+      MmioOr8 (RegisterBase + PL061_GPIO_IBE_REG, PinMask);
+    } else {
+      MmioAnd8 (RegisterBase + PL061_GPIO_IBE_REG, (UINT8)~PinMask);
+    }
+
+    if ((Trigger == Pl061GpioTriggerEdgeRising) || (Trigger == Pl061GpioTriggerLevelHigh)) {
+      MmioOr8 (RegisterBase + PL061_GPIO_IEV_REG, PinMask);
+    } else {
+      MmioAnd8 (RegisterBase + PL061_GPIO_IEV_REG, (UINT8)~PinMask);
+    }
+
+    MmioWrite8 (RegisterBase + PL061_GPIO_IC_REG, PinMask);
+    State->Enabled |= PinMask;
+    MmioOr8 (RegisterBase + PL061_GPIO_IE_REG, PinMask);
+    gBS->RestoreTPL (HighTpl);
+  }
+
+  PL061UpdatePollTimer ();
+
+  gBS->RestoreTPL (OldTpl);
+  return EFI_SUCCESS;
+}
+
+STATIC PL061_GPIO_PROTOCOL  mPL061Gpio = {
+  PL061GetPinSet,
+  PL061SetPinSet,
+  PL061SetDirection,
+  PL061RegisterInterrupt
+};
+
+/**
+  PL061 interrupt handler, latches the interrupts of the controllers wired to
+  the interrupt line and defers their handlers to TPL_NOTIFY.
+
+  @param  Source          Source of the interrupt.
+  @param  SystemContext   System context at the time of the interrupt.
+**/
+STATIC
+VOID
+EFIAPI
+PL061InterruptHandler (
+  IN  HARDWARE_INTERRUPT_SOURCE  Source,
+  IN  EFI_SYSTEM_CONTEXT         SystemContext
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    if (mPL061Interrupts[Index].Interrupt == Source) {
+      PL061LatchInterrupts (Index);
+    }
+  }
+
+  mInterrupt->EndOfInterrupt (mInterrupt, Source);
+  gBS->SignalEvent (mDispatchEvent);
+}
+
+/**
+  Dispatch the interrupts latched by the interrupt handler.
+
+  @param  Event     The dispatch event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+PL061DispatchNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  PL061DispatchInterrupts ();
+}
+
+/**
+  Periodic timer callback polling the controllers that have no usable
+  interrupt line.
+
+  @param  Event     The timer event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+PL061PollNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINTN    Index;
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    if (PL061IsPolled (Index)) {
+      PL061LatchInterrupts (Index);
+    }
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  PL061DispatchInterrupts ();
+}
+
+/**
+  Switch from polling to the interrupt line once the interrupt controller is
+  available.
+
+  @param  Event     The protocol notification event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+OnHardwareInterruptInstalled (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_HARDWARE_INTERRUPT_PROTOCOL  *Interrupt;
+  EFI_TPL                          OldTpl;
+  UINTN                            Index;
+
+  Status = gBS->LocateProtocol (
+                  &gHardwareInterruptProtocolGuid,
+                  NULL,
+                  (VOID **)&Interrupt
+                  );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  gBS->CloseEvent (Event);
+
+  OldTpl     = gBS->RaiseTPL (TPL_NOTIFY);
+  mInterrupt = Interrupt;
+
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    if (mPL061Interrupts[Index].Interrupt == 0) {
+      continue;
+    }
+
+    Status = Interrupt->RegisterInterruptSource (
+                          Interrupt,
+                          mPL061Interrupts[Index].Interrupt,
+                          PL061InterruptHandler
+                          );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((
+        DEBUG_ERROR,
+        "%a: failed to register GPIO interrupt %d - %r, polling\n",
+        __func__,
+        mPL061Interrupts[Index].Interrupt,
+        Status
+        ));
+      mPL061Interrupts[Index].Interrupt = 0;
+    }
+  }
+
+  PL061UpdatePollTimer ();
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  On exiting boot services, mask all the GPIO interrupts.
+
+  @param  Event     The ExitBootServices event.
+  @param  Context   Unused.
+**/
+STATIC
+VOID
+EFIAPI
+OnExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINTN  Index;
+
+  gBS->SetTimer (mPollEvent, TimerCancel, 0);
+
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    MmioWrite8 (mPL061PlatformGpio->GpioController[Index].RegisterBase + PL061_GPIO_IE_REG, 0);
+    mPL061Interrupts[Index].Enabled = 0;
+
+    if ((mInterrupt != NULL) && (mPL061Interrupts[Index].Interrupt != 0)) {
+      mInterrupt->DisableInterruptSource (mInterrupt, mPL061Interrupts[Index].Interrupt);
+    }
+  }
+}
+
+/**
+  Set up the interrupt state of the controllers, with all their interrupts
+  masked.
+
+  @retval EFI_SUCCESS           The interrupt state was set up.
+  @retval EFI_OUT_OF_RESOURCES  Cannot allocate the interrupt state.
+
+**/
+STATIC
+EFI_STATUS
+PL061InitializeInterrupts (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       RegisterBase;
+  BOOLEAN     WiredInterrupt;
+
+  mPL061Interrupts = AllocateZeroPool (
+                       mPL061PlatformGpio->GpioControllerCount * sizeof (PL061_INTERRUPT_STATE)
+                       );
+  if (mPL061Interrupts == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  WiredInterrupt = FALSE;
+  for (Index = 0; Index < mPL061PlatformGpio->GpioControllerCount; Index++) {
+    RegisterBase = mPL061PlatformGpio->GpioController[Index].RegisterBase;
+    MmioWrite8 (RegisterBase + PL061_GPIO_IE_REG, 0);
+    MmioWrite8 (RegisterBase + PL061_GPIO_IC_REG, 0xFF);
+
+    //
+    // Only the interrupt line of the controller described by the PCDs is
+    // known, the others are polled.
+    //
+    if (  (RegisterBase == (UINTN)PcdGet32 (PcdPL061GpioBase))
+       && (FixedPcdGet32 (PcdPL061GpioInterrupt) != 0))
+    {
+      mPL061Interrupts[Index].Interrupt = FixedPcdGet32 (PcdPL061GpioInterrupt);
+      WiredInterrupt                    = TRUE;
+    }
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  PL061DispatchNotify,
+                  NULL,
+                  &mDispatchEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  PL061PollNotify,
+                  NULL,
+                  &mPollEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  OnExitBootServices,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &mExitBootServicesEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  if (WiredInterrupt) {
+    EfiCreateProtocolNotifyEvent (
+      &gHardwareInterruptProtocolGuid,
+      TPL_CALLBACK,
+      OnHardwareInterruptInstalled,
+      NULL,
+      &mInterruptRegistration
+      );
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Initialize the state information for the Embedded Gpio protocol.
 
@@ -398,12 +1237,19 @@ PL061InstallProtocol (
     return EFI_DEVICE_ERROR;
   }
 
-  // Install the Embedded GPIO Protocol onto a new handle
+  Status = PL061InitializeInterrupts ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Install the Embedded GPIO Protocols onto a new handle
   Handle = NULL;
   Status = gBS->InstallMultipleProtocolInterfaces (
                   &Handle,
                   &gEmbeddedGpioProtocolGuid,
                   &gGpio,
+                  &gPL061GpioProtocolGuid,
+                  &mPL061Gpio,
                   NULL
                   );
   if (EFI_ERROR (Status)) {
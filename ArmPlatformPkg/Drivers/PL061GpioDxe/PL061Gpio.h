@@ -10,6 +10,8 @@
 #define __PL061_GPIO_H__
 
 #include <Protocol/EmbeddedGpio.h>
+#include <Protocol/HardwareInterrupt.h>
+#include <Protocol/PL061Gpio.h>
 
 // PL061 GPIO Registers
 #define PL061_GPIO_DATA_REG_OFFSET  ((UINTN) 0x000)
@@ -20,7 +22,7 @@
 #define PL061_GPIO_IEV_REG          0x40C
 #define PL061_GPIO_IE_REG           0x410
 #define PL061_GPIO_RIS_REG          0x414
-#define PL061_GPIO_MIS_REG          0x410
+#define PL061_GPIO_MIS_REG          0x418
 #define PL061_GPIO_IC_REG           0x41C
 #define PL061_GPIO_AFSEL_REG        0x420
 
@@ -39,4 +41,18 @@
 // All bits low except one bit high, native bit length
 #define GPIO_PIN_MASK(Pin)  (1UL << ((UINTN)(Pin)))
 
+//
+// Interrupt state of a controller. Pending collects the interrupts taken
+// from the interrupt line or from polling, until they are dispatched to the
+// handlers at TPL_NOTIFY.
+//
+typedef struct {
+  HARDWARE_INTERRUPT_SOURCE       Interrupt;
+  UINT8                           Enabled;
+  UINT8                           Level;
+  UINT8                           Pending;
+  PL061_GPIO_INTERRUPT_HANDLER    Handler[PL061_GPIO_PINS];
+  VOID                            *Context[PL061_GPIO_PINS];
+} PL061_INTERRUPT_STATE;
+
 #endif // __PL061_GPIO_H__
@@ -0,0 +1,181 @@
+/** @file
+  Producer of CPER error records for GHES error sources.
+
+  An error record ring is a region of the GHES error status memory divided
+  into slots, each of which is the Generic Error Status Block of one GHESv2
+  error source. All the error sources of a ring share a single notification,
+  e.g. an SDEI event or an interrupt, upon which the OS checks the status
+  block of each of them.
+
+  Any number of processors may report errors into a ring concurrently. A
+  corrected error that is identical to one the OS has not consumed yet is
+  folded into the pending record instead of consuming a slot, and the OS is
+  only notified once a configurable number of corrected error records are
+  pending. Uncorrectable errors are always notified immediately.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef GHES_ERROR_RECORD_LIB_H_
+#define GHES_ERROR_RECORD_LIB_H_
+
+typedef struct _GHES_ERROR_RING GHES_ERROR_RING;
+
+/**
+  Notify the OS that new error records are pending in a ring.
+
+  This function may be called from any processor, possibly concurrently.
+
+  @param[in]  Context   The context passed to GhesErrorRingCreate().
+
+**/
+typedef
+VOID
+(EFIAPI *GHES_ERROR_RING_NOTIFY)(
+  IN VOID  *Context
+  );
+
+typedef struct {
+  //
+  // Records published in a free slot.
+  //
+  UINT32    Reported;
+  //
+  // Corrected errors folded into a pending record.
+  //
+  UINT32    Coalesced;
+  //
+  // Records dropped because every slot was pending, or being written.
+  //
+  UINT32    Dropped;
+  //
+  // Calls to the notification function.
+  //
+  UINT32    Notifications;
+} GHES_ERROR_RING_STATISTICS;
+
+/**
+  Create an error record ring.
+
+  The error status memory starts with one 64-bit register per slot, which
+  holds the address of the status block of the slot, followed by the status
+  blocks. The register of slot N is located at Base + N * 8, and its status
+  block at Base + SlotCount * 8 + N * SlotSize. The memory must therefore be
+  SlotCount * (8 + SlotSize) bytes long. The registers are set up, and the
+  status blocks are cleared.
+
+  @param[in]  Base              The base of the error status memory, aligned
+                                on an 8 byte boundary.
+  @param[in]  SlotCount         The number of slots, i.e. of GHES error
+                                sources that share the ring.
+  @param[in]  SlotSize          The size of each slot, i.e. the Error Status
+                                Block Length of the error sources, a multiple
+                                of 8.
+  @param[in]  NotifyThreshold   The number of corrected error records that
+                                must be pending before the OS is notified.
+                                Zero or one notifies on every record.
+  @param[in]  Notify            The function notifying the OS.
+  @param[in]  Context           The context of the notification function.
+  @param[out] Ring              The new ring.
+
+  @retval EFI_SUCCESS             The ring was created.
+  @retval EFI_INVALID_PARAMETER   A parameter is invalid.
+  @retval EFI_OUT_OF_RESOURCES    The ring could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+GhesErrorRingCreate (
+  IN  VOID                    *Base,
+  IN  UINTN                   SlotCount,
+  IN  UINTN                   SlotSize,
+  IN  UINT32                  NotifyThreshold,
+  IN  GHES_ERROR_RING_NOTIFY  Notify,
+  IN  VOID                    *Context,
+  OUT GHES_ERROR_RING         **Ring
+  );
+
+/**
+  Report an error as a CPER record made of one Generic Error Data Entry.
+
+  This function is lock free: it never waits for another processor, and
+  completes in a bounded number of steps, so it is safe to call from any
+  number of processors at once, including during error storms.
+
+  @param[in]  Ring          The ring.
+  @param[in]  ErrorSeverity The severity of the error, one of the
+                            EFI_ACPI_6_3_ERROR_SEVERITY_* values.
+  @param[in]  SectionType   The CPER section type of the error data.
+  @param[in]  Section       The error data.
+  @param[in]  SectionSize   The size of the error data, in bytes.
+
+  @retval EFI_SUCCESS             The error was recorded, in a new record or
+                                  folded into a pending one.
+  @retval EFI_INVALID_PARAMETER   A parameter is invalid.
+  @retval EFI_BAD_BUFFER_SIZE     The record does not fit in a slot.
+  @retval EFI_OUT_OF_RESOURCES    No slot was available, and the error was
+                                  dropped.
+
+**/
+EFI_STATUS
+EFIAPI
+GhesErrorRingReport (
+  IN GHES_ERROR_RING  *Ring,
+  IN UINT32           ErrorSeverity,
+  IN CONST EFI_GUID   *SectionType,
+  IN CONST VOID       *Section,
+  IN UINT32           SectionSize
+  );
+
+/**
+  Notify the OS of the pending records that did not reach the threshold yet,
+  e.g. from a periodic timer.
+
+  @param[in]  Ring    The ring.
+
+**/
+VOID
+EFIAPI
+GhesErrorRingFlush (
+  IN GHES_ERROR_RING  *Ring
+  );
+
+/**
+  Get the address of the register that holds the address of the status block
+  of a slot.
+
+  This is the address that the Error Status Address of the corresponding GHES
+  error source must point to. That field is a Generic Address Structure
+  describing a 64-bit register in system memory, which holds the address of
+  the Generic Error Status Block, not the block itself.
+
+  @param[in]  Ring    The ring.
+  @param[in]  Index   The index of the slot.
+
+  @return The address of the register, or zero if Index is out of range.
+
+**/
+EFI_PHYSICAL_ADDRESS
+EFIAPI
+GhesErrorRingGetSlotAddress (
+  IN GHES_ERROR_RING  *Ring,
+  IN UINTN            Index
+  );
+
+/**
+  Get the statistics of a ring.
+
+  @param[in]  Ring        The ring.
+  @param[out] Statistics  The statistics.
+
+**/
+VOID
+EFIAPI
+GhesErrorRingGetStatistics (
+  IN  GHES_ERROR_RING             *Ring,
+  OUT GHES_ERROR_RING_STATISTICS  *Statistics
+  );
+
+#endif // GHES_ERROR_RECORD_LIB_H_
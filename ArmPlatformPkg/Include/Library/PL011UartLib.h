@@ -149,6 +149,44 @@ PL011UartWrite (
   IN  UINTN  NumberOfBytes
   );
 
+/**
+  Write as much data as the transmit FIFO can accept without waiting.
+
+  @param[in]  UartBase       UART registers base address
+  @param[in]  Buffer         Point of data buffer which need to be written.
+  @param[in]  NumberOfBytes  Number of output bytes which are cached in Buffer.
+
+  @retval  The number of bytes pushed into the transmit FIFO, which may be
+           less than NumberOfBytes, or 0 if the FIFO is full.
+
+**/
+UINTN
+EFIAPI
+PL011UartWriteNoWait (
+  IN  UINTN  UartBase,
+  IN  UINT8  *Buffer,
+  IN  UINTN  NumberOfBytes
+  );
+
+/**
+  Enable or disable the transmit interrupt of the serial device.
+
+  The transmit interrupt is asserted for as long as the transmit FIFO level is
+  at or below the programmed trigger level, so it must be disabled once there
+  is no more data to send.
+
+  @param[in]  UartBase  UART registers base address
+  @param[in]  Enable    TRUE to unmask the transmit interrupt, FALSE to mask
+                        and clear it.
+
+**/
+VOID
+EFIAPI
+PL011UartSetTxInterrupt (
+  IN  UINTN    UartBase,
+  IN  BOOLEAN  Enable
+  );
+
 /**
   Read data from serial device and save the data in buffer.
 
@@ -0,0 +1,87 @@
+/** @file
+  Protocol to hand serial output over to a buffered, asynchronously drained
+  PL011 transmit engine.
+
+  The producer of this protocol owns a RAM ring buffer that is drained into the
+  PL011 transmit FIFO from the UART transmit interrupt, or from a periodic timer
+  event when no interrupt is wired. SerialPortLib instances running in the DXE
+  phase use it so that DEBUG output does not stall the CPU until the characters
+  have left the FIFO.
+
+  The producer also installs the protocol interface as a configuration table
+  under the same GUID, so that it can be found without boot services, e.g.
+  from an exception handler or from a module loaded before the producer.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PL011_TX_BUFFER_H_
+#define PL011_TX_BUFFER_H_
+
+#define PL011_TX_BUFFER_PROTOCOL_GUID \
+  { \
+    0xb822f616, 0xbc41, 0x49d0, \
+    { 0xad, 0x65, 0x5d, 0x0d, 0xde, 0x51, 0x04, 0xff } \
+  }
+
+/**
+  Queue data for transmission on the serial device.
+
+  The data is copied into the ring buffer and the call returns without waiting
+  for the characters to be sent. If the ring buffer cannot hold the data, it is
+  drained synchronously first and the overrun counter is incremented. No data
+  is ever dropped.
+
+  @param[in]  Buffer         Point of data buffer which need to be written.
+  @param[in]  NumberOfBytes  Number of output bytes which are cached in Buffer.
+
+  @retval  The number of bytes accepted, which is always NumberOfBytes.
+
+**/
+typedef
+UINTN
+(EFIAPI *PL011_TX_BUFFER_WRITE)(
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  );
+
+/**
+  Synchronously send all the data queued in the ring buffer.
+
+  Returns once the ring buffer is empty. The characters may still be in the
+  transmit FIFO of the serial device.
+
+**/
+typedef
+VOID
+(EFIAPI *PL011_TX_BUFFER_FLUSH)(
+  VOID
+  );
+
+/**
+  Retrieve the number of times the ring buffer was found full and had to be
+  drained synchronously by a writer.
+
+  @retval  The overrun count.
+
+**/
+typedef
+UINT64
+(EFIAPI *PL011_TX_BUFFER_GET_OVERRUN_COUNT)(
+  VOID
+  );
+
+//
+// PL011_TX_BUFFER_PROTOCOL queues serial output in RAM for asynchronous transmit
+//
+typedef struct {
+  PL011_TX_BUFFER_WRITE                Write;
+  PL011_TX_BUFFER_FLUSH                Flush;
+  PL011_TX_BUFFER_GET_OVERRUN_COUNT    GetOverrunCount;
+} PL011_TX_BUFFER_PROTOCOL;
+
+extern EFI_GUID  gPL011TxBufferProtocolGuid;
+
+#endif // PL011_TX_BUFFER_H_
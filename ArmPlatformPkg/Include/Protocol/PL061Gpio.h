@@ -0,0 +1,168 @@
+/** @file
+  Multi-pin and interrupt interface of the PL061 GPIO driver.
+
+  This protocol is installed next to EMBEDDED_GPIO and uses the same pin
+  numbering. Pin sets are given as a first pin and a 64-bit mask, bit N of
+  which designates pin Gpio + N. The pins of a set may span controllers; each
+  controller is accessed once per call, through the address-masked data
+  register of the PL061, so that no read-modify-write of the data register is
+  ever needed.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PL061_GPIO_PROTOCOL_H_
+#define PL061_GPIO_PROTOCOL_H_
+
+#include <Protocol/EmbeddedGpio.h>
+
+#define PL061_GPIO_PROTOCOL_GUID \
+  { \
+    0x61ae5cd1, 0x4832, 0x4697, \
+    { 0xac, 0x1b, 0x66, 0x45, 0x70, 0xd5, 0x80, 0xbe } \
+  }
+
+typedef struct _PL061_GPIO_PROTOCOL PL061_GPIO_PROTOCOL;
+
+typedef enum {
+  Pl061GpioTriggerEdgeRising,
+  Pl061GpioTriggerEdgeFalling,
+  Pl061GpioTriggerEdgeBoth,
+  Pl061GpioTriggerLevelHigh,
+  Pl061GpioTriggerLevelLow,
+  Pl061GpioTriggerMax
+} PL061_GPIO_TRIGGER;
+
+/**
+  Read the state of a set of pins.
+
+  @param[in]  This    The protocol instance.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Mask    The pins of the set.
+  @param[out] Value   The state of the pins of the set. The other bits are
+                      zero.
+
+  @retval EFI_SUCCESS             The state of the pins was returned.
+  @retval EFI_INVALID_PARAMETER   Value is NULL, or a pin of the set does not
+                                  exist.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PL061_GPIO_GET_PINS)(
+  IN  PL061_GPIO_PROTOCOL  *This,
+  IN  EMBEDDED_GPIO_PIN    Gpio,
+  IN  UINT64               Mask,
+  OUT UINT64               *Value
+  );
+
+/**
+  Drive a set of output pins. The pins outside the set are left untouched.
+
+  @param[in]  This    The protocol instance.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Mask    The pins of the set.
+  @param[in]  Value   The levels to drive on the pins of the set. The other
+                      bits are ignored.
+
+  @retval EFI_SUCCESS             The pins were set.
+  @retval EFI_INVALID_PARAMETER   A pin of the set does not exist.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PL061_GPIO_SET_PINS)(
+  IN PL061_GPIO_PROTOCOL  *This,
+  IN EMBEDDED_GPIO_PIN    Gpio,
+  IN UINT64               Mask,
+  IN UINT64               Value
+  );
+
+/**
+  Set the direction of a set of pins. The pins outside the set are left
+  untouched.
+
+  Pins turned into outputs drive the level last written to them, so callers
+  that care should set the level with SetPins() first.
+
+  @param[in]  This    The protocol instance.
+  @param[in]  Gpio    The first pin of the set.
+  @param[in]  Mask    The pins of the set.
+  @param[in]  Output  The pins of the set to make outputs. The other pins of
+                      the set are made inputs.
+
+  @retval EFI_SUCCESS             The directions were set.
+  @retval EFI_INVALID_PARAMETER   A pin of the set does not exist.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PL061_GPIO_SET_DIRECTION)(
+  IN PL061_GPIO_PROTOCOL  *This,
+  IN EMBEDDED_GPIO_PIN    Gpio,
+  IN UINT64               Mask,
+  IN UINT64               Output
+  );
+
+/**
+  Function called when an interrupt occurs on a pin.
+
+  The function is called at TPL_NOTIFY. For level triggered pins, the
+  interrupt stays masked until the function returns, and fires again if the
+  level is still asserted.
+
+  @param[in]  Gpio      The pin.
+  @param[in]  Context   The context given to RegisterInterrupt().
+
+**/
+typedef
+VOID
+(EFIAPI *PL061_GPIO_INTERRUPT_HANDLER)(
+  IN EMBEDDED_GPIO_PIN  Gpio,
+  IN VOID               *Context
+  );
+
+/**
+  Register or unregister the interrupt handler of a pin.
+
+  Registering a handler makes the pin an input and unmasks its interrupt.
+  Interrupts are taken from the interrupt line of the controller when it is
+  known, and the controller is polled otherwise.
+
+  @param[in]  This      The protocol instance.
+  @param[in]  Gpio      The pin.
+  @param[in]  Trigger   The condition triggering the interrupt.
+  @param[in]  Handler   The handler, or NULL to mask the interrupt and
+                        unregister the current handler.
+  @param[in]  Context   The context passed to the handler.
+
+  @retval EFI_SUCCESS             The handler was registered or unregistered.
+  @retval EFI_INVALID_PARAMETER   The pin does not exist, or Trigger is
+                                  invalid.
+  @retval EFI_ALREADY_STARTED     A handler is already registered for the pin.
+  @retval EFI_NOT_FOUND           Handler is NULL and no handler is registered
+                                  for the pin.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PL061_GPIO_REGISTER_INTERRUPT)(
+  IN PL061_GPIO_PROTOCOL           *This,
+  IN EMBEDDED_GPIO_PIN             Gpio,
+  IN PL061_GPIO_TRIGGER            Trigger,
+  IN PL061_GPIO_INTERRUPT_HANDLER  Handler OPTIONAL,
+  IN VOID                          *Context OPTIONAL
+  );
+
+struct _PL061_GPIO_PROTOCOL {
+  PL061_GPIO_GET_PINS              GetPins;
+  PL061_GPIO_SET_PINS              SetPins;
+  PL061_GPIO_SET_DIRECTION         SetDirection;
+  PL061_GPIO_REGISTER_INTERRUPT    RegisterInterrupt;
+};
+
+extern EFI_GUID  gPL061GpioProtocolGuid;
+
+#endif // PL061_GPIO_PROTOCOL_H_
@@ -0,0 +1,564 @@
+/** @file
+  Producer of CPER error records for GHES error sources.
+
+  Each slot of a ring has a state word in MM private memory. Producers claim
+  a free slot by moving its state from SlotFree to SlotWriting with a compare
+  and exchange, write the record, and publish it by setting the Block Status
+  of the status block last. A published slot becomes free again once the OS
+  has consumed the record and cleared its Block Status.
+
+  The slot of the last corrected error of each signature is remembered, so
+  that a repeated corrected error can be folded into its pending record by
+  setting the Multiple Correctable Errors bit, instead of using a new slot.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+
+#include <IndustryStandard/Acpi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/GhesErrorRecordLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
+
+//
+// Bits of the Block Status field of the Generic Error Status Block.
+//
+#define BLOCK_STATUS_UNCORRECTABLE           BIT0
+#define BLOCK_STATUS_CORRECTABLE             BIT1
+#define BLOCK_STATUS_MULTIPLE_UNCORRECTABLE  BIT2
+#define BLOCK_STATUS_MULTIPLE_CORRECTABLE    BIT3
+#define BLOCK_STATUS_ENTRY_COUNT(Count)      ((UINT32)(Count) << 4)
+
+//
+// Number of slots a producer tries before dropping a record, which bounds
+// the time spent in MM per error when the ring is full.
+//
+#define MAX_CLAIM_ATTEMPTS  16
+
+typedef enum {
+  //
+  // The status block is empty.
+  //
+  SlotFree,
+  //
+  // A producer writes a record into the status block.
+  //
+  SlotWriting,
+  //
+  // The record is visible to the OS. The slot is free once the OS clears
+  // the Block Status.
+  //
+  SlotPublished,
+  //
+  // A producer folds a corrected error into the published record.
+  //
+  SlotCoalescing
+} GHES_ERROR_SLOT_STATE;
+
+typedef struct {
+  volatile UINT32    State;
+  UINT32             Signature;
+} GHES_ERROR_SLOT;
+
+struct _GHES_ERROR_RING {
+  //
+  // The Error Status Address registers, one per slot.
+  //
+  UINT64                        *Addresses;
+  //
+  // The status blocks, one per slot.
+  //
+  UINT8                         *Blocks;
+  UINTN                         SlotCount;
+  UINTN                         SlotSize;
+  UINT32                        NotifyThreshold;
+  GHES_ERROR_RING_NOTIFY        Notify;
+  VOID                          *Context;
+  GHES_ERROR_SLOT               *Slots;
+
+  //
+  // Index of the last slot holding a corrected error, plus one, for each
+  // signature bucket.
+  //
+  volatile UINT32               *Recent;
+
+  //
+  // Rotating start point of the search for a free slot.
+  //
+  volatile UINT32               Next;
+
+  //
+  // Corrected error records published since the last notification.
+  //
+  volatile UINT32               Unsignalled;
+
+  GHES_ERROR_RING_STATISTICS    Statistics;
+};
+
+typedef struct {
+  EFI_ACPI_6_3_GENERIC_ERROR_STATUS_STRUCTURE        Status;
+  EFI_ACPI_6_3_GENERIC_ERROR_DATA_ENTRY_STRUCTURE    Entry;
+} GHES_ERROR_RECORD;
+
+/**
+  Get the record held by a slot.
+
+  @param[in]  Ring    The ring.
+  @param[in]  Index   The index of the slot.
+
+  @return The record of the slot.
+
+**/
+STATIC
+GHES_ERROR_RECORD *
+GetRecord (
+  IN GHES_ERROR_RING  *Ring,
+  IN UINTN            Index
+  )
+{
+  return (GHES_ERROR_RECORD *)(Ring->Blocks + Index * Ring->SlotSize);
+}
+
+/**
+  Get the Block Status of the record held by a slot.
+
+  @param[in]  Ring    The ring.
+  @param[in]  Index   The index of the slot.
+
+  @return A pointer to the Block Status.
+
+**/
+STATIC
+volatile UINT32 *
+GetBlockStatus (
+  IN GHES_ERROR_RING  *Ring,
+  IN UINTN            Index
+  )
+{
+  return (volatile UINT32 *)&GetRecord (Ring, Index)->Status.BlockStatus;
+}
+
+/**
+  Call the notification function of a ring.
+
+  @param[in]  Ring    The ring.
+
+**/
+STATIC
+VOID
+NotifyOs (
+  IN GHES_ERROR_RING  *Ring
+  )
+{
+  InterlockedIncrement (&Ring->Statistics.Notifications);
+  Ring->Notify (Ring->Context);
+}
+
+/**
+  Try to fold a corrected error into the pending record with the same
+  signature.
+
+  @param[in]  Ring          The ring.
+  @param[in]  Signature     The signature of the error.
+  @param[in]  SectionType   The CPER section type of the error data.
+  @param[in]  Section       The error data.
+  @param[in]  SectionSize   The size of the error data, in bytes.
+
+  @retval TRUE    The error was folded into a pending record.
+  @retval FALSE   No identical record is pending.
+
+**/
+STATIC
+BOOLEAN
+CoalesceRecord (
+  IN GHES_ERROR_RING  *Ring,
+  IN UINT32           Signature,
+  IN CONST EFI_GUID   *SectionType,
+  IN CONST VOID       *Section,
+  IN UINT32           SectionSize
+  )
+{
+  UINT32             Hint;
+  UINTN              Index;
+  GHES_ERROR_RECORD  *Record;
+  volatile UINT32    *BlockStatus;
+  UINT32             Status;
+  BOOLEAN            Coalesced;
+
+  Hint = Ring->Recent[Signature % Ring->SlotCount];
+  if (Hint == 0) {
+    return FALSE;
+  }
+
+  Index = Hint - 1;
+  if (Ring->Slots[Index].Signature != Signature) {
+    return FALSE;
+  }
+
+  //
+  // Keep other producers from reusing the slot while it is compared.
+  //
+  if (InterlockedCompareExchange32 (
+        (UINT32 *)&Ring->Slots[Index].State,
+        SlotPublished,
+        SlotCoalescing
+        ) != SlotPublished)
+  {
+    return FALSE;
+  }
+
+  Coalesced   = FALSE;
+  Record      = GetRecord (Ring, Index);
+  BlockStatus = GetBlockStatus (Ring, Index);
+  Status      = *BlockStatus;
+
+  if (((Status & BLOCK_STATUS_CORRECTABLE) != 0) &&
+      (Record->Entry.ErrorSeverity == EFI_ACPI_6_3_ERROR_SEVERITY_CORRECTED) &&
+      (Record->Entry.ErrorDataLength == SectionSize) &&
+      CompareGuid ((EFI_GUID *)Record->Entry.SectionType, SectionType) &&
+      (CompareMem (Record + 1, Section, SectionSize) == 0))
+  {
+    //
+    // The OS may clear the Block Status at any time, in which case the error
+    // must be reported in a new record.
+    //
+    Coalesced = InterlockedCompareExchange32 (
+                  (UINT32 *)BlockStatus,
+                  Status,
+                  Status | BLOCK_STATUS_MULTIPLE_CORRECTABLE
+                  ) == Status;
+  }
+
+  InterlockedCompareExchange32 (
+    (UINT32 *)&Ring->Slots[Index].State,
+    SlotCoalescing,
+    SlotPublished
+    );
+
+  return Coalesced;
+}
+
+/**
+  Claim a free slot.
+
+  @param[in]  Ring    The ring.
+
+  @return The index of the claimed slot, or MAX_UINTN if none was found
+          within MAX_CLAIM_ATTEMPTS attempts.
+
+**/
+STATIC
+UINTN
+ClaimSlot (
+  IN GHES_ERROR_RING  *Ring
+  )
+{
+  UINTN  Attempt;
+  UINTN  Index;
+
+  for (Attempt = 0; Attempt < MIN (Ring->SlotCount, MAX_CLAIM_ATTEMPTS); Attempt++) {
+    Index = (InterlockedIncrement ((UINT32 *)&Ring->Next) - 1) % Ring->SlotCount;
+
+    //
+    // Reclaim the slot if the OS has consumed its record.
+    //
+    if ((Ring->Slots[Index].State == SlotPublished) && (*GetBlockStatus (Ring, Index) == 0)) {
+      InterlockedCompareExchange32 (
+        (UINT32 *)&Ring->Slots[Index].State,
+        SlotPublished,
+        SlotFree
+        );
+    }
+
+    if (InterlockedCompareExchange32 (
+          (UINT32 *)&Ring->Slots[Index].State,
+          SlotFree,
+          SlotWriting
+          ) == SlotFree)
+    {
+      return Index;
+    }
+  }
+
+  return MAX_UINTN;
+}
+
+/**
+  Create an error record ring.
+
+  The error status memory starts with one 64-bit register per slot, which
+  holds the address of the status block of the slot, followed by the status
+  blocks. The register of slot N is located at Base + N * 8, and its status
+  block at Base + SlotCount * 8 + N * SlotSize. The memory must therefore be
+  SlotCount * (8 + SlotSize) bytes long. The registers are set up, and the
+  status blocks are cleared.
+
+  @param[in]  Base              The base of the error status memory, aligned
+                                on an 8 byte boundary.
+  @param[in]  SlotCount         The number of slots, i.e. of GHES error
+                                sources that share the ring.
+  @param[in]  SlotSize          The size of each slot, i.e. the Error Status
+                                Block Length of the error sources, a multiple
+                                of 8.
+  @param[in]  NotifyThreshold   The number of corrected error records that
+                                must be pending before the OS is notified.
+                                Zero or one notifies on every record.
+  @param[in]  Notify            The function notifying the OS.
+  @param[in]  Context           The context of the notification function.
+  @param[out] Ring              The new ring.
+
+  @retval EFI_SUCCESS             The ring was created.
+  @retval EFI_INVALID_PARAMETER   A parameter is invalid.
+  @retval EFI_OUT_OF_RESOURCES    The ring could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+GhesErrorRingCreate (
+  IN  VOID                    *Base,
+  IN  UINTN                   SlotCount,
+  IN  UINTN                   SlotSize,
+  IN  UINT32                  NotifyThreshold,
+  IN  GHES_ERROR_RING_NOTIFY  Notify,
+  IN  VOID                    *Context,
+  OUT GHES_ERROR_RING         **Ring
+  )
+{
+  GHES_ERROR_RING  *NewRing;
+  UINTN            Index;
+
+  if ((Base == NULL) || (((UINTN)Base & 0x7) != 0) ||
+      (SlotCount == 0) || (SlotCount > MAX_UINT32 - 1) ||
+      (SlotSize > MAX_UINTN / SlotCount - sizeof (UINT64)) ||
+      (SlotSize < sizeof (GHES_ERROR_RECORD)) || ((SlotSize & 0x7) != 0) ||
+      (Notify == NULL) || (Ring == NULL))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  NewRing = AllocateZeroPool (sizeof (GHES_ERROR_RING));
+  if (NewRing == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewRing->Slots  = AllocateZeroPool (SlotCount * sizeof (GHES_ERROR_SLOT));
+  NewRing->Recent = AllocateZeroPool (SlotCount * sizeof (UINT32));
+  if ((NewRing->Slots == NULL) || (NewRing->Recent == NULL)) {
+    if (NewRing->Slots != NULL) {
+      FreePool (NewRing->Slots);
+    }
+
+    if (NewRing->Recent != NULL) {
+      FreePool ((VOID *)NewRing->Recent);
+    }
+
+    FreePool (NewRing);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewRing->Addresses       = Base;
+  NewRing->Blocks          = (UINT8 *)Base + SlotCount * sizeof (UINT64);
+  NewRing->SlotCount       = SlotCount;
+  NewRing->SlotSize        = SlotSize;
+  NewRing->NotifyThreshold = MAX (NotifyThreshold, 1);
+  NewRing->Notify          = Notify;
+  NewRing->Context         = Context;
+
+  ZeroMem (NewRing->Blocks, SlotCount * SlotSize);
+  for (Index = 0; Index < SlotCount; Index++) {
+    NewRing->Addresses[Index] = (UINT64)(UINTN)GetRecord (NewRing, Index);
+  }
+
+  *Ring = NewRing;
+  return EFI_SUCCESS;
+}
+
+/**
+  Report an error as a CPER record made of one Generic Error Data Entry.
+
+  This function is lock free: it never waits for another processor, and
+  completes in a bounded number of steps, so it is safe to call from any
+  number of processors at once, including during error storms.
+
+  @param[in]  Ring          The ring.
+  @param[in]  ErrorSeverity The severity of the error, one of the
+                            EFI_ACPI_6_3_ERROR_SEVERITY_* values.
+  @param[in]  SectionType   The CPER section type of the error data.
+  @param[in]  Section       The error data.
+  @param[in]  SectionSize   The size of the error data, in bytes.
+
+  @retval EFI_SUCCESS             The error was recorded, in a new record or
+                                  folded into a pending one.
+  @retval EFI_INVALID_PARAMETER   A parameter is invalid.
+  @retval EFI_BAD_BUFFER_SIZE     The record does not fit in a slot.
+  @retval EFI_OUT_OF_RESOURCES    No slot was available, and the error was
+                                  dropped.
+
+**/
+EFI_STATUS
+EFIAPI
+GhesErrorRingReport (
+  IN GHES_ERROR_RING  *Ring,
+  IN UINT32           ErrorSeverity,
+  IN CONST EFI_GUID   *SectionType,
+  IN CONST VOID       *Section,
+  IN UINT32           SectionSize
+  )
+{
+  BOOLEAN            Corrected;
+  UINT32             Signature;
+  UINTN              Index;
+  GHES_ERROR_RECORD  *Record;
+  UINT32             Pending;
+
+  if ((Ring == NULL) || (SectionType == NULL) ||
+      ((Section == NULL) && (SectionSize != 0)) ||
+      (ErrorSeverity > EFI_ACPI_6_3_ERROR_SEVERITY_NONE))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (SectionSize > Ring->SlotSize - sizeof (GHES_ERROR_RECORD)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Corrected = (ErrorSeverity == EFI_ACPI_6_3_ERROR_SEVERITY_CORRECTED);
+  Signature = 0;
+
+  if (Corrected) {
+    Signature = CalculateCrc32 ((VOID *)SectionType, sizeof (EFI_GUID)) ^
+                CalculateCrc32 ((VOID *)Section, SectionSize);
+    if (CoalesceRecord (Ring, Signature, SectionType, Section, SectionSize)) {
+      InterlockedIncrement (&Ring->Statistics.Coalesced);
+      return EFI_SUCCESS;
+    }
+  }
+
+  Index = ClaimSlot (Ring);
+  if (Index == MAX_UINTN) {
+    InterlockedIncrement (&Ring->Statistics.Dropped);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // The Block Status is still zero, so the OS ignores the record until it is
+  // published below.
+  //
+  Record = GetRecord (Ring, Index);
+  ZeroMem (Record, sizeof (GHES_ERROR_RECORD));
+  Record->Status.DataLength    = sizeof (Record->Entry) + SectionSize;
+  Record->Status.ErrorSeverity = ErrorSeverity;
+  CopyGuid ((EFI_GUID *)Record->Entry.SectionType, SectionType);
+  Record->Entry.ErrorSeverity   = ErrorSeverity;
+  Record->Entry.Revision        = EFI_ACPI_6_3_GENERIC_ERROR_DATA_ENTRY_REVISION;
+  Record->Entry.ErrorDataLength = SectionSize;
+  CopyMem (Record + 1, Section, SectionSize);
+
+  Ring->Slots[Index].Signature = Signature;
+
+  MemoryFence ();
+  *GetBlockStatus (Ring, Index) = BLOCK_STATUS_ENTRY_COUNT (1) |
+                                  (Corrected ? BLOCK_STATUS_CORRECTABLE :
+                                   BLOCK_STATUS_UNCORRECTABLE);
+  MemoryFence ();
+  Ring->Slots[Index].State = SlotPublished;
+
+  InterlockedIncrement (&Ring->Statistics.Reported);
+
+  if (!Corrected) {
+    Ring->Unsignalled = 0;
+    NotifyOs (Ring);
+    return EFI_SUCCESS;
+  }
+
+  Ring->Recent[Signature % Ring->SlotCount] = (UINT32)Index + 1;
+
+  //
+  // Only the producer that brings the count back to zero notifies the OS,
+  // so that concurrent producers crossing the threshold notify it once.
+  //
+  Pending = InterlockedIncrement ((UINT32 *)&Ring->Unsignalled);
+  if ((Pending >= Ring->NotifyThreshold) &&
+      (InterlockedCompareExchange32 ((UINT32 *)&Ring->Unsignalled, Pending, 0) == Pending))
+  {
+    NotifyOs (Ring);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Notify the OS of the pending records that did not reach the threshold yet,
+  e.g. from a periodic timer.
+
+  @param[in]  Ring    The ring.
+
+**/
+VOID
+EFIAPI
+GhesErrorRingFlush (
+  IN GHES_ERROR_RING  *Ring
+  )
+{
+  UINT32  Pending;
+
+  Pending = Ring->Unsignalled;
+  if ((Pending != 0) &&
+      (InterlockedCompareExchange32 ((UINT32 *)&Ring->Unsignalled, Pending, 0) == Pending))
+  {
+    NotifyOs (Ring);
+  }
+}
+
+/**
+  Get the address of the register that holds the address of the status block
+  of a slot.
+
+  This is the address that the Error Status Address of the corresponding GHES
+  error source must point to. That field is a Generic Address Structure
+  describing a 64-bit register in system memory, which holds the address of
+  the Generic Error Status Block, not the block itself.
+
+  @param[in]  Ring    The ring.
+  @param[in]  Index   The index of the slot.
+
+  @return The address of the register, or zero if Index is out of range.
+
+**/
+EFI_PHYSICAL_ADDRESS
+EFIAPI
+GhesErrorRingGetSlotAddress (
+  IN GHES_ERROR_RING  *Ring,
+  IN UINTN            Index
+  )
+{
+  if (Index >= Ring->SlotCount) {
+    return 0;
+  }
+
+  return (EFI_PHYSICAL_ADDRESS)(UINTN)&Ring->Addresses[Index];
+}
+
+/**
+  Get the statistics of a ring.
+
+  @param[in]  Ring        The ring.
+  @param[out] Statistics  The statistics.
+
+**/
+VOID
+EFIAPI
+GhesErrorRingGetStatistics (
+  IN  GHES_ERROR_RING             *Ring,
+  OUT GHES_ERROR_RING_STATISTICS  *Statistics
+  )
+{
+  CopyMem (Statistics, &Ring->Statistics, sizeof (*Statistics));
+}
@@ -0,0 +1,44 @@
+/** @file
+  Polled transmit path of the PL011 SerialPortLib, usable in any phase.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+
+#include <Library/PcdLib.h>
+#include <Library/PL011UartLib.h>
+
+#include "PL011SerialPortLibInternal.h"
+
+/**
+  Write data to serial device, waiting for the transmit FIFO as needed.
+
+  @param  Buffer           Point of data buffer which need to be written.
+  @param  NumberOfBytes    Number of output bytes which are cached in Buffer.
+
+  @retval 0                Write data failed.
+  @retval !0               Actual number of bytes written to serial device.
+
+**/
+UINTN
+PL011SerialPortWriteInternal (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  return PL011UartWrite ((UINTN)PcdGet64 (PcdSerialRegisterBase), Buffer, NumberOfBytes);
+}
+
+/**
+  Nothing is ever queued on the polled path.
+
+**/
+VOID
+PL011SerialPortFlushInternal (
+  VOID
+  )
+{
+}
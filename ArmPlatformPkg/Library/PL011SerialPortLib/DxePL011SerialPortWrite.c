@@ -0,0 +1,141 @@
+/** @file
+  Buffered transmit path of the PL011 SerialPortLib for the DXE phase.
+
+  Output is handed to the PL011 transmit buffer once PL011SerialBufferDxe has
+  published it, so that it is sent asynchronously. Until then, output is
+  polled. The transmit buffer is looked up in the configuration table, which
+  needs no boot service, so that modules loaded before PL011SerialBufferDxe,
+  such as CpuDxe, switch to it as well. In particular, the exception handler
+  of CpuDxe writes with interrupts disabled, which flushes the ring before the
+  exception is reported.
+
+  ASSERT messages flush the ring and are sent synchronously, so that they,
+  and the output that preceded them, reach the UART before the caller stops.
+
+  Platforms opt in by mapping this instance for the DXE_DRIVER, UEFI_DRIVER
+  and UEFI_APPLICATION module types and by including PL011SerialBufferDxe.
+  The DXE core and runtime drivers keep the polled PL011SerialPortLib, and
+  their output is not ordered against the output queued in the ring.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PL011UartLib.h>
+
+#include <Protocol/PL011TxBuffer.h>
+
+#include "PL011SerialPortLibInternal.h"
+
+//
+// Start of the messages printed by the DebugAssert() implementation of the
+// SerialPortLib based DebugLib instances.
+//
+#define ASSERT_MESSAGE_PREFIX  "ASSERT "
+
+STATIC EFI_SYSTEM_TABLE          *mSystemTable;
+STATIC PL011_TX_BUFFER_PROTOCOL  *mTxBuffer;
+
+/**
+  Look up the PL011 transmit buffer in the configuration table, until it is
+  found.
+
+  @return The PL011 transmit buffer, or NULL if it was not published yet.
+
+**/
+STATIC
+PL011_TX_BUFFER_PROTOCOL *
+GetTxBuffer (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  if ((mTxBuffer == NULL) && (mSystemTable != NULL)) {
+    for (Index = 0; Index < mSystemTable->NumberOfTableEntries; Index++) {
+      if (CompareGuid (&mSystemTable->ConfigurationTable[Index].VendorGuid, &gPL011TxBufferProtocolGuid)) {
+        mTxBuffer = mSystemTable->ConfigurationTable[Index].VendorTable;
+        break;
+      }
+    }
+  }
+
+  return mTxBuffer;
+}
+
+/**
+  Write data to serial device, through the transmit buffer if available.
+
+  @param  Buffer           Point of data buffer which need to be written.
+  @param  NumberOfBytes    Number of output bytes which are cached in Buffer.
+
+  @retval 0                Write data failed.
+  @retval !0               Actual number of bytes written to serial device.
+
+**/
+UINTN
+PL011SerialPortWriteInternal (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  PL011_TX_BUFFER_PROTOCOL  *TxBuffer;
+
+  TxBuffer = GetTxBuffer ();
+  if (TxBuffer != NULL) {
+    if ((NumberOfBytes < sizeof (ASSERT_MESSAGE_PREFIX) - 1) ||
+        (CompareMem (Buffer, ASSERT_MESSAGE_PREFIX, sizeof (ASSERT_MESSAGE_PREFIX) - 1) != 0))
+    {
+      return TxBuffer->Write (Buffer, NumberOfBytes);
+    }
+
+    TxBuffer->Flush ();
+  }
+
+  return PL011UartWrite ((UINTN)PcdGet64 (PcdSerialRegisterBase), Buffer, NumberOfBytes);
+}
+
+/**
+  Send any output queued in the transmit buffer to the serial device.
+
+**/
+VOID
+PL011SerialPortFlushInternal (
+  VOID
+  )
+{
+  PL011_TX_BUFFER_PROTOCOL  *TxBuffer;
+
+  TxBuffer = GetTxBuffer ();
+  if (TxBuffer != NULL) {
+    TxBuffer->Flush ();
+  }
+}
+
+/**
+  Record the system table, in which the PL011 transmit buffer is looked up.
+
+  No boot service is invoked from the write path, which may run after
+  ExitBootServices(), or from an exception handler.
+
+  @param  ImageHandle   The firmware allocated handle for the EFI image.
+  @param  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   The constructor always returns EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+DxePL011SerialPortLibConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  mSystemTable = SystemTable;
+  return EFI_SUCCESS;
+}
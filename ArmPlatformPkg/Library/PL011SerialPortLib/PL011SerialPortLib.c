@@ -17,6 +17,8 @@
 #include <Library/PL011UartLib.h>
 #include <Library/SerialPortLib.h>
 
+#include "PL011SerialPortLibInternal.h"
+
 /** Initialise the serial device hardware with default settings.
 
   @retval RETURN_SUCCESS            The serial device was initialised.
@@ -69,7 +71,7 @@ SerialPortWrite (
   IN UINTN  NumberOfBytes
   )
 {
-  return PL011UartWrite ((UINTN)PcdGet64 (PcdSerialRegisterBase), Buffer, NumberOfBytes);
+  return PL011SerialPortWriteInternal (Buffer, NumberOfBytes);
 }
 
 /**
@@ -150,6 +152,11 @@ SerialPortSetAttributes (
   IN OUT EFI_STOP_BITS_TYPE  *StopBits
   )
 {
+  //
+  // Make sure queued output is sent with the settings it was produced under.
+  //
+  PL011SerialPortFlushInternal ();
+
   return PL011UartInitializePort (
            (UINTN)PcdGet64 (PcdSerialRegisterBase),
            PL011UartClockGetFreq (),
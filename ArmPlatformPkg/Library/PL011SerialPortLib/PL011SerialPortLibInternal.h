@@ -0,0 +1,37 @@
+/** @file
+  Internal interfaces shared by the PL011 SerialPortLib instances.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PL011_SERIAL_PORT_LIB_INTERNAL_H_
+#define PL011_SERIAL_PORT_LIB_INTERNAL_H_
+
+/**
+  Write data to serial device, possibly through a transmit buffer.
+
+  @param  Buffer           Point of data buffer which need to be written.
+  @param  NumberOfBytes    Number of output bytes which are cached in Buffer.
+
+  @retval 0                Write data failed.
+  @retval !0               Actual number of bytes written to serial device.
+
+**/
+UINTN
+PL011SerialPortWriteInternal (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  );
+
+/**
+  Send any output queued in the transmit buffer to the serial device.
+
+**/
+VOID
+PL011SerialPortFlushInternal (
+  VOID
+  );
+
+#endif // PL011_SERIAL_PORT_LIB_INTERNAL_H_
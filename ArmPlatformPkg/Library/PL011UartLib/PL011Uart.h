@@ -108,6 +108,12 @@
 #define PL011_UARTLCR_H_PEN     (1 << 1)    // Parity Enable
 #define PL011_UARTLCR_H_BRK     (1 << 0)    // Send break
 
+// Interrupt Mask Set/Clear and Interrupt Clear Register Bits
+#define PL011_UARTIMSC_TXIM  (1 << 5)       // Transmit interrupt mask
+#define PL011_UARTIMSC_RXIM  (1 << 4)       // Receive interrupt mask
+#define PL011_UARTICR_TXIC   (1 << 5)       // Transmit interrupt clear
+#define PL011_UARTICR_RXIC   (1 << 4)       // Receive interrupt clear
+
 #define PL011_UARTPID2_VER(X)  (((X) >> 4) & 0xF)
 #define PL011_VER_R1P4  0x2
 
@@ -27,6 +27,59 @@
 //
 STATIC CONST UINT32  mInvalidControlBits = EFI_SERIAL_SOFTWARE_LOOPBACK_ENABLE;
 
+/**
+  Return the depth of the transmit and receive FIFOs of the serial device.
+
+  The depth is taken from PcdUartDefaultReceiveFifoDepth when set, so that no
+  register access is needed, and is otherwise derived from the revision in the
+  peripheral identification registers.
+
+  @param[in]  UartBase  UART registers base address
+
+  @retval  The hardware FIFO depth in characters.
+
+**/
+STATIC
+UINT32
+PL011UartGetHardwareFifoDepth (
+  IN  UINTN  UartBase
+  )
+{
+  UINT32  HardwareFifoDepth;
+  UINT32  UartPid2;
+
+  HardwareFifoDepth = FixedPcdGet16 (PcdUartDefaultReceiveFifoDepth);
+  if (HardwareFifoDepth == 0) {
+    UartPid2          = MmioRead32 (UartBase + UARTPID2);
+    HardwareFifoDepth = (PL011_UARTPID2_VER (UartPid2) > PL011_VER_R1P4) ? 32 : 16;
+  }
+
+  return HardwareFifoDepth;
+}
+
+/**
+  Return the number of characters that may be moved in one burst, without
+  checking the flag register, once the FIFO is known to be empty (transmit) or
+  full (receive).
+
+  @param[in]  UartBase  UART registers base address
+
+  @retval  The FIFO depth if the FIFOs are enabled, 1 otherwise.
+
+**/
+STATIC
+UINT32
+PL011UartGetBurstSize (
+  IN  UINTN  UartBase
+  )
+{
+  if ((MmioRead32 (UartBase + UARTLCR_H) & PL011_UARTLCR_H_FEN) == 0) {
+    return 1;
+  }
+
+  return PL011UartGetHardwareFifoDepth (UartBase);
+}
+
 /**
 
   Initialise the serial port to the specified settings.
@@ -78,13 +131,8 @@ PL011UartInitializePort (
   UINT32  Integer;
   UINT32  Fractional;
   UINT32  HardwareFifoDepth;
-  UINT32  UartPid2;
 
-  HardwareFifoDepth = FixedPcdGet16 (PcdUartDefaultReceiveFifoDepth);
-  if (HardwareFifoDepth == 0) {
-    UartPid2          = MmioRead32 (UartBase + UARTPID2);
-    HardwareFifoDepth = (PL011_UARTPID2_VER (UartPid2) > PL011_VER_R1P4) ? 32 : 16;
-  }
+  HardwareFifoDepth = PL011UartGetHardwareFifoDepth (UartBase);
 
   // The PL011 supports a buffer of 1, 16 or 32 chars. Therefore we can accept
   // 1 char buffer as the minimum FIFO size. Because everything can be rounded
@@ -439,18 +487,115 @@ PL011UartWrite (
   )
 {
   UINT8 *CONST  Final = &Buffer[NumberOfBytes];
+  UINTN         BurstSize;
+  UINTN         Count;
 
-  while (Buffer < Final) {
+  if (NumberOfBytes == 1) {
     // Wait until UART able to accept another char
     while ((MmioRead32 (UartBase + UARTFR) & UART_TX_FULL_FLAG_MASK)) {
     }
 
-    MmioWrite8 (UartBase + UARTDR, *Buffer++);
+    MmioWrite8 (UartBase + UARTDR, *Buffer);
+    return NumberOfBytes;
+  }
+
+  //
+  // Each flag register access is a trap on a virtual machine, so rather than
+  // checking for room before every char, wait for the transmit FIFO to drain
+  // and then refill it entirely with a single status check.
+  //
+  BurstSize = PL011UartGetBurstSize (UartBase);
+
+  while (Buffer < Final) {
+    // Wait until the transmit FIFO is empty
+    while ((MmioRead32 (UartBase + UARTFR) & UART_TX_EMPTY_FLAG_MASK) == 0) {
+    }
+
+    for (Count = MIN (BurstSize, (UINTN)(Final - Buffer)); Count > 0; Count--) {
+      MmioWrite8 (UartBase + UARTDR, *Buffer++);
+    }
   }
 
   return NumberOfBytes;
 }
 
+/**
+  Write as much data as the transmit FIFO can accept without waiting.
+
+  @param[in]  UartBase       UART registers base address
+  @param[in]  Buffer         Point of data buffer which need to be written.
+  @param[in]  NumberOfBytes  Number of output bytes which are cached in Buffer.
+
+  @retval  The number of bytes pushed into the transmit FIFO, which may be
+           less than NumberOfBytes, or 0 if the FIFO is full.
+
+**/
+UINTN
+EFIAPI
+PL011UartWriteNoWait (
+  IN  UINTN  UartBase,
+  IN  UINT8  *Buffer,
+  IN  UINTN  NumberOfBytes
+  )
+{
+  UINT32  Flags;
+  UINTN   BurstSize;
+  UINTN   Burst;
+  UINTN   Count;
+
+  BurstSize = PL011UartGetBurstSize (UartBase);
+
+  Count = 0;
+  while (Count < NumberOfBytes) {
+    Flags = MmioRead32 (UartBase + UARTFR);
+    if ((Flags & UART_TX_FULL_FLAG_MASK) != 0) {
+      break;
+    }
+
+    //
+    // An empty FIFO takes a full burst without further status checks,
+    // otherwise only a single char is known to fit.
+    //
+    Burst = 1;
+    if ((Flags & UART_TX_EMPTY_FLAG_MASK) != 0) {
+      Burst = MIN (BurstSize, NumberOfBytes - Count);
+    }
+
+    for ( ; Burst > 0; Burst--) {
+      MmioWrite8 (UartBase + UARTDR, Buffer[Count++]);
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Enable or disable the transmit interrupt of the serial device.
+
+  The transmit interrupt is asserted for as long as the transmit FIFO level is
+  at or below the programmed trigger level, so it must be disabled once there
+  is no more data to send.
+
+  @param[in]  UartBase  UART registers base address
+  @param[in]  Enable    TRUE to unmask the transmit interrupt, FALSE to mask
+                        and clear it.
+
+**/
+VOID
+EFIAPI
+PL011UartSetTxInterrupt (
+  IN  UINTN    UartBase,
+  IN  BOOLEAN  Enable
+  )
+{
+  if (Enable) {
+    MmioOr32 (UartBase + UARTIMSC, PL011_UARTIMSC_TXIM);
+  } else {
+    MmioAnd32 (UartBase + UARTIMSC, ~(UINT32)PL011_UARTIMSC_TXIM);
+    MmioWrite32 (UartBase + UARTICR, PL011_UARTICR_TXIC);
+  }
+}
+
 /**
   Read data from serial device and save the data in buffer.
 
@@ -469,11 +614,35 @@ PL011UartRead (
   IN  UINTN  NumberOfBytes
   )
 {
-  UINTN  Count;
+  UINTN   Count;
+  UINT32  Flags;
+  UINTN   BurstSize;
+  UINTN   Burst;
 
   // MU_CHANGE Starts: Do not wait indefinitely for the receive buffer to get filled.
-  for (Count = 0; (Count < NumberOfBytes) && PL011UartPoll (UartBase); Count++, Buffer++) {
-    *Buffer = MmioRead8 (UartBase + UARTDR);
+  BurstSize = PL011UartGetBurstSize (UartBase);
+
+  //
+  // Drain the receive FIFO until it reports empty, or the buffer is full.
+  //
+  Count = 0;
+  Flags = MmioRead32 (UartBase + UARTFR);
+  while ((Count < NumberOfBytes) && ((Flags & UART_RX_EMPTY_FLAG_MASK) == 0)) {
+    //
+    // A full receive FIFO can be drained in one burst without checking the
+    // flag register before every char, otherwise only a single char is
+    // known to be available.
+    //
+    Burst = 1;
+    if ((Flags & UART_RX_FULL_FLAG_MASK) != 0) {
+      Burst = MIN (BurstSize, NumberOfBytes - Count);
+    }
+
+    for ( ; Burst > 0; Burst--) {
+      Buffer[Count++] = MmioRead8 (UartBase + UARTDR);
+    }
+
+    Flags = MmioRead32 (UartBase + UARTFR);
   }
 
   // MU_CHANGE Ends
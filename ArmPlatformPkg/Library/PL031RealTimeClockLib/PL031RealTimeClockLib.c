@@ -34,6 +34,100 @@
 STATIC BOOLEAN    mPL031Initialized = FALSE;
 STATIC EFI_EVENT  mRtcVirtualAddrChangeEvent;
 STATIC UINTN      mPL031RtcBase;
+STATIC UINT32     mPL031PpmAccuracy;
+
+//
+// Date of the day holding the last time returned by GetTime, and the epoch
+// seconds at which that day starts. GetTime only runs the full epoch to
+// calendar conversion when the date moves by other than zero or one day,
+// e.g. on the first call, or after SetTime or a timezone change.
+//
+STATIC BOOLEAN   mCachedDateValid = FALSE;
+STATIC UINT32    mCachedDayStart;
+STATIC EFI_TIME  mCachedDate;
+
+STATIC CONST UINT8  mDaysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+/**
+  Move a date to the next day.
+
+  @param[in, out] Date    The date.
+
+**/
+STATIC
+VOID
+AdvanceDate (
+  IN OUT EFI_TIME  *Date
+  )
+{
+  UINT8    DaysInMonth;
+  BOOLEAN  LeapYear;
+
+  DaysInMonth = mDaysInMonth[Date->Month - 1];
+  if (Date->Month == 2) {
+    LeapYear = (BOOLEAN)(((Date->Year % 4) == 0) &&
+                         (((Date->Year % 100) != 0) || ((Date->Year % 400) == 0)));
+    if (LeapYear) {
+      DaysInMonth++;
+    }
+  }
+
+  if (Date->Day < DaysInMonth) {
+    Date->Day++;
+    return;
+  }
+
+  Date->Day = 1;
+  if (Date->Month < 12) {
+    Date->Month++;
+    return;
+  }
+
+  Date->Month = 1;
+  Date->Year++;
+}
+
+/**
+  Convert epoch seconds to the date and time fields of an EFI_TIME, moving
+  forward from the previous conversion when possible.
+
+  The TimeZone and Daylight fields are left untouched.
+
+  @param[in]  EpochSeconds    The epoch seconds.
+  @param[out] Time            The converted time.
+
+**/
+STATIC
+VOID
+CachedEpochToEfiTime (
+  IN  UINT32    EpochSeconds,
+  OUT EFI_TIME  *Time
+  )
+{
+  UINT32  DaySeconds;
+
+  if (  !mCachedDateValid
+     || (EpochSeconds < mCachedDayStart)
+     || (EpochSeconds - mCachedDayStart >= 2 * SEC_PER_DAY))
+  {
+    EpochToEfiTime (EpochSeconds, &mCachedDate);
+    mCachedDayStart  = EpochSeconds - (EpochSeconds % SEC_PER_DAY);
+    mCachedDateValid = TRUE;
+  } else if (EpochSeconds - mCachedDayStart >= SEC_PER_DAY) {
+    AdvanceDate (&mCachedDate);
+    mCachedDayStart += SEC_PER_DAY;
+  }
+
+  DaySeconds = EpochSeconds - mCachedDayStart;
+
+  Time->Year       = mCachedDate.Year;
+  Time->Month      = mCachedDate.Month;
+  Time->Day        = mCachedDate.Day;
+  Time->Hour       = (UINT8)(DaySeconds / SEC_PER_HOUR);
+  Time->Minute     = (UINT8)((DaySeconds % SEC_PER_HOUR) / SEC_PER_MIN);
+  Time->Second     = (UINT8)(DaySeconds % SEC_PER_MIN);
+  Time->Nanosecond = 0;
+}
 
 EFI_STATUS
 IdentifyPL031 (
@@ -151,14 +245,14 @@ LibGetTime (
   }
 
   // Convert from internal 32-bit time to UEFI time
-  EpochToEfiTime (EpochSeconds, Time);
+  CachedEpochToEfiTime (EpochSeconds, Time);
 
   // Update the Capabilities info
   if (Capabilities != NULL) {
     // PL031 runs at frequency 1Hz
     Capabilities->Resolution = PL031_COUNTS_PER_SECOND;
     // Accuracy in ppm multiplied by 1,000,000, e.g. for 50ppm set 50,000,000
-    Capabilities->Accuracy = (UINT32)PcdGet32 (PcdPL031RtcPpmAccuracy);
+    Capabilities->Accuracy = mPL031PpmAccuracy;
     // FALSE: Setting the time does not clear the values below the resolution level
     Capabilities->SetsToZero = FALSE;
   }
@@ -314,6 +408,9 @@ LibRtcInitialize (
   // Initialize RTC Base Address
   mPL031RtcBase = PcdGet32 (PcdPL031RtcBase);
 
+  // Dynamic PCDs cannot be read at runtime
+  mPL031PpmAccuracy = PcdGet32 (PcdPL031RtcPpmAccuracy);
+
   // Declare the controller as EFI_MEMORY_RUNTIME
   Status = gDS->AddMemorySpace (
                   EfiGcdMemoryTypeMemoryMappedIo,
@@ -14,6 +14,7 @@
 #include <Library/HobLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PcdLib.h>
+#include <Library/PerformanceLib.h>
 
 VOID
 BuildMemoryTypeInformationHob (
@@ -32,7 +33,9 @@ InitMmu (
 
   // Note: Because we called PeiServicesInstallPeiMemory() before to call InitMmu() the MMU Page Table resides in
   //      DRAM (even at the top of DRAM as it is the first permanent memory allocation)
+  PERF_INMODULE_BEGIN ("ArmConfigureMmu");
   Status = ArmConfigureMmu (MemoryTable, &TranslationTableBase, &TranslationTableSize);
+  PERF_INMODULE_END ("ArmConfigureMmu");
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Error: Failed to enable MMU\n"));
   }
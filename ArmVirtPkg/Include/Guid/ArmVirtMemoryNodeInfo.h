@@ -0,0 +1,43 @@
+/** @file
+  GUID for the HOB that describes every system memory range found in the
+  device tree, together with the NUMA proximity domain it belongs to.
+
+  The ranges are listed in device tree order and carry enough information to
+  generate the Memory Affinity structures of an ACPI SRAT, and to size a SLIT
+  for NumaNodeCount proximity domains.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef ARM_VIRT_MEMORY_NODE_INFO_H_
+#define ARM_VIRT_MEMORY_NODE_INFO_H_
+
+#define ARM_VIRT_MEMORY_NODE_INFO_GUID  {\
+          0x2d29a65d, 0x7f57, 0x4428, \
+          { 0x83, 0xf0, 0x19, 0x3a, 0xaa, 0x59, 0xd2, 0x18 } \
+        }
+
+typedef struct {
+  UINT64    Base;
+  UINT64    Length;
+  //
+  // The numa-node-id of the memory node, or 0 if it has none.
+  //
+  UINT32    ProximityDomain;
+  UINT32    Reserved;
+} ARM_VIRT_MEMORY_RANGE;
+
+typedef struct {
+  UINT32                   RangeCount;
+  //
+  // One more than the highest ProximityDomain in Range[].
+  //
+  UINT32                   NumaNodeCount;
+  ARM_VIRT_MEMORY_RANGE    Range[];
+} ARM_VIRT_MEMORY_NODE_INFO;
+
+extern EFI_GUID  gArmVirtMemoryNodeInfoGuid;
+
+#endif
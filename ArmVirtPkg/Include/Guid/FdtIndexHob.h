@@ -0,0 +1,101 @@
+/** @file
+  GUID for the HOB that carries a pre-built index of the device tree.
+
+  The HOB data is a single UINT64 holding the address of an FDT_INDEX_HEADER,
+  built in one pass over the device tree in the PEI phase. The index records,
+  for every node that has a 'compatible' property, each of its compatible
+  strings, its 'reg' property decoded according to the #address-cells and
+  #size-cells of its parent, and the cells of its 'interrupts' property. The
+  compatible strings are hashed so that lookups do not need to walk the tree.
+
+  The index is self-contained and describes the device tree as it was handed
+  over by the PEI phase. Node offsets are only valid against that version of
+  the tree, since changes made to it later may move nodes around.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef FDT_INDEX_HOB_H_
+#define FDT_INDEX_HOB_H_
+
+#define FDT_INDEX_HOB_GUID  {\
+          0x84b66980, 0xf22e, 0x4095, \
+          { 0x81, 0xe7, 0x2c, 0x0a, 0x0e, 0xca, 0xf8, 0xc8 } \
+        }
+
+#define FDT_INDEX_BUCKET_COUNT  128
+#define FDT_INDEX_NONE          MAX_UINT32
+
+//
+// The node has no 'status' property, or its status is "okay" or "ok".
+//
+#define FDT_INDEX_NODE_ENABLED  BIT0
+//
+// The node has a 'reg' property that could not be decoded, because its parent
+// uses more than 2 address or size cells.
+//
+#define FDT_INDEX_NODE_REG_RAW  BIT1
+
+typedef struct {
+  INT32     NodeOffset;
+  INT32     ParentOffset;
+  UINT32    Flags;
+  //
+  // Index of the first entry in the reg array, and number of entries.
+  //
+  UINT32    FirstReg;
+  UINT32    RegCount;
+  //
+  // Index of the first cell in the interrupt cell array, and number of cells.
+  //
+  UINT32    FirstInterruptCell;
+  UINT32    InterruptCellCount;
+} FDT_INDEX_NODE;
+
+typedef struct {
+  UINT64    Base;
+  UINT64    Size;
+} FDT_INDEX_REG;
+
+typedef struct {
+  UINT32    Hash;
+  //
+  // Offset of the NUL terminated compatible string in the string pool.
+  //
+  UINT32    String;
+  //
+  // Index of the node in the node array.
+  //
+  UINT32    Node;
+  //
+  // Next entry in the same bucket in device tree order, or FDT_INDEX_NONE.
+  //
+  UINT32    Next;
+} FDT_INDEX_COMPATIBLE;
+
+typedef struct {
+  UINT32    Size;
+  UINT32    NodeCount;
+  UINT32    CompatibleCount;
+  UINT32    RegCount;
+  UINT32    InterruptCellCount;
+  UINT32    StringPoolSize;
+  //
+  // Offsets of the arrays and of the string pool from the start of the header.
+  //
+  UINT32    NodeArray;
+  UINT32    CompatibleArray;
+  UINT32    RegArray;
+  UINT32    InterruptCellArray;
+  UINT32    StringPool;
+  //
+  // First FDT_INDEX_COMPATIBLE entry of each hash bucket, or FDT_INDEX_NONE.
+  //
+  UINT32    Bucket[FDT_INDEX_BUCKET_COUNT];
+} FDT_INDEX_HEADER;
+
+extern EFI_GUID  gFdtIndexHobGuid;
+
+#endif
@@ -0,0 +1,111 @@
+/** @file
+  Build and query the pre-built device tree index carried in the
+  gFdtIndexHobGuid HOB.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef FDT_INDEX_LIB_H_
+#define FDT_INDEX_LIB_H_
+
+#include <Guid/FdtIndexHob.h>
+
+/**
+  Walk the device tree once and publish an index of its nodes in a
+  gFdtIndexHobGuid HOB.
+
+  @param[in]  DeviceTreeBase    The device tree blob the index describes. It
+                                must remain at this address for as long as
+                                node offsets from the index are used with it.
+
+  @retval RETURN_SUCCESS            The index was built.
+  @retval RETURN_INVALID_PARAMETER  DeviceTreeBase is not a valid device tree.
+  @retval RETURN_OUT_OF_RESOURCES   Memory could not be allocated.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexBuild (
+  IN  CONST VOID  *DeviceTreeBase
+  );
+
+/**
+  Find the first enabled node, in device tree order, that lists
+  CompatibleString in its 'compatible' property.
+
+  @param[in]   CompatibleString   The compatible string to look for.
+  @param[out]  Node               The index entry of the node.
+
+  @retval RETURN_SUCCESS          A node was found.
+  @retval RETURN_NOT_FOUND        No matching node, or no index.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexFindCompatibleNode (
+  IN  CONST CHAR8           *CompatibleString,
+  OUT CONST FDT_INDEX_NODE  **Node
+  );
+
+/**
+  Find the next enabled node after PrevNode, in device tree order, that lists
+  CompatibleString in its 'compatible' property.
+
+  @param[in]   CompatibleString   The compatible string to look for.
+  @param[in]   PrevNode           A node returned by a previous lookup.
+  @param[out]  Node               The index entry of the node.
+
+  @retval RETURN_SUCCESS          A node was found.
+  @retval RETURN_NOT_FOUND        No more matching nodes, or no index.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexFindNextCompatibleNode (
+  IN  CONST CHAR8           *CompatibleString,
+  IN  CONST FDT_INDEX_NODE  *PrevNode,
+  OUT CONST FDT_INDEX_NODE  **Node
+  );
+
+/**
+  Retrieve a decoded (base, size) pair from the 'reg' property of a node.
+
+  @param[in]   Node     The index entry of the node.
+  @param[in]   Index    The zero based index of the pair.
+  @param[out]  Base     The base address.
+  @param[out]  Size     The size, or 0 if the parent has #size-cells == 0.
+
+  @retval RETURN_SUCCESS          The pair was returned.
+  @retval RETURN_NOT_FOUND        The node has fewer than Index + 1 pairs, or
+                                  its 'reg' property could not be decoded.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexGetNodeReg (
+  IN  CONST FDT_INDEX_NODE  *Node,
+  IN  UINT32                Index,
+  OUT UINT64                *Base,
+  OUT UINT64                *Size OPTIONAL
+  );
+
+/**
+  Retrieve the cells of the 'interrupts' property of a node, converted to CPU
+  byte order.
+
+  @param[in]   Node       The index entry of the node.
+  @param[out]  CellCount  The number of cells.
+
+  @return The cells, or NULL if the node has no 'interrupts' property.
+
+**/
+CONST UINT32 *
+EFIAPI
+FdtIndexGetNodeInterrupts (
+  IN  CONST FDT_INDEX_NODE  *Node,
+  OUT UINT32                *CellCount
+  );
+
+#endif
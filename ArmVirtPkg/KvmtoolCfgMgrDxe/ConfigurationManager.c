@@ -14,12 +14,14 @@
 #include <IndustryStandard/IoRemappingTable.h>
 #include <IndustryStandard/MemoryMappedConfigurationSpaceAccessTable.h>
 #include <IndustryStandard/SerialPortConsoleRedirectionTable.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/DynamicPlatRepoLib.h>
 #include <Library/HobLib.h>
 #include <Library/HwInfoParserLib.h>
 #include <Library/IoLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/PcdLib.h>
 #include <Library/TableHelperLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -240,185 +242,417 @@ EDKII_PLATFORM_REPOSITORY_INFO  mKvmtoolPlatRepositoryInfo = {
 };
 
 /**
-  A helper function for returning the Configuration Manager Objects.
+  Compute the hash of an object store key.
 
-  @param [in]       CmObjectId     The Configuration Manager Object ID.
-  @param [in]       Object         Pointer to the Object(s).
-  @param [in]       ObjectSize     Total size of the Object(s).
-  @param [in]       ObjectCount    Number of Objects.
-  @param [in, out]  CmObjectDesc   Pointer to the Configuration Manager Object
-                                   descriptor describing the requested Object.
+  @param [in]  CmObjectId  The Configuration Manager Object ID.
+  @param [in]  Token       A token identifying the object, or CM_NULL_TOKEN.
+
+  @return The hash of the key.
+**/
+STATIC
+UINTN
+HashCmObjectKey (
+  IN  CM_OBJECT_ID     CmObjectId,
+  IN  CM_OBJECT_TOKEN  Token
+  )
+{
+  UINT64  Key;
+
+  //
+  // Tokens are pointers, so their low bits carry little information. Mix
+  // the whole key with the 64-bit finaliser of MurmurHash3.
+  //
+  Key  = LShiftU64 (CmObjectId, 32) ^ (UINT64)Token;
+  Key ^= RShiftU64 (Key, 33);
+  Key  = MultU64x64 (Key, 0xFF51AFD7ED558CCDULL);
+  Key ^= RShiftU64 (Key, 33);
+  return (UINTN)Key;
+}
+
+/**
+  Find the object store entry of a key.
+
+  @param [in]  PlatformRepo  Pointer to the platform repository.
+  @param [in]  CmObjectId    The Configuration Manager Object ID.
+  @param [in]  Token         A token identifying the object, or CM_NULL_TOKEN.
+
+  @return The entry holding the key, or the free entry where the key belongs.
+**/
+STATIC
+CM_OBJECT_STORE_ENTRY *
+FindObjectStoreEntry (
+  IN  CONST EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo,
+  IN        CM_OBJECT_ID                    CmObjectId,
+  IN        CM_OBJECT_TOKEN                 Token
+  )
+{
+  CM_OBJECT_STORE_ENTRY  *Entry;
+  UINTN                  Mask;
+  UINTN                  Index;
+
+  Mask  = PlatformRepo->ObjectStoreSize - 1;
+  Index = HashCmObjectKey (CmObjectId, Token) & Mask;
+
+  //
+  // The store is never more than half full, so the probe always terminates.
+  //
+  for ( ; ; Index = (Index + 1) & Mask) {
+    Entry = &PlatformRepo->ObjectStore[Index];
+    if (!Entry->InUse ||
+        ((Entry->CmObjDesc.ObjectId == CmObjectId) && (Entry->Token == Token)))
+    {
+      return Entry;
+    }
+  }
+}
+
+/**
+  Add an object to the object store, unless its key is already present.
+
+  @param [in, out]  PlatformRepo  Pointer to the platform repository.
+  @param [in]       CmObjectId    The Configuration Manager Object ID.
+  @param [in]       Token         A token identifying the object, or
+                                  CM_NULL_TOKEN.
+  @param [in]       Data          Pointer to the Object(s).
+  @param [in]       Size          Total size of the Object(s).
+  @param [in]       Count         Number of Objects.
+**/
+STATIC
+VOID
+AddObjectStoreEntry (
+  IN  OUT   EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo,
+  IN        CM_OBJECT_ID                    CmObjectId,
+  IN        CM_OBJECT_TOKEN                 Token,
+  IN        VOID                            *Data,
+  IN        UINT32                          Size,
+  IN        UINT32                          Count
+  )
+{
+  CM_OBJECT_STORE_ENTRY  *Entry;
+
+  Entry = FindObjectStoreEntry (PlatformRepo, CmObjectId, Token);
+  if (Entry->InUse) {
+    return;
+  }
+
+  Entry->InUse              = TRUE;
+  Entry->Token              = Token;
+  Entry->CmObjDesc.ObjectId = CmObjectId;
+  Entry->CmObjDesc.Size     = Size;
+  Entry->CmObjDesc.Data     = Data;
+  Entry->CmObjDesc.Count    = Count;
+}
+
+/**
+  Add an object of the dynamic platform repository to the object store,
+  unless its key is already present.
+
+  @param [in, out]  PlatformRepo  Pointer to the platform repository.
+  @param [in]       CmObjectId    The Configuration Manager Object ID.
+  @param [in]       Token         A token identifying the object, or
+                                  CM_NULL_TOKEN for the array of all the
+                                  objects with this CmObjectId.
 
   @retval EFI_SUCCESS           Success.
+  @retval EFI_NOT_FOUND         The object is not in the dynamic repository.
 **/
 STATIC
 EFI_STATUS
-EFIAPI
-HandleCmObject (
-  IN  CONST CM_OBJECT_ID                CmObjectId,
-  IN        VOID                        *Object,
-  IN  CONST UINTN                       ObjectSize,
-  IN  CONST UINTN                       ObjectCount,
-  IN  OUT   CM_OBJ_DESCRIPTOR   *CONST  CmObjectDesc
+AddDynamicObject (
+  IN  OUT   EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo,
+  IN        CM_OBJECT_ID                    CmObjectId,
+  IN        CM_OBJECT_TOKEN                 Token
   )
 {
-  CmObjectDesc->ObjectId = CmObjectId;
-  CmObjectDesc->Size     = ObjectSize;
-  CmObjectDesc->Data     = Object;
-  CmObjectDesc->Count    = ObjectCount;
-  DEBUG ((
-    DEBUG_INFO,
-    "INFO: CmObjectId = " FMT_CM_OBJECT_ID ", "
-                                           "Ptr = 0x%p, Size = %lu, Count = %lu\n",
+  EFI_STATUS         Status;
+  CM_OBJ_DESCRIPTOR  CmObjDesc;
+
+  if (FindObjectStoreEntry (PlatformRepo, CmObjectId, Token)->InUse) {
+    return EFI_SUCCESS;
+  }
+
+  Status = DynamicPlatRepoGetObject (
+             PlatformRepo->DynamicPlatformRepo,
+             CmObjectId,
+             Token,
+             &CmObjDesc
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  AddObjectStoreEntry (
+    PlatformRepo,
     CmObjectId,
-    CmObjectDesc->Data,
-    CmObjectDesc->Size,
-    CmObjectDesc->Count
-    ));
+    Token,
+    CmObjDesc.Data,
+    CmObjDesc.Size,
+    CmObjDesc.Count
+    );
   return EFI_SUCCESS;
 }
 
 /**
-  A helper function for returning the Configuration Manager Objects that
-  match the token.
-
-  @param [in]  This               Pointer to the Configuration Manager Protocol.
-  @param [in]  CmObjectId         The Configuration Manager Object ID.
-  @param [in]  Object             Pointer to the Object(s).
-  @param [in]  ObjectSize         Total size of the Object(s).
-  @param [in]  ObjectCount        Number of Objects.
-  @param [in]  Token              A token identifying the object.
-  @param [in]  HandlerProc        A handler function to search the object
-                                  referenced by the token.
-  @param [in, out]  CmObjectDesc  Pointer to the Configuration Manager Object
-                                  descriptor describing the requested Object.
+  Record an object added to the dynamic platform repository, so that it can
+  be added to the object store once the repository is finalised.
+
+  @param [in, out]  PlatformRepo  Pointer to the platform repository.
+  @param [in]       CmObjectId    The Configuration Manager Object ID.
+  @param [in]       Token         The token generated for the object, or
+                                  CM_NULL_TOKEN if none was requested.
 
   @retval EFI_SUCCESS           Success.
-  @retval EFI_INVALID_PARAMETER A parameter is invalid.
-  @retval EFI_NOT_FOUND         The required object information is not found.
+  @retval EFI_OUT_OF_RESOURCES  An allocation has failed.
 **/
 STATIC
 EFI_STATUS
-EFIAPI
-HandleCmObjectRefByToken (
-  IN  CONST EDKII_CONFIGURATION_MANAGER_PROTOCOL  *CONST  This,
-  IN  CONST CM_OBJECT_ID                                  CmObjectId,
-  IN        VOID                                          *Object,
-  IN  CONST UINTN                                         ObjectSize,
-  IN  CONST UINTN                                         ObjectCount,
-  IN  CONST CM_OBJECT_TOKEN                               Token,
-  IN  CONST CM_OBJECT_HANDLER_PROC                        HandlerProc,
-  IN  OUT   CM_OBJ_DESCRIPTOR                     *CONST  CmObjectDesc
+RecordParsedObject (
+  IN  OUT   EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo,
+  IN        CM_OBJECT_ID                    CmObjectId,
+  IN        CM_OBJECT_TOKEN                 Token
   )
 {
-  EFI_STATUS  Status;
-
-  CmObjectDesc->ObjectId = CmObjectId;
-  if (Token == CM_NULL_TOKEN) {
-    CmObjectDesc->Size  = ObjectSize;
-    CmObjectDesc->Data  = Object;
-    CmObjectDesc->Count = ObjectCount;
-    Status              = EFI_SUCCESS;
-  } else {
-    Status = HandlerProc (This, CmObjectId, Token, CmObjectDesc);
+  CM_PARSED_OBJECT  *ParsedObjects;
+  UINTN             NewMax;
+
+  if (PlatformRepo->ParsedObjectCount == PlatformRepo->ParsedObjectMax) {
+    NewMax = MAX (
+               PlatformRepo->ParsedObjectMax * 2,
+               CM_PARSED_OBJECT_INITIAL_COUNT
+               );
+    ParsedObjects = ReallocatePool (
+                      PlatformRepo->ParsedObjectMax * sizeof (CM_PARSED_OBJECT),
+                      NewMax * sizeof (CM_PARSED_OBJECT),
+                      PlatformRepo->ParsedObjects
+                      );
+    if (ParsedObjects == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    PlatformRepo->ParsedObjects   = ParsedObjects;
+    PlatformRepo->ParsedObjectMax = NewMax;
   }
 
-  DEBUG ((
-    DEBUG_INFO,
-    "INFO: Token = 0x%p, CmObjectId = " FMT_CM_OBJECT_ID ", "
-                                                         "Ptr = 0x%p, Size = %lu, Count = %lu\n",
-    (VOID *)Token,
-    CmObjectId,
-    CmObjectDesc->Data,
-    CmObjectDesc->Size,
-    CmObjectDesc->Count
-    ));
-  return Status;
+  ParsedObjects             = &PlatformRepo->ParsedObjects[PlatformRepo->ParsedObjectCount++];
+  ParsedObjects->CmObjectId = CmObjectId;
+  ParsedObjects->Token      = Token;
+  return EFI_SUCCESS;
 }
 
 /**
-  Return an ITS identifier array.
+  Compute the number of entries of the ACPI table list.
 
-  @param [in]  This        Pointer to the Configuration Manager Protocol.
-  @param [in]  CmObjectId  The Configuration Manager Object ID.
-  @param [in]  Token       A token for identifying the object
-  @param [out] CmObject    Pointer to the Configuration Manager Object
-                           descriptor describing the requested Object.
+  @param [in]  PlatformRepo    Pointer to the platform repository.
+  @param [out] AcpiTableCount  The number of ACPI tables to install.
 
   @retval EFI_SUCCESS           Success.
-  @retval EFI_INVALID_PARAMETER A parameter is invalid.
-  @retval EFI_NOT_FOUND         The required object information is not found.
+  @retval EFI_NOT_FOUND         The GIC distributor information is not found.
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-GetItsIdentifierArray (
-  IN  CONST EDKII_CONFIGURATION_MANAGER_PROTOCOL  *CONST  This,
-  IN  CONST CM_OBJECT_ID                                  CmObjectId,
-  IN  CONST CM_OBJECT_TOKEN                               Token,
-  OUT       CM_OBJ_DESCRIPTOR                     *CONST  CmObject
+GetAcpiTableCount (
+  IN  CONST EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo,
+  OUT       UINTN                           *AcpiTableCount
   )
 {
-  EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo;
+  EFI_STATUS         Status;
+  CM_OBJ_DESCRIPTOR  CmObjDesc;
 
-  if ((This == NULL) || (CmObject == NULL)) {
-    ASSERT (This != NULL);
-    ASSERT (CmObject != NULL);
-    return EFI_INVALID_PARAMETER;
+  *AcpiTableCount = ARRAY_SIZE (PlatformRepo->CmAcpiTableList);
+
+  //
+  // Get Pci config space information.
+  //
+  Status = DynamicPlatRepoGetObject (
+             PlatformRepo->DynamicPlatformRepo,
+             CREATE_CM_ARM_OBJECT_ID (EArmObjPciConfigSpaceInfo),
+             CM_NULL_TOKEN,
+             &CmObjDesc
+             );
+  if (Status == EFI_NOT_FOUND) {
+    //
+    // The last 3 tables are for PCIe. If PCIe information is not
+    // present, Kvmtool was launched without the PCIe option.
+    // Therefore, reduce the table count by 3.
+    //
+    *AcpiTableCount -= 3;
+  } else if (EFI_ERROR (Status)) {
+    ASSERT_EFI_ERROR (Status);
+    return Status;
   }
 
-  PlatformRepo = This->PlatRepoInfo;
+  //
+  // Get the Gic version.
+  //
+  Status = DynamicPlatRepoGetObject (
+             PlatformRepo->DynamicPlatformRepo,
+             CREATE_CM_ARM_OBJECT_ID (EArmObjGicDInfo),
+             CM_NULL_TOKEN,
+             &CmObjDesc
+             );
+  if (EFI_ERROR (Status)) {
+    ASSERT_EFI_ERROR (Status);
+    return Status;
+  }
 
-  if (Token != (CM_OBJECT_TOKEN)&PlatformRepo->ItsIdentifierArray) {
-    return EFI_NOT_FOUND;
+  if (((CM_ARM_GICD_INFO *)CmObjDesc.Data)->GicVersion < 3) {
+    //
+    // IORT is only required for GicV3/4
+    //
+    *AcpiTableCount -= 1;
   }
 
-  CmObject->ObjectId = CmObjectId;
-  CmObject->Size     = sizeof (PlatformRepo->ItsIdentifierArray);
-  CmObject->Data     = (VOID *)&PlatformRepo->ItsIdentifierArray;
-  CmObject->Count    = ARRAY_SIZE (PlatformRepo->ItsIdentifierArray);
   return EFI_SUCCESS;
 }
 
 /**
-  Return a device Id mapping array.
+  Build the object store from the static objects of the platform repository
+  and from the objects the FDT parser added to the dynamic repository.
 
-  @param [in]  This        Pointer to the Configuration Manager Protocol.
-  @param [in]  CmObjectId  The Configuration Manager Object ID.
-  @param [in]  Token       A token for identifying the object
-  @param [out] CmObject    Pointer to the Configuration Manager Object
-                           descriptor describing the requested Object.
+  The ACPI table list and the arrays referenced by token are resolved here,
+  once, so that GetObject() is a single hash lookup.
 
-  @retval EFI_SUCCESS           Success.
-  @retval EFI_INVALID_PARAMETER A parameter is invalid.
-  @retval EFI_NOT_FOUND         The required object information is not found.
+  @param [in, out]  PlatformRepo  Pointer to the platform repository.
+
+  @retval EFI_SUCCESS             Success.
+  @retval EFI_NOT_FOUND           A required object is not found.
+  @retval EFI_OUT_OF_RESOURCES    An allocation has failed.
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-GetDeviceIdMappingArray (
-  IN  CONST EDKII_CONFIGURATION_MANAGER_PROTOCOL  *CONST  This,
-  IN  CONST CM_OBJECT_ID                                  CmObjectId,
-  IN  CONST CM_OBJECT_TOKEN                               Token,
-  OUT       CM_OBJ_DESCRIPTOR                     *CONST  CmObject
+BuildObjectStore (
+  IN  OUT   EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo
   )
 {
-  EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo;
+  EFI_STATUS        Status;
+  UINTN             AcpiTableCount;
+  UINTN             MaxEntries;
+  UINTN             Index;
+  CM_PARSED_OBJECT  *ParsedObject;
 
-  if ((This == NULL) || (CmObject == NULL)) {
-    ASSERT (This != NULL);
-    ASSERT (CmObject != NULL);
-    return EFI_INVALID_PARAMETER;
+  Status = GetAcpiTableCount (PlatformRepo, &AcpiTableCount);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
-  PlatformRepo = This->PlatRepoInfo;
+  //
+  // Each parsed object is returned for its own token, and as part of the
+  // array of all the objects sharing its CmObjectId for CM_NULL_TOKEN. Size
+  // the store so that it is never more than half full.
+  //
+  MaxEntries                    = CM_OBJECT_STORE_STATIC_COUNT + 2 * PlatformRepo->ParsedObjectCount;
+  PlatformRepo->ObjectStoreSize = (UINTN)GetPowerOfTwo64 (MaxEntries) * 4;
+  PlatformRepo->ObjectStore     = AllocateZeroPool (
+                                    PlatformRepo->ObjectStoreSize *
+                                    sizeof (CM_OBJECT_STORE_ENTRY)
+                                    );
+  if (PlatformRepo->ObjectStore == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  if (Token != (CM_OBJECT_TOKEN)&PlatformRepo->DeviceIdMapping[0]) {
-    return EFI_NOT_FOUND;
+  //
+  // The static objects take precedence over the dynamic ones.
+  //
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_STD_OBJECT_ID (EStdObjCfgMgrInfo),
+    CM_NULL_TOKEN,
+    &PlatformRepo->CmInfo,
+    sizeof (PlatformRepo->CmInfo),
+    1
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_STD_OBJECT_ID (EStdObjAcpiTableList),
+    CM_NULL_TOKEN,
+    PlatformRepo->CmAcpiTableList,
+    (UINT32)(sizeof (PlatformRepo->CmAcpiTableList[0]) * AcpiTableCount),
+    (UINT32)AcpiTableCount
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_ARM_OBJECT_ID (EArmObjPowerManagementProfileInfo),
+    CM_NULL_TOKEN,
+    &PlatformRepo->PmProfileInfo,
+    sizeof (PlatformRepo->PmProfileInfo),
+    1
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_ARM_OBJECT_ID (EArmObjItsGroup),
+    CM_NULL_TOKEN,
+    &PlatformRepo->ItsGroupInfo,
+    sizeof (PlatformRepo->ItsGroupInfo),
+    1
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_ARM_OBJECT_ID (EArmObjGicItsIdentifierArray),
+    CM_NULL_TOKEN,
+    PlatformRepo->ItsIdentifierArray,
+    sizeof (PlatformRepo->ItsIdentifierArray),
+    ARRAY_SIZE (PlatformRepo->ItsIdentifierArray)
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_ARM_OBJECT_ID (EArmObjGicItsIdentifierArray),
+    (CM_OBJECT_TOKEN)&PlatformRepo->ItsIdentifierArray,
+    PlatformRepo->ItsIdentifierArray,
+    sizeof (PlatformRepo->ItsIdentifierArray),
+    ARRAY_SIZE (PlatformRepo->ItsIdentifierArray)
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_ARM_OBJECT_ID (EArmObjRootComplex),
+    CM_NULL_TOKEN,
+    &PlatformRepo->RootComplexInfo,
+    sizeof (PlatformRepo->RootComplexInfo),
+    1
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_ARM_OBJECT_ID (EArmObjIdMappingArray),
+    CM_NULL_TOKEN,
+    PlatformRepo->DeviceIdMapping,
+    sizeof (PlatformRepo->DeviceIdMapping),
+    ARRAY_SIZE (PlatformRepo->DeviceIdMapping)
+    );
+  AddObjectStoreEntry (
+    PlatformRepo,
+    CREATE_CM_ARM_OBJECT_ID (EArmObjIdMappingArray),
+    (CM_OBJECT_TOKEN)&PlatformRepo->DeviceIdMapping[0],
+    &PlatformRepo->DeviceIdMapping[0],
+    sizeof (CM_ARM_ID_MAPPING),
+    1
+    );
+
+  for (Index = 0; Index < PlatformRepo->ParsedObjectCount; Index++) {
+    ParsedObject = &PlatformRepo->ParsedObjects[Index];
+
+    Status = AddDynamicObject (PlatformRepo, ParsedObject->CmObjectId, CM_NULL_TOKEN);
+    if (!EFI_ERROR (Status) && (ParsedObject->Token != CM_NULL_TOKEN)) {
+      Status = AddDynamicObject (PlatformRepo, ParsedObject->CmObjectId, ParsedObject->Token);
+    }
+
+    if (EFI_ERROR (Status)) {
+      ASSERT_EFI_ERROR (Status);
+      return Status;
+    }
   }
 
-  CmObject->ObjectId = CmObjectId;
-  CmObject->Size     = sizeof (CM_ARM_ID_MAPPING);
-  CmObject->Data     = (VOID *)Token;
-  CmObject->Count    = 1;
+  //
+  // The parsed object list is not needed anymore.
+  //
+  FreePool (PlatformRepo->ParsedObjects);
+  PlatformRepo->ParsedObjects     = NULL;
+  PlatformRepo->ParsedObjectCount = 0;
+  PlatformRepo->ParsedObjectMax   = 0;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "INFO: Configuration Manager object store: %lu entries\n",
+    (UINT64)MaxEntries
+    ));
   return EFI_SUCCESS;
 }
 
@@ -452,6 +686,7 @@ HwInfoAdd (
 {
   EFI_STATUS                      Status;
   EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo;
+  CM_OBJECT_TOKEN                 ObjectToken;
 
   if ((ParserHandle == NULL)  ||
       (Context == NULL)       ||
@@ -472,11 +707,22 @@ HwInfoAdd (
   ParseCmObjDesc (CmObjDesc);
   DEBUG_CODE_END ();
 
-  Status = DynPlatRepoAddObject (
-             PlatformRepo->DynamicPlatformRepo,
-             CmObjDesc,
-             Token
-             );
+  ObjectToken = CM_NULL_TOKEN;
+  Status      = DynPlatRepoAddObject (
+                  PlatformRepo->DynamicPlatformRepo,
+                  CmObjDesc,
+                  (Token != NULL) ? &ObjectToken : NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    ASSERT_EFI_ERROR (Status);
+    return Status;
+  }
+
+  if (Token != NULL) {
+    *Token = ObjectToken;
+  }
+
+  Status = RecordParsedObject (PlatformRepo, CmObjDesc->ObjectId, ObjectToken);
   if (EFI_ERROR (Status)) {
     ASSERT_EFI_ERROR (Status);
   }
@@ -509,6 +755,19 @@ CleanupPlatformRepository (
 
   PlatformRepo = This->PlatRepoInfo;
 
+  if (PlatformRepo->ObjectStore != NULL) {
+    FreePool (PlatformRepo->ObjectStore);
+    PlatformRepo->ObjectStore     = NULL;
+    PlatformRepo->ObjectStoreSize = 0;
+  }
+
+  if (PlatformRepo->ParsedObjects != NULL) {
+    FreePool (PlatformRepo->ParsedObjects);
+    PlatformRepo->ParsedObjects     = NULL;
+    PlatformRepo->ParsedObjectCount = 0;
+    PlatformRepo->ParsedObjectMax   = 0;
+  }
+
   //
   // Shutdown the dynamic repo and free all objects.
   //
@@ -599,6 +858,11 @@ InitializePlatformRepository (
     goto ErrorHandler;
   }
 
+  Status = BuildObjectStore (PlatformRepo);
+  if (EFI_ERROR (Status)) {
+    goto ErrorHandler;
+  }
+
   return EFI_SUCCESS;
 
 ErrorHandler:
@@ -606,297 +870,14 @@ ErrorHandler:
   return Status;
 }
 
-/**
-  Return a standard namespace object.
-
-  @param [in]      This        Pointer to the Configuration Manager Protocol.
-  @param [in]      CmObjectId  The Configuration Manager Object ID.
-  @param [in]      Token       An optional token identifying the object. If
-                               unused this must be CM_NULL_TOKEN.
-  @param [in, out] CmObject    Pointer to the Configuration Manager Object
-                               descriptor describing the requested Object.
-
-  @retval EFI_SUCCESS           Success.
-  @retval EFI_INVALID_PARAMETER A parameter is invalid.
-  @retval EFI_NOT_FOUND         The required object information is not found.
-**/
-EFI_STATUS
-EFIAPI
-GetStandardNameSpaceObject (
-  IN  CONST EDKII_CONFIGURATION_MANAGER_PROTOCOL  *CONST  This,
-  IN  CONST CM_OBJECT_ID                                  CmObjectId,
-  IN  CONST CM_OBJECT_TOKEN                               Token OPTIONAL,
-  IN  OUT   CM_OBJ_DESCRIPTOR                     *CONST  CmObject
-  )
-{
-  EFI_STATUS                      Status;
-  EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo;
-  UINTN                           AcpiTableCount;
-  CM_OBJ_DESCRIPTOR               CmObjDesc;
-
-  if ((This == NULL) || (CmObject == NULL)) {
-    ASSERT (This != NULL);
-    ASSERT (CmObject != NULL);
-    return EFI_INVALID_PARAMETER;
-  }
-
-  Status       = EFI_NOT_FOUND;
-  PlatformRepo = This->PlatRepoInfo;
-
-  switch (GET_CM_OBJECT_ID (CmObjectId)) {
-    case EStdObjCfgMgrInfo:
-      Status = HandleCmObject (
-                 CmObjectId,
-                 &PlatformRepo->CmInfo,
-                 sizeof (PlatformRepo->CmInfo),
-                 1,
-                 CmObject
-                 );
-      break;
-
-    case EStdObjAcpiTableList:
-      AcpiTableCount = ARRAY_SIZE (PlatformRepo->CmAcpiTableList);
-
-      //
-      // Get Pci config space information.
-      //
-      Status = DynamicPlatRepoGetObject (
-                 PlatformRepo->DynamicPlatformRepo,
-                 CREATE_CM_ARM_OBJECT_ID (EArmObjPciConfigSpaceInfo),
-                 CM_NULL_TOKEN,
-                 &CmObjDesc
-                 );
-      if (Status == EFI_NOT_FOUND) {
-        //
-        // The last 3 tables are for PCIe. If PCIe information is not
-        // present, Kvmtool was launched without the PCIe option.
-        // Therefore, reduce the table count by 3.
-        //
-        AcpiTableCount -= 3;
-      } else if (EFI_ERROR (Status)) {
-        ASSERT_EFI_ERROR (Status);
-        return Status;
-      }
-
-      //
-      // Get the Gic version.
-      //
-      Status = DynamicPlatRepoGetObject (
-                 PlatformRepo->DynamicPlatformRepo,
-                 CREATE_CM_ARM_OBJECT_ID (EArmObjGicDInfo),
-                 CM_NULL_TOKEN,
-                 &CmObjDesc
-                 );
-      if (EFI_ERROR (Status)) {
-        ASSERT_EFI_ERROR (Status);
-        return Status;
-      }
-
-      if (((CM_ARM_GICD_INFO *)CmObjDesc.Data)->GicVersion < 3) {
-        //
-        // IORT is only required for GicV3/4
-        //
-        AcpiTableCount -= 1;
-      }
-
-      Status = HandleCmObject (
-                 CmObjectId,
-                 PlatformRepo->CmAcpiTableList,
-                 (sizeof (PlatformRepo->CmAcpiTableList[0]) * AcpiTableCount),
-                 AcpiTableCount,
-                 CmObject
-                 );
-      break;
-
-    default:
-      Status = EFI_NOT_FOUND;
-      DEBUG ((
-        DEBUG_ERROR,
-        "ERROR: CmObjectId " FMT_CM_OBJECT_ID ". Status = %r\n",
-        CmObjectId,
-        Status
-        ));
-      break;
-  }
-
-  return Status;
-}
-
-/**
-  Return an ARM namespace object.
-
-  @param [in]      This        Pointer to the Configuration Manager Protocol.
-  @param [in]      CmObjectId  The Configuration Manager Object ID.
-  @param [in]      Token       An optional token identifying the object. If
-                               unused this must be CM_NULL_TOKEN.
-  @param [in, out] CmObject    Pointer to the Configuration Manager Object
-                               descriptor describing the requested Object.
-
-  @retval EFI_SUCCESS           Success.
-  @retval EFI_INVALID_PARAMETER A parameter is invalid.
-  @retval EFI_NOT_FOUND         The required object information is not found.
-**/
-EFI_STATUS
-EFIAPI
-GetArmNameSpaceObject (
-  IN  CONST EDKII_CONFIGURATION_MANAGER_PROTOCOL  *CONST  This,
-  IN  CONST CM_OBJECT_ID                                  CmObjectId,
-  IN  CONST CM_OBJECT_TOKEN                               Token OPTIONAL,
-  IN  OUT   CM_OBJ_DESCRIPTOR                     *CONST  CmObject
-  )
-{
-  EFI_STATUS                      Status;
-  EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo;
-
-  if ((This == NULL) || (CmObject == NULL)) {
-    ASSERT (This != NULL);
-    ASSERT (CmObject != NULL);
-    return EFI_INVALID_PARAMETER;
-  }
-
-  Status       = EFI_NOT_FOUND;
-  PlatformRepo = This->PlatRepoInfo;
-
-  //
-  // First check among the static objects.
-  //
-  switch (GET_CM_OBJECT_ID (CmObjectId)) {
-    case EArmObjPowerManagementProfileInfo:
-      Status = HandleCmObject (
-                 CmObjectId,
-                 &PlatformRepo->PmProfileInfo,
-                 sizeof (PlatformRepo->PmProfileInfo),
-                 1,
-                 CmObject
-                 );
-      break;
-
-    case EArmObjItsGroup:
-      Status = HandleCmObject (
-                 CmObjectId,
-                 &PlatformRepo->ItsGroupInfo,
-                 sizeof (PlatformRepo->ItsGroupInfo),
-                 1,
-                 CmObject
-                 );
-      break;
-
-    case EArmObjGicItsIdentifierArray:
-      Status = HandleCmObjectRefByToken (
-                 This,
-                 CmObjectId,
-                 PlatformRepo->ItsIdentifierArray,
-                 sizeof (PlatformRepo->ItsIdentifierArray),
-                 ARRAY_SIZE (PlatformRepo->ItsIdentifierArray),
-                 Token,
-                 GetItsIdentifierArray,
-                 CmObject
-                 );
-      break;
-
-    case EArmObjRootComplex:
-      Status = HandleCmObject (
-                 CmObjectId,
-                 &PlatformRepo->RootComplexInfo,
-                 sizeof (PlatformRepo->RootComplexInfo),
-                 1,
-                 CmObject
-                 );
-      break;
-
-    case EArmObjIdMappingArray:
-      Status = HandleCmObjectRefByToken (
-                 This,
-                 CmObjectId,
-                 PlatformRepo->DeviceIdMapping,
-                 sizeof (PlatformRepo->DeviceIdMapping),
-                 ARRAY_SIZE (PlatformRepo->DeviceIdMapping),
-                 Token,
-                 GetDeviceIdMappingArray,
-                 CmObject
-                 );
-      break;
-
-    default:
-      //
-      // No match found among the static objects.
-      // Check the dynamic objects.
-      //
-      Status = DynamicPlatRepoGetObject (
-                 PlatformRepo->DynamicPlatformRepo,
-                 CmObjectId,
-                 Token,
-                 CmObject
-                 );
-      break;
-  } // switch
-
-  if (Status == EFI_NOT_FOUND) {
-    DEBUG ((
-      DEBUG_INFO,
-      "INFO: CmObjectId " FMT_CM_OBJECT_ID ". Status = %r\n",
-      CmObjectId,
-      Status
-      ));
-  } else {
-    ASSERT_EFI_ERROR (Status);
-  }
-
-  return Status;
-}
-
-/**
-  Return an OEM namespace object.
-
-  @param [in]      This        Pointer to the Configuration Manager Protocol.
-  @param [in]      CmObjectId  The Configuration Manager Object ID.
-  @param [in]      Token       An optional token identifying the object. If
-                               unused this must be CM_NULL_TOKEN.
-  @param [in, out] CmObject    Pointer to the Configuration Manager Object
-                               descriptor describing the requested Object.
-
-  @retval EFI_SUCCESS           Success.
-  @retval EFI_INVALID_PARAMETER A parameter is invalid.
-  @retval EFI_NOT_FOUND         The required object information is not found.
-**/
-EFI_STATUS
-EFIAPI
-GetOemNameSpaceObject (
-  IN  CONST EDKII_CONFIGURATION_MANAGER_PROTOCOL  *CONST  This,
-  IN  CONST CM_OBJECT_ID                                  CmObjectId,
-  IN  CONST CM_OBJECT_TOKEN                               Token OPTIONAL,
-  IN  OUT   CM_OBJ_DESCRIPTOR                     *CONST  CmObject
-  )
-{
-  EFI_STATUS  Status;
-
-  Status = EFI_SUCCESS;
-  if ((This == NULL) || (CmObject == NULL)) {
-    ASSERT (This != NULL);
-    ASSERT (CmObject != NULL);
-    return EFI_INVALID_PARAMETER;
-  }
-
-  switch (GET_CM_OBJECT_ID (CmObjectId)) {
-    default:
-      Status = EFI_NOT_FOUND;
-      DEBUG ((
-        DEBUG_ERROR,
-        "ERROR: CmObjectId " FMT_CM_OBJECT_ID ". Status = %r\n",
-        CmObjectId,
-        Status
-        ));
-      break;
-  }
-
-  return Status;
-}
-
 /**
   The GetObject function defines the interface implemented by the
   Configuration Manager Protocol for returning the Configuration
   Manager Objects.
 
+  All the objects are looked up in the object store built when the platform
+  repository was initialised.
+
   @param [in]      This        Pointer to the Configuration Manager Protocol.
   @param [in]      CmObjectId  The Configuration Manager Object ID.
   @param [in]      Token       An optional token identifying the object. If
@@ -917,7 +898,8 @@ ArmKvmtoolPlatformGetObject (
   IN  OUT   CM_OBJ_DESCRIPTOR                     *CONST  CmObject
   )
 {
-  EFI_STATUS  Status;
+  EDKII_PLATFORM_REPOSITORY_INFO  *PlatformRepo;
+  CM_OBJECT_STORE_ENTRY           *Entry;
 
   if ((This == NULL) || (CmObject == NULL)) {
     ASSERT (This != NULL);
@@ -927,27 +909,32 @@ ArmKvmtoolPlatformGetObject (
 
   switch (GET_CM_NAMESPACE_ID (CmObjectId)) {
     case EObjNameSpaceStandard:
-      Status = GetStandardNameSpaceObject (This, CmObjectId, Token, CmObject);
-      break;
     case EObjNameSpaceArm:
-      Status = GetArmNameSpaceObject (This, CmObjectId, Token, CmObject);
-      break;
     case EObjNameSpaceOem:
-      Status = GetOemNameSpaceObject (This, CmObjectId, Token, CmObject);
       break;
     default:
-      Status = EFI_INVALID_PARAMETER;
       DEBUG ((
         DEBUG_ERROR,
         "ERROR: Unknown Namespace CmObjectId " FMT_CM_OBJECT_ID ". "
                                                                 "Status = %r\n",
         CmObjectId,
-        Status
+        EFI_INVALID_PARAMETER
         ));
-      break;
+      return EFI_INVALID_PARAMETER;
   }
 
-  return Status;
+  PlatformRepo = This->PlatRepoInfo;
+  if (PlatformRepo->ObjectStore == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Entry = FindObjectStoreEntry (PlatformRepo, CmObjectId, Token);
+  if (!Entry->InUse) {
+    return EFI_NOT_FOUND;
+  }
+
+  CopyMem (CmObject, &Entry->CmObjDesc, sizeof (*CmObject));
+  return EFI_SUCCESS;
 }
 
 /**
@@ -34,25 +34,6 @@ extern CHAR8  dsdt_aml_code[];
 ///
 #define MEMORY_ADDRESS_SIZE_LIMIT  64
 
-/** A function that prepares Configuration Manager Objects for returning.
-
-  @param [in]  This        Pointer to the Configuration Manager Protocol.
-  @param [in]  CmObjectId  The Configuration Manager Object ID.
-  @param [in]  Token       A token for identifying the object.
-  @param [out] CmObject    Pointer to the Configuration Manager Object
-                           descriptor describing the requested Object.
-
-  @retval EFI_SUCCESS           Success.
-  @retval EFI_INVALID_PARAMETER A parameter is invalid.
-  @retval EFI_NOT_FOUND         The required object information is not found.
-**/
-typedef EFI_STATUS (*CM_OBJECT_HANDLER_PROC) (
-  IN  CONST EDKII_CONFIGURATION_MANAGER_PROTOCOL  *CONST  This,
-  IN  CONST CM_OBJECT_ID                                  CmObjectId,
-  IN  CONST CM_OBJECT_TOKEN                               Token,
-  IN  OUT   CM_OBJ_DESCRIPTOR                     *CONST  CmObject
-  );
-
 ///
 /// A helper macro for mapping a reference token.
 ///
@@ -65,6 +46,35 @@ typedef EFI_STATUS (*CM_OBJECT_HANDLER_PROC) (
 ///
 #define PLAT_ACPI_TABLE_COUNT  10
 
+///
+/// The number of (CmObjectId, Token) pairs served from the static part of
+/// the platform repository.
+///
+#define CM_OBJECT_STORE_STATIC_COUNT  9
+
+///
+/// The initial number of entries of the parsed object list.
+///
+#define CM_PARSED_OBJECT_INITIAL_COUNT  64
+
+///
+/// A (CmObjectId, Token) pair added to the dynamic platform repository by
+/// the FDT HwInfoParser.
+///
+typedef struct CmParsedObject {
+  CM_OBJECT_ID       CmObjectId;
+  CM_OBJECT_TOKEN    Token;
+} CM_PARSED_OBJECT;
+
+///
+/// An entry of the object store. The key is CmObjDesc.ObjectId and Token.
+///
+typedef struct CmObjectStoreEntry {
+  BOOLEAN              InUse;
+  CM_OBJECT_TOKEN      Token;
+  CM_OBJ_DESCRIPTOR    CmObjDesc;
+} CM_OBJECT_STORE_ENTRY;
+
 ///
 /// A structure describing the platform configuration
 /// manager repository information
@@ -120,6 +130,22 @@ typedef struct PlatformRepositoryInfo {
   /// A handle to the FDT HwInfoParser.
   ///
   HW_INFO_PARSER_HANDLE                    FdtParserHandle;
+
+  ///
+  /// The objects added by the FDT HwInfoParser, recorded so that the object
+  /// store can be populated once the dynamic repository is finalised.
+  ///
+  CM_PARSED_OBJECT                         *ParsedObjects;
+  UINTN                                    ParsedObjectCount;
+  UINTN                                    ParsedObjectMax;
+
+  ///
+  /// Open addressing hash table of every object the GetObject() interface
+  /// can return, keyed by (CmObjectId, Token). ObjectStoreSize is a power
+  /// of two.
+  ///
+  CM_OBJECT_STORE_ENTRY                    *ObjectStore;
+  UINTN                                    ObjectStoreSize;
 } EDKII_PLATFORM_REPOSITORY_INFO;
 
 #endif // CONFIGURATION_MANAGER_H_
@@ -24,6 +24,31 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 VOID  *mHobList = NULL;
 
+//
+// GUID HOB index
+//
+// GUID extension HOBs are looked up by many drivers from their constructors
+// and entry points, and a linear walk has to step over every memory
+// allocation and resource descriptor HOB to find them. The index is built
+// on first use from the GUID HOBs in the list and maps a GUID hash bucket to
+// a chain of HOB offsets, kept in HOB list order. It lives in static storage
+// as this library cannot depend on MemoryAllocationLib, and lookups fall back
+// to a linear walk if the list holds more GUID HOBs than the index can track.
+//
+#define HOB_INDEX_BUCKET_COUNT  64
+#define HOB_INDEX_ENTRY_COUNT   256
+#define HOB_INDEX_NIL           MAX_UINT16
+
+typedef struct {
+  UINT32    Offset;
+  UINT16    Next;
+} HOB_INDEX_ENTRY;
+
+STATIC BOOLEAN          mHobIndexValid;
+STATIC VOID             *mHobIndexEnd;
+STATIC UINT16           mHobIndexBucket[HOB_INDEX_BUCKET_COUNT];
+STATIC HOB_INDEX_ENTRY  mHobIndexEntry[HOB_INDEX_ENTRY_COUNT];
+
 /**
   The constructor function caches the pointer to HOB list.
 
@@ -149,6 +174,120 @@ GetFirstHob (
   return GetNextHob (Type, HobList);
 }
 
+/**
+  Hash a GUID into a GUID HOB index bucket.
+
+  @param  Guid          The GUID to hash.
+
+  @return The bucket number.
+
+**/
+STATIC
+UINTN
+HobIndexBucket (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINT32  Hash;
+
+  Hash = Guid->Data1 ^ ((UINT32)Guid->Data2 << 16) ^ Guid->Data3 ^
+         ((UINT32)Guid->Data4[6] << 8) ^ Guid->Data4[7];
+  Hash ^= Hash >> 16;
+  return (Hash ^ (Hash >> 8)) & (HOB_INDEX_BUCKET_COUNT - 1);
+}
+
+/**
+  Build the GUID HOB index from the current HOB list.
+
+  Entries are appended at the tail of their bucket chain so that each chain
+  is kept in HOB list order. If the list holds more GUID HOBs than the index
+  can track, the index is left invalid and lookups walk the list instead.
+
+**/
+STATIC
+VOID
+HobIndexBuild (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  UINT8                 *HobList;
+  UINT16                Tail[HOB_INDEX_BUCKET_COUNT];
+  UINTN                 Bucket;
+  UINT16                Count;
+
+  mHobIndexValid = FALSE;
+
+  HobList      = (UINT8 *)GetHobList ();
+  mHobIndexEnd = (VOID *)(UINTN)((EFI_HOB_HANDOFF_INFO_TABLE *)HobList)->EfiEndOfHobList;
+
+  SetMem16 (mHobIndexBucket, sizeof (mHobIndexBucket), HOB_INDEX_NIL);
+  SetMem16 (Tail, sizeof (Tail), HOB_INDEX_NIL);
+
+  Count = 0;
+  for (Hob.Raw = HobList; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if (Hob.Header->HobType != EFI_HOB_TYPE_GUID_EXTENSION) {
+      continue;
+    }
+
+    if ((Count == HOB_INDEX_ENTRY_COUNT) || ((UINTN)(Hob.Raw - HobList) > MAX_UINT32)) {
+      return;
+    }
+
+    mHobIndexEntry[Count].Offset = (UINT32)(Hob.Raw - HobList);
+    mHobIndexEntry[Count].Next   = HOB_INDEX_NIL;
+
+    Bucket = HobIndexBucket (&Hob.Guid->Name);
+    if (Tail[Bucket] == HOB_INDEX_NIL) {
+      mHobIndexBucket[Bucket] = Count;
+    } else {
+      mHobIndexEntry[Tail[Bucket]].Next = Count;
+    }
+
+    Tail[Bucket] = Count;
+    Count++;
+  }
+
+  mHobIndexValid = TRUE;
+}
+
+/**
+  Check whether a GUID HOB lookup starting at HobStart can be served from the
+  GUID HOB index, building or rebuilding the index as needed.
+
+  The index is rebuilt when the end of the HOB list recorded in the PHIT HOB
+  has moved since it was built, i.e., when HOBs were added to the list.
+
+  @param  HobStart      The starting HOB pointer of the lookup.
+
+  @retval TRUE          The index covers HobStart and is up to date.
+  @retval FALSE         The lookup must walk the HOB list.
+
+**/
+STATIC
+BOOLEAN
+HobIndexIsUsable (
+  IN CONST VOID  *HobStart
+  )
+{
+  EFI_HOB_HANDOFF_INFO_TABLE  *HandOffHob;
+
+  HandOffHob = (EFI_HOB_HANDOFF_INFO_TABLE *)GetHobList ();
+  if ((CONST UINT8 *)HobStart < (UINT8 *)HandOffHob) {
+    return FALSE;
+  }
+
+  if ((CONST UINT8 *)HobStart > (UINT8 *)(UINTN)HandOffHob->EfiEndOfHobList) {
+    return FALSE;
+  }
+
+  if (mHobIndexEnd != (VOID *)(UINTN)HandOffHob->EfiEndOfHobList) {
+    HobIndexBuild ();
+  }
+
+  return mHobIndexValid;
+}
+
 /**
   Returns the next instance of the matched GUID HOB from the starting HOB.
 
@@ -179,6 +318,25 @@ GetNextGuidHob (
   )
 {
   EFI_PEI_HOB_POINTERS  GuidHob;
+  UINT8                 *HobList;
+  UINT16                Index;
+
+  if (HobIndexIsUsable (HobStart)) {
+    HobList = (UINT8 *)GetHobList ();
+    for (Index = mHobIndexBucket[HobIndexBucket (Guid)];
+         Index != HOB_INDEX_NIL;
+         Index = mHobIndexEntry[Index].Next)
+    {
+      GuidHob.Raw = HobList + mHobIndexEntry[Index].Offset;
+      if ((GuidHob.Raw >= (UINT8 *)HobStart) &&
+          CompareGuid (Guid, &GuidHob.Guid->Name))
+      {
+        return GuidHob.Raw;
+      }
+    }
+
+    return NULL;
+  }
 
   GuidHob.Raw = (UINT8 *)HobStart;
   while ((GuidHob.Raw = GetNextHob (EFI_HOB_TYPE_GUID_EXTENSION, GuidHob.Raw)) != NULL) {
@@ -14,10 +14,8 @@
 #include <Library/ArmGicArchLib.h>
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
+#include <Library/FdtIndexLib.h>
 #include <Library/PcdLib.h>
-#include <Library/UefiBootServicesTableLib.h>
-
-#include <Protocol/FdtClient.h>
 
 STATIC ARM_GIC_ARCH_REVISION  mGicArchRevision;
 
@@ -27,45 +25,21 @@ ArmVirtGicArchLibConstructor (
   VOID
   )
 {
-  UINT32               IccSre;
-  FDT_CLIENT_PROTOCOL  *FdtClient;
-  CONST UINT64         *Reg;
-  UINT32               RegSize;
-  UINTN                AddressCells, SizeCells;
-  UINTN                GicRevision;
-  EFI_STATUS           Status;
-  UINT64               DistBase, CpuBase, RedistBase;
-  RETURN_STATUS        PcdStatus;
-
-  Status = gBS->LocateProtocol (
-                  &gFdtClientProtocolGuid,
-                  NULL,
-                  (VOID **)&FdtClient
-                  );
-  ASSERT_EFI_ERROR (Status);
+  UINT32                IccSre;
+  CONST FDT_INDEX_NODE  *GicNode;
+  UINTN                 GicRevision;
+  RETURN_STATUS         Status;
+  UINT64                DistBase, CpuBase, RedistBase;
+  RETURN_STATUS         PcdStatus;
 
   GicRevision = 2;
-  Status      = FdtClient->FindCompatibleNodeReg (
-                             FdtClient,
-                             "arm,cortex-a15-gic",
-                             (CONST VOID **)&Reg,
-                             &AddressCells,
-                             &SizeCells,
-                             &RegSize
-                             );
-  if (Status == EFI_NOT_FOUND) {
+  Status      = FdtIndexFindCompatibleNode ("arm,cortex-a15-gic", &GicNode);
+  if (Status == RETURN_NOT_FOUND) {
     GicRevision = 3;
-    Status      = FdtClient->FindCompatibleNodeReg (
-                               FdtClient,
-                               "arm,gic-v3",
-                               (CONST VOID **)&Reg,
-                               &AddressCells,
-                               &SizeCells,
-                               &RegSize
-                               );
+    Status      = FdtIndexFindCompatibleNode ("arm,gic-v3", &GicNode);
   }
 
-  if (EFI_ERROR (Status)) {
+  if (RETURN_ERROR (Status)) {
     return Status;
   }
 
@@ -83,14 +57,16 @@ ArmVirtGicArchLibConstructor (
       // This means we are only interested in the first two memory regions
       // supplied, and ignore everything else.
       //
-      ASSERT (RegSize >= 32);
+      ASSERT (GicNode->RegCount >= 2);
 
-      // RegProp[0..1] == { GICD base, GICD size }
-      DistBase = SwapBytes64 (Reg[0]);
-      ASSERT (DistBase < MAX_UINTN);
+      // Reg[0] == { GICD base, GICD size }, Reg[1] == { GICR base, GICR size }
+      if (RETURN_ERROR (FdtIndexGetNodeReg (GicNode, 0, &DistBase, NULL)) ||
+          RETURN_ERROR (FdtIndexGetNodeReg (GicNode, 1, &RedistBase, NULL)))
+      {
+        return RETURN_NOT_FOUND;
+      }
 
-      // RegProp[2..3] == { GICR base, GICR size }
-      RedistBase = SwapBytes64 (Reg[2]);
+      ASSERT (DistBase < MAX_UINTN);
       ASSERT (RedistBase < MAX_UINTN);
 
       PcdStatus = PcdSet64S (PcdGicDistributorBase, DistBase);
@@ -132,10 +108,14 @@ ArmVirtGicArchLibConstructor (
       // set of control registers. This means the register property can be
       // either 32 or 64 bytes in size.
       //
-      ASSERT ((RegSize == 32) || (RegSize == 64));
+      ASSERT ((GicNode->RegCount == 2) || (GicNode->RegCount == 4));
+
+      if (RETURN_ERROR (FdtIndexGetNodeReg (GicNode, 0, &DistBase, NULL)) ||
+          RETURN_ERROR (FdtIndexGetNodeReg (GicNode, 1, &CpuBase, NULL)))
+      {
+        return RETURN_NOT_FOUND;
+      }
 
-      DistBase = SwapBytes64 (Reg[0]);
-      CpuBase  = SwapBytes64 (Reg[2]);
       ASSERT (DistBase < MAX_UINTN);
       ASSERT (CpuBase < MAX_UINTN);
 
@@ -11,20 +11,86 @@
 
 #include <Library/ArmMmuLib.h>
 #include <Library/ArmVirtMemInfoLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/HobLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PcdLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/CacheMaintenanceLib.h>
 
+#include "ArmVirtMemoryInitPeiLib.h"
+
 VOID
 BuildMemoryTypeInformationHob (
   VOID
   );
 
+/**
+  Extend the platform memory map with the device tree memory ranges that it
+  does not cover yet, so that every memory range is mapped as normal memory.
+
+  @param[in]  MemoryTable   The zero terminated platform memory map.
+  @param[in]  NodeInfo      The memory ranges found in the device tree.
+
+  @return The extended, zero terminated memory map, or MemoryTable if it
+          already covers every range or no memory could be allocated.
+
+**/
+STATIC
+ARM_MEMORY_REGION_DESCRIPTOR *
+AddMemoryNodeRanges (
+  IN ARM_MEMORY_REGION_DESCRIPTOR     *MemoryTable,
+  IN CONST ARM_VIRT_MEMORY_NODE_INFO  *NodeInfo
+  )
+{
+  ARM_MEMORY_REGION_DESCRIPTOR  *NewTable;
+  UINTN                         Count;
+  UINTN                         Index;
+  UINT64                        SystemMemoryBase;
+  UINT64                        SystemMemoryTop;
+  CONST ARM_VIRT_MEMORY_RANGE   *Range;
+
+  for (Count = 0; MemoryTable[Count].Length != 0; Count++) {
+  }
+
+  NewTable = AllocatePool ((Count + NodeInfo->RangeCount + 1) * sizeof (*NewTable));
+  if (NewTable == NULL) {
+    return MemoryTable;
+  }
+
+  CopyMem (NewTable, MemoryTable, Count * sizeof (*NewTable));
+
+  SystemMemoryBase = PcdGet64 (PcdSystemMemoryBase);
+  SystemMemoryTop  = SystemMemoryBase + PcdGet64 (PcdSystemMemorySize);
+
+  for (Index = 0; Index < NodeInfo->RangeCount; Index++) {
+    Range = &NodeInfo->Range[Index];
+    if ((Range->Base >= SystemMemoryBase) &&
+        (Range->Base + Range->Length <= SystemMemoryTop))
+    {
+      continue;
+    }
+
+    //
+    // Entries are mapped in order, so these override any device mapping the
+    // platform may have put in place for the rest of the address space. The
+    // MMU code uses block mappings wherever the ranges are suitably aligned.
+    //
+    NewTable[Count].PhysicalBase = Range->Base;
+    NewTable[Count].VirtualBase  = Range->Base;
+    NewTable[Count].Length       = Range->Length;
+    NewTable[Count].Attributes   = ARM_MEMORY_REGION_ATTRIBUTE_WRITE_BACK;
+    Count++;
+  }
+
+  ZeroMem (&NewTable[Count], sizeof (*NewTable));
+  return NewTable;
+}
+
 VOID
 InitMmu (
-  VOID
+  IN CONST ARM_VIRT_MEMORY_NODE_INFO  *NodeInfo OPTIONAL
   )
 {
   ARM_MEMORY_REGION_DESCRIPTOR  *MemoryTable;
@@ -35,14 +101,68 @@ InitMmu (
   // Get Virtual Memory Map from the Platform Library
   ArmVirtGetMemoryMap (&MemoryTable);
 
+  if (NodeInfo != NULL) {
+    MemoryTable = AddMemoryNodeRanges (MemoryTable, NodeInfo);
+  }
+
   // Note: Because we called PeiServicesInstallPeiMemory() before to call InitMmu() the MMU Page Table resides in
   //      DRAM (even at the top of DRAM as it is the first permanent memory allocation)
+  PERF_INMODULE_BEGIN ("ArmConfigureMmu");
   Status = ArmConfigureMmu (MemoryTable, &TranslationTableBase, &TranslationTableSize);
+  PERF_INMODULE_END ("ArmConfigureMmu");
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Error: Failed to enable MMU\n"));
   }
 }
 
+/**
+  Describe a range of system memory with resource descriptor HOBs, splitting
+  it at MAX_ALLOC_ADDRESS if it straddles that boundary.
+
+  @param[in]  Base                The base of the memory range.
+  @param[in]  Length              The length of the memory range.
+  @param[in]  ResourceAttributes  The resource attributes of the range.
+
+**/
+STATIC
+VOID
+BuildSystemMemoryHobs (
+  IN UINT64                       Base,
+  IN UINT64                       Length,
+  IN EFI_RESOURCE_ATTRIBUTE_TYPE  ResourceAttributes
+  )
+{
+  UINT64  Top;
+
+  if (Length == 0) {
+    return;
+  }
+
+  Top = Base + Length;
+
+  if ((Base <= MAX_ALLOC_ADDRESS) && (Top - 1 > MAX_ALLOC_ADDRESS)) {
+    BuildResourceDescriptorHob (
+      EFI_RESOURCE_SYSTEM_MEMORY,
+      ResourceAttributes,
+      Base,
+      (UINT64)MAX_ALLOC_ADDRESS - Base + 1
+      );
+    BuildResourceDescriptorHob (
+      EFI_RESOURCE_SYSTEM_MEMORY,
+      ResourceAttributes,
+      (UINT64)MAX_ALLOC_ADDRESS + 1,
+      Top - MAX_ALLOC_ADDRESS - 1
+      );
+  } else {
+    BuildResourceDescriptorHob (
+      EFI_RESOURCE_SYSTEM_MEMORY,
+      ResourceAttributes,
+      Base,
+      Length
+      );
+  }
+}
+
 EFI_STATUS
 EFIAPI
 MemoryPeim (
@@ -51,7 +171,12 @@ MemoryPeim (
   )
 {
   EFI_RESOURCE_ATTRIBUTE_TYPE  ResourceAttributes;
+  UINT64                       SystemMemoryBase;
   UINT64                       SystemMemoryTop;
+  ARM_VIRT_MEMORY_NODE_INFO    *NodeInfo;
+  UINT32                       Index;
+  UINT64                       RangeBase;
+  UINT64                       RangeTop;
 
   // Ensure PcdSystemMemorySize has been set
   ASSERT (PcdGet64 (PcdSystemMemorySize) != 0);
@@ -66,33 +191,47 @@ MemoryPeim (
                         EFI_RESOURCE_ATTRIBUTE_TESTED
                         );
 
-  SystemMemoryTop = PcdGet64 (PcdSystemMemoryBase) +
-                    PcdGet64 (PcdSystemMemorySize);
+  SystemMemoryBase = PcdGet64 (PcdSystemMemoryBase);
+  SystemMemoryTop  = SystemMemoryBase + PcdGet64 (PcdSystemMemorySize);
 
-  if (SystemMemoryTop - 1 > MAX_ALLOC_ADDRESS) {
-    BuildResourceDescriptorHob (
-      EFI_RESOURCE_SYSTEM_MEMORY,
-      ResourceAttributes,
-      PcdGet64 (PcdSystemMemoryBase),
-      (UINT64)MAX_ALLOC_ADDRESS - PcdGet64 (PcdSystemMemoryBase) + 1
-      );
-    BuildResourceDescriptorHob (
-      EFI_RESOURCE_SYSTEM_MEMORY,
-      ResourceAttributes,
-      (UINT64)MAX_ALLOC_ADDRESS + 1,
-      SystemMemoryTop - MAX_ALLOC_ADDRESS - 1
-      );
-  } else {
-    BuildResourceDescriptorHob (
-      EFI_RESOURCE_SYSTEM_MEMORY,
-      ResourceAttributes,
-      PcdGet64 (PcdSystemMemoryBase),
-      PcdGet64 (PcdSystemMemorySize)
-      );
+  BuildSystemMemoryHobs (
+    SystemMemoryBase,
+    PcdGet64 (PcdSystemMemorySize),
+    ResourceAttributes
+    );
+
+  //
+  // Describe all the other memory ranges from the device tree right away,
+  // rather than leaving them to be discovered late in the DXE phase. The
+  // part of each range that overlaps the primary system memory region is
+  // already covered above.
+  //
+  NodeInfo = BuildMemoryNodeInfoHob ();
+  if (NodeInfo != NULL) {
+    for (Index = 0; Index < NodeInfo->RangeCount; Index++) {
+      RangeBase = NodeInfo->Range[Index].Base;
+      RangeTop  = RangeBase + NodeInfo->Range[Index].Length;
+
+      if (RangeBase < SystemMemoryBase) {
+        BuildSystemMemoryHobs (
+          RangeBase,
+          MIN (RangeTop, SystemMemoryBase) - RangeBase,
+          ResourceAttributes
+          );
+      }
+
+      if (RangeTop > SystemMemoryTop) {
+        BuildSystemMemoryHobs (
+          MAX (RangeBase, SystemMemoryTop),
+          RangeTop - MAX (RangeBase, SystemMemoryTop),
+          ResourceAttributes
+          );
+      }
+    }
   }
 
   // Build Memory Allocation Hob
-  InitMmu ();
+  InitMmu (NodeInfo);
 
   if (FeaturePcdGet (PcdPrePiProduceMemoryTypeInformationHob)) {
     // Optional feature that helps prevent EFI memory map fragmentation.
@@ -0,0 +1,27 @@
+/** @file
+  Internal definitions of the ArmVirt MemoryInitPeiLib instance.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef ARM_VIRT_MEMORY_INIT_PEI_LIB_H_
+#define ARM_VIRT_MEMORY_INIT_PEI_LIB_H_
+
+#include <Guid/ArmVirtMemoryNodeInfo.h>
+
+/**
+  Describe every memory range found in the device tree in a
+  gArmVirtMemoryNodeInfoGuid HOB, tagged with its proximity domain.
+
+  @return The memory node information HOB data, or NULL if there is no valid
+          device tree or it describes no memory.
+
+**/
+ARM_VIRT_MEMORY_NODE_INFO *
+BuildMemoryNodeInfoHob (
+  VOID
+  );
+
+#endif
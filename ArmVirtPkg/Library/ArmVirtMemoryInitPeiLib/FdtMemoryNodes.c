@@ -0,0 +1,207 @@
+/** @file
+  Discover every system memory range described in the device tree.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/PcdLib.h>
+#include <libfdt.h>
+
+#include <Guid/ArmVirtMemoryNodeInfo.h>
+
+#include "ArmVirtMemoryInitPeiLib.h"
+
+/**
+  Decode a cell-encoded number from a device tree property.
+
+  @param[in]  Cells       Pointer to the first cell.
+  @param[in]  CellCount   The number of cells, 1 or 2.
+
+  @return The decoded number.
+
+**/
+STATIC
+UINT64
+ReadCells (
+  IN CONST UINT32  *Cells,
+  IN UINT32        CellCount
+  )
+{
+  UINT64  Value;
+
+  Value = fdt32_to_cpu (ReadUnaligned32 (Cells));
+  if (CellCount > 1) {
+    Value = LShiftU64 (Value, 32) | fdt32_to_cpu (ReadUnaligned32 (Cells + 1));
+  }
+
+  return Value;
+}
+
+/**
+  Walk all the memory nodes of the device tree and their 'reg' ranges.
+
+  @param[in]   DeviceTreeBase   The device tree blob.
+  @param[out]  NodeInfo         If not NULL, the ranges are recorded here. It
+                                must have room for the number of ranges
+                                returned by a previous call with NULL.
+
+  @return The number of memory ranges found.
+
+**/
+STATIC
+UINT32
+EnumerateMemoryRanges (
+  IN  CONST VOID                 *DeviceTreeBase,
+  OUT ARM_VIRT_MEMORY_NODE_INFO  *NodeInfo OPTIONAL
+  )
+{
+  INT32         Node;
+  INT32         Prev;
+  INT32         Len;
+  CONST CHAR8   *Type;
+  CONST UINT32  *Prop;
+  CONST UINT32  *Reg;
+  UINT32        AddressCells;
+  UINT32        SizeCells;
+  UINT32        CellsPerRange;
+  UINT32        Domain;
+  UINT32        Count;
+  UINT64        Length;
+
+  AddressCells = 2;
+  SizeCells    = 2;
+
+  Prop = fdt_getprop (DeviceTreeBase, 0, "#address-cells", &Len);
+  if ((Prop != NULL) && (Len == sizeof (UINT32))) {
+    AddressCells = fdt32_to_cpu (ReadUnaligned32 (Prop));
+  }
+
+  Prop = fdt_getprop (DeviceTreeBase, 0, "#size-cells", &Len);
+  if ((Prop != NULL) && (Len == sizeof (UINT32))) {
+    SizeCells = fdt32_to_cpu (ReadUnaligned32 (Prop));
+  }
+
+  if ((AddressCells == 0) || (AddressCells > 2) ||
+      (SizeCells == 0) || (SizeCells > 2))
+  {
+    DEBUG ((DEBUG_ERROR, "%a: unsupported #address-cells/#size-cells\n", __FUNCTION__));
+    return 0;
+  }
+
+  CellsPerRange = AddressCells + SizeCells;
+  Count         = 0;
+
+  for (Prev = 0; ; Prev = Node) {
+    Node = fdt_next_node (DeviceTreeBase, Prev, NULL);
+    if (Node < 0) {
+      break;
+    }
+
+    Type = fdt_getprop (DeviceTreeBase, Node, "device_type", &Len);
+    if ((Type == NULL) || (AsciiStrnCmp (Type, "memory", Len) != 0)) {
+      continue;
+    }
+
+    Prop = fdt_getprop (DeviceTreeBase, Node, "status", &Len);
+    if ((Prop != NULL) &&
+        (AsciiStrCmp ((CONST CHAR8 *)Prop, "okay") != 0) &&
+        (AsciiStrCmp ((CONST CHAR8 *)Prop, "ok") != 0))
+    {
+      continue;
+    }
+
+    Domain = 0;
+    Prop   = fdt_getprop (DeviceTreeBase, Node, "numa-node-id", &Len);
+    if ((Prop != NULL) && (Len == sizeof (UINT32))) {
+      Domain = fdt32_to_cpu (ReadUnaligned32 (Prop));
+    }
+
+    Reg = fdt_getprop (DeviceTreeBase, Node, "reg", &Len);
+    if (Reg == NULL) {
+      continue;
+    }
+
+    for ( ; Len >= (INT32)(CellsPerRange * sizeof (UINT32));
+          Len -= CellsPerRange * sizeof (UINT32), Reg += CellsPerRange)
+    {
+      Length = ReadCells (Reg + AddressCells, SizeCells);
+      if (Length == 0) {
+        continue;
+      }
+
+      if (NodeInfo != NULL) {
+        NodeInfo->Range[Count].Base            = ReadCells (Reg, AddressCells);
+        NodeInfo->Range[Count].Length          = Length;
+        NodeInfo->Range[Count].ProximityDomain = Domain;
+        NodeInfo->Range[Count].Reserved        = 0;
+        NodeInfo->NumaNodeCount                = MAX (NodeInfo->NumaNodeCount, Domain + 1);
+      }
+
+      Count++;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Describe every memory range found in the device tree in a
+  gArmVirtMemoryNodeInfoGuid HOB, tagged with its proximity domain.
+
+  @return The memory node information HOB data, or NULL if there is no valid
+          device tree or it describes no memory.
+
+**/
+ARM_VIRT_MEMORY_NODE_INFO *
+BuildMemoryNodeInfoHob (
+  VOID
+  )
+{
+  CONST VOID                 *DeviceTreeBase;
+  ARM_VIRT_MEMORY_NODE_INFO  *NodeInfo;
+  UINT32                     Count;
+  UINT32                     Index;
+
+  DeviceTreeBase = (CONST VOID *)(UINTN)PcdGet64 (PcdDeviceTreeInitialBaseAddress);
+  if ((DeviceTreeBase == NULL) || (fdt_check_header (DeviceTreeBase) != 0)) {
+    return NULL;
+  }
+
+  Count = EnumerateMemoryRanges (DeviceTreeBase, NULL);
+  if (Count == 0) {
+    return NULL;
+  }
+
+  NodeInfo = BuildGuidHob (
+               &gArmVirtMemoryNodeInfoGuid,
+               sizeof (ARM_VIRT_MEMORY_NODE_INFO) +
+               Count * sizeof (ARM_VIRT_MEMORY_RANGE)
+               );
+  if (NodeInfo == NULL) {
+    return NULL;
+  }
+
+  NodeInfo->NumaNodeCount = 1;
+  NodeInfo->RangeCount    = EnumerateMemoryRanges (DeviceTreeBase, NodeInfo);
+  ASSERT (NodeInfo->RangeCount == Count);
+
+  for (Index = 0; Index < NodeInfo->RangeCount; Index++) {
+    DEBUG ((
+      DEBUG_INFO,
+      "%a: System RAM @ 0x%lx - 0x%lx (proximity domain %u)\n",
+      __FUNCTION__,
+      NodeInfo->Range[Index].Base,
+      NodeInfo->Range[Index].Base + NodeInfo->Range[Index].Length - 1,
+      NodeInfo->Range[Index].ProximityDomain
+      ));
+  }
+
+  return NodeInfo;
+}
@@ -0,0 +1,91 @@
+/** @file
+  FDT client library for ArmPsciMpServicesDxe. Sets PcdMonitorConduitHvc
+  from the 'method' property of the /psci node.
+
+  This runs in the context of the driver itself rather than in the PEI phase,
+  so that the PCD is set on platforms whose early phase is PrePi, which has no
+  PCD database to hand over to DXE.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include <Protocol/FdtClient.h>
+
+//
+// Compatible strings of the /psci node, most recent binding first.
+//
+STATIC CONST CHAR8  *mPsciCompatibles[] = {
+  "arm,psci-1.0",
+  "arm,psci-0.2",
+  "arm,psci",
+};
+
+RETURN_STATUS
+EFIAPI
+ArmVirtPsciConduitFdtClientLibConstructor (
+  VOID
+  )
+{
+  EFI_STATUS           Status;
+  FDT_CLIENT_PROTOCOL  *FdtClient;
+  CONST VOID           *Prop;
+  UINT32               PropSize;
+  UINTN                Index;
+  RETURN_STATUS        PcdStatus;
+
+  Status = gBS->LocateProtocol (
+                  &gFdtClientProtocolGuid,
+                  NULL,
+                  (VOID **)&FdtClient
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < ARRAY_SIZE (mPsciCompatibles); Index++) {
+    Status = FdtClient->FindCompatibleNodeProperty (
+                          FdtClient,
+                          mPsciCompatibles[Index],
+                          "method",
+                          &Prop,
+                          &PropSize
+                          );
+    if (!EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    //
+    // Without a /psci node, PlatformPeiLib does not describe the secondary
+    // cores, and the driver only reports the boot processor.
+    //
+    return EFI_SUCCESS;
+  }
+
+  if (AsciiStrnCmp (Prop, "hvc", PropSize) == 0) {
+    PcdStatus = PcdSetBoolS (PcdMonitorConduitHvc, TRUE);
+  } else if (AsciiStrnCmp (Prop, "smc", PropSize) == 0) {
+    PcdStatus = PcdSetBoolS (PcdMonitorConduitHvc, FALSE);
+  } else {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: Unknown PSCI method \"%a\"\n",
+      __func__,
+      Prop
+      ));
+    return EFI_SUCCESS;
+  }
+
+  ASSERT_RETURN_ERROR (PcdStatus);
+
+  return EFI_SUCCESS;
+}
@@ -11,10 +11,8 @@
 
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
+#include <Library/FdtIndexLib.h>
 #include <Library/PcdLib.h>
-#include <Library/UefiBootServicesTableLib.h>
-
-#include <Protocol/FdtClient.h>
 
 #pragma pack (1)
 typedef struct {
@@ -30,54 +28,46 @@ ArmVirtTimerFdtClientLibConstructor (
   VOID
   )
 {
-  EFI_STATUS                Status;
-  FDT_CLIENT_PROTOCOL       *FdtClient;
+  RETURN_STATUS             Status;
+  CONST FDT_INDEX_NODE      *TimerNode;
   CONST INTERRUPT_PROPERTY  *InterruptProp;
-  UINT32                    PropSize;
+  UINT32                    CellCount;
   INT32                     SecIntrNum, IntrNum, VirtIntrNum, HypIntrNum;
   RETURN_STATUS             PcdStatus;
 
-  Status = gBS->LocateProtocol (
-                  &gFdtClientProtocolGuid,
-                  NULL,
-                  (VOID **)&FdtClient
-                  );
-  ASSERT_EFI_ERROR (Status);
-
-  Status = FdtClient->FindCompatibleNodeProperty (
-                        FdtClient,
-                        "arm,armv7-timer",
-                        "interrupts",
-                        (CONST VOID **)&InterruptProp,
-                        &PropSize
-                        );
-  if (Status == EFI_NOT_FOUND) {
-    Status = FdtClient->FindCompatibleNodeProperty (
-                          FdtClient,
-                          "arm,armv8-timer",
-                          "interrupts",
-                          (CONST VOID **)&InterruptProp,
-                          &PropSize
-                          );
+  Status = FdtIndexFindCompatibleNode ("arm,armv7-timer", &TimerNode);
+  if (Status == RETURN_NOT_FOUND) {
+    Status = FdtIndexFindCompatibleNode ("arm,armv8-timer", &TimerNode);
   }
 
-  if (EFI_ERROR (Status)) {
+  if (RETURN_ERROR (Status)) {
     return Status;
   }
 
+  //
+  // The index holds the 'interrupts' cells in CPU byte order.
+  //
+  InterruptProp = (CONST INTERRUPT_PROPERTY *)FdtIndexGetNodeInterrupts (
+                                                TimerNode,
+                                                &CellCount
+                                                );
+  if (InterruptProp == NULL) {
+    return RETURN_NOT_FOUND;
+  }
+
   //
   // - interrupts : Interrupt list for secure, non-secure, virtual and
   //  hypervisor timers, in that order.
   //
-  ASSERT (PropSize == 36 || PropSize == 48);
+  ASSERT (CellCount == 9 || CellCount == 12);
 
-  SecIntrNum = SwapBytes32 (InterruptProp[0].Number)
+  SecIntrNum = InterruptProp[0].Number
                + (InterruptProp[0].Type ? 16 : 0);
-  IntrNum = SwapBytes32 (InterruptProp[1].Number)
+  IntrNum = InterruptProp[1].Number
             + (InterruptProp[1].Type ? 16 : 0);
-  VirtIntrNum = SwapBytes32 (InterruptProp[2].Number)
+  VirtIntrNum = InterruptProp[2].Number
                 + (InterruptProp[2].Type ? 16 : 0);
-  HypIntrNum = PropSize < 48 ? 0 : SwapBytes32 (InterruptProp[3].Number)
+  HypIntrNum = CellCount < 12 ? 0 : InterruptProp[3].Number
                + (InterruptProp[3].Type ? 16 : 0);
 
   DEBUG ((
@@ -98,5 +88,5 @@ ArmVirtTimerFdtClientLibConstructor (
   PcdStatus = PcdSet32S (PcdArmArchTimerHypIntrNum, HypIntrNum);
   ASSERT_RETURN_ERROR (PcdStatus);
 
-  return EFI_SUCCESS;
+  return RETURN_SUCCESS;
 }
@@ -0,0 +1,358 @@
+/** @file
+  Build the gFdtIndexHobGuid index in a single pass over the device tree.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi/UefiBaseType.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FdtIndexLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <libfdt.h>
+
+#include "FdtIndexLibInternal.h"
+
+//
+// Nodes nested deeper than this are not indexed.
+//
+#define FDT_INDEX_MAX_DEPTH  32
+
+typedef struct {
+  UINT32    NodeCount;
+  UINT32    CompatibleCount;
+  UINT32    RegCount;
+  UINT32    InterruptCellCount;
+  UINT32    StringPoolSize;
+} FDT_INDEX_COUNTS;
+
+/**
+  Decode a cell-encoded number from a device tree property.
+
+  @param[in]  Cells       Pointer to the first cell.
+  @param[in]  CellCount   The number of cells, 0 to 2.
+
+  @return The decoded number.
+
+**/
+STATIC
+UINT64
+ReadCells (
+  IN CONST UINT32  *Cells,
+  IN UINT32        CellCount
+  )
+{
+  UINT64  Value;
+
+  Value = 0;
+  while (CellCount-- > 0) {
+    Value = LShiftU64 (Value, 32) | fdt32_to_cpu (ReadUnaligned32 (Cells++));
+  }
+
+  return Value;
+}
+
+/**
+  Retrieve the #address-cells and #size-cells a node imposes on its children.
+
+  @param[in]   DeviceTreeBase   The device tree blob.
+  @param[in]   Node             The node offset.
+  @param[out]  AddressCells     The number of address cells, 2 by default.
+  @param[out]  SizeCells        The number of size cells, 1 by default.
+
+**/
+STATIC
+VOID
+GetChildCells (
+  IN  CONST VOID  *DeviceTreeBase,
+  IN  INT32       Node,
+  OUT UINT32      *AddressCells,
+  OUT UINT32      *SizeCells
+  )
+{
+  CONST UINT32  *Prop;
+  INT32         Len;
+
+  *AddressCells = 2;
+  *SizeCells    = 1;
+
+  Prop = fdt_getprop (DeviceTreeBase, Node, "#address-cells", &Len);
+  if ((Prop != NULL) && (Len == sizeof (UINT32))) {
+    *AddressCells = fdt32_to_cpu (ReadUnaligned32 (Prop));
+  }
+
+  Prop = fdt_getprop (DeviceTreeBase, Node, "#size-cells", &Len);
+  if ((Prop != NULL) && (Len == sizeof (UINT32))) {
+    *SizeCells = fdt32_to_cpu (ReadUnaligned32 (Prop));
+  }
+}
+
+/**
+  Walk the device tree and index every node that has a 'compatible' property.
+
+  @param[in]   DeviceTreeBase   The device tree blob.
+  @param[out]  Counts           The number of entries of each kind.
+  @param[in]   Index            If not NULL, the entries are recorded here. Its
+                                arrays must be sized using the counts returned
+                                by a previous call with NULL.
+
+**/
+STATIC
+VOID
+WalkDeviceTree (
+  IN  CONST VOID        *DeviceTreeBase,
+  OUT FDT_INDEX_COUNTS  *Counts,
+  IN  FDT_INDEX_HEADER  *Index OPTIONAL
+  )
+{
+  INT32                 Node;
+  INT32                 Prev;
+  INT32                 Depth;
+  INT32                 Len;
+  INT32                 ParentOffset[FDT_INDEX_MAX_DEPTH];
+  UINT32                AddressCells[FDT_INDEX_MAX_DEPTH];
+  UINT32                SizeCells[FDT_INDEX_MAX_DEPTH];
+  CONST CHAR8           *Compatible;
+  CONST CHAR8           *CompItem;
+  CONST CHAR8           *NodeStatus;
+  CONST UINT32          *Prop;
+  UINT32                ItemSize;
+  UINT32                CellsPerReg;
+  UINT32                RegCount;
+  UINT32                Cell;
+  FDT_INDEX_NODE        *IndexNode;
+  FDT_INDEX_COMPATIBLE  *IndexCompatible;
+  FDT_INDEX_REG         *IndexReg;
+  UINT32                *IndexCell;
+
+  ZeroMem (Counts, sizeof (*Counts));
+
+  ParentOffset[0] = 0;
+  GetChildCells (DeviceTreeBase, 0, &AddressCells[0], &SizeCells[0]);
+
+  for (Prev = Depth = 0; ; Prev = Node) {
+    Node = fdt_next_node (DeviceTreeBase, Prev, &Depth);
+    if (Node < 0) {
+      break;
+    }
+
+    if ((Depth <= 0) || (Depth >= FDT_INDEX_MAX_DEPTH)) {
+      continue;
+    }
+
+    ParentOffset[Depth] = Node;
+    GetChildCells (DeviceTreeBase, Node, &AddressCells[Depth], &SizeCells[Depth]);
+
+    Compatible = fdt_getprop (DeviceTreeBase, Node, "compatible", &Len);
+    if ((Compatible == NULL) || (Len <= 0)) {
+      continue;
+    }
+
+    IndexNode = NULL;
+    if (Index != NULL) {
+      IndexNode               = FDT_INDEX_ARRAY (Index, NodeArray, FDT_INDEX_NODE) + Counts->NodeCount;
+      IndexNode->NodeOffset   = Node;
+      IndexNode->ParentOffset = ParentOffset[Depth - 1];
+      IndexNode->Flags        = 0;
+
+      NodeStatus = fdt_getprop (DeviceTreeBase, Node, "status", NULL);
+      if ((NodeStatus == NULL) ||
+          (AsciiStrCmp (NodeStatus, "okay") == 0) ||
+          (AsciiStrCmp (NodeStatus, "ok") == 0))
+      {
+        IndexNode->Flags |= FDT_INDEX_NODE_ENABLED;
+      }
+    }
+
+    //
+    // Iterate over the NULL-separated items in the compatible string
+    //
+    for (CompItem = Compatible; CompItem < Compatible + Len;
+         CompItem += ItemSize)
+    {
+      ItemSize = (UINT32)AsciiStrLen (CompItem) + 1;
+
+      if (Index != NULL) {
+        IndexCompatible         = FDT_INDEX_ARRAY (Index, CompatibleArray, FDT_INDEX_COMPATIBLE) + Counts->CompatibleCount;
+        IndexCompatible->Hash   = FdtIndexHash (CompItem);
+        IndexCompatible->String = Counts->StringPoolSize;
+        IndexCompatible->Node   = Counts->NodeCount;
+        IndexCompatible->Next   = FDT_INDEX_NONE;
+        CopyMem (
+          FDT_INDEX_ARRAY (Index, StringPool, CHAR8) + Counts->StringPoolSize,
+          CompItem,
+          ItemSize
+          );
+      }
+
+      Counts->CompatibleCount++;
+      Counts->StringPoolSize += ItemSize;
+    }
+
+    //
+    // Decode the 'reg' property using the cell counts of the parent. Nodes on
+    // a PCI bus use 3 address cells and are left for the consumer to decode.
+    //
+    RegCount = 0;
+    Prop     = fdt_getprop (DeviceTreeBase, Node, "reg", &Len);
+    if ((Prop != NULL) && (Len > 0)) {
+      CellsPerReg = AddressCells[Depth - 1] + SizeCells[Depth - 1];
+      if ((AddressCells[Depth - 1] == 0) || (AddressCells[Depth - 1] > 2) ||
+          (SizeCells[Depth - 1] > 2))
+      {
+        if (IndexNode != NULL) {
+          IndexNode->Flags |= FDT_INDEX_NODE_REG_RAW;
+        }
+      } else {
+        RegCount = (UINT32)(Len / (CellsPerReg * sizeof (UINT32)));
+      }
+
+      if ((Index != NULL) && (RegCount > 0)) {
+        IndexReg = FDT_INDEX_ARRAY (Index, RegArray, FDT_INDEX_REG) + Counts->RegCount;
+        for (Cell = 0; Cell < RegCount * CellsPerReg; Cell += CellsPerReg) {
+          IndexReg->Base = ReadCells (Prop + Cell, AddressCells[Depth - 1]);
+          IndexReg->Size = ReadCells (Prop + Cell + AddressCells[Depth - 1], SizeCells[Depth - 1]);
+          IndexReg++;
+        }
+      }
+    }
+
+    if (IndexNode != NULL) {
+      IndexNode->FirstReg = Counts->RegCount;
+      IndexNode->RegCount = RegCount;
+    }
+
+    Counts->RegCount += RegCount;
+
+    Prop = fdt_getprop (DeviceTreeBase, Node, "interrupts", &Len);
+    if ((Prop == NULL) || (Len < 0)) {
+      Len = 0;
+    }
+
+    if (IndexNode != NULL) {
+      IndexNode->FirstInterruptCell = Counts->InterruptCellCount;
+      IndexNode->InterruptCellCount = (UINT32)(Len / sizeof (UINT32));
+
+      IndexCell = FDT_INDEX_ARRAY (Index, InterruptCellArray, UINT32) + Counts->InterruptCellCount;
+      for (Cell = 0; Cell < IndexNode->InterruptCellCount; Cell++) {
+        IndexCell[Cell] = fdt32_to_cpu (ReadUnaligned32 (Prop + Cell));
+      }
+    }
+
+    Counts->InterruptCellCount += (UINT32)(Len / sizeof (UINT32));
+    Counts->NodeCount++;
+  }
+}
+
+/**
+  Walk the device tree once and publish an index of its nodes in a
+  gFdtIndexHobGuid HOB.
+
+  @param[in]  DeviceTreeBase    The device tree blob the index describes. It
+                                must remain at this address for as long as
+                                node offsets from the index are used with it.
+
+  @retval RETURN_SUCCESS            The index was built.
+  @retval RETURN_INVALID_PARAMETER  DeviceTreeBase is not a valid device tree.
+  @retval RETURN_OUT_OF_RESOURCES   Memory could not be allocated.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexBuild (
+  IN  CONST VOID  *DeviceTreeBase
+  )
+{
+  FDT_INDEX_COUNTS      Counts;
+  FDT_INDEX_COUNTS      Recorded;
+  FDT_INDEX_HEADER      *Index;
+  FDT_INDEX_COMPATIBLE  *Compatible;
+  UINTN                 Size;
+  UINT32                Entry;
+  UINT32                Bucket;
+  UINT64                *HobData;
+
+  if ((DeviceTreeBase == NULL) || (fdt_check_header (DeviceTreeBase) != 0)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  WalkDeviceTree (DeviceTreeBase, &Counts, NULL);
+
+  //
+  // Lay out the arrays after the header, keeping the 64-bit reg entries
+  // naturally aligned.
+  //
+  Size = ALIGN_VALUE (sizeof (FDT_INDEX_HEADER), sizeof (UINT64));
+
+  Index = AllocatePages (
+            EFI_SIZE_TO_PAGES (
+              Size +
+              Counts.RegCount * sizeof (FDT_INDEX_REG) +
+              Counts.NodeCount * sizeof (FDT_INDEX_NODE) +
+              Counts.CompatibleCount * sizeof (FDT_INDEX_COMPATIBLE) +
+              Counts.InterruptCellCount * sizeof (UINT32) +
+              Counts.StringPoolSize
+              )
+            );
+  if (Index == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  Index->RegArray           = (UINT32)Size;
+  Size                     += Counts.RegCount * sizeof (FDT_INDEX_REG);
+  Index->NodeArray          = (UINT32)Size;
+  Size                     += Counts.NodeCount * sizeof (FDT_INDEX_NODE);
+  Index->CompatibleArray    = (UINT32)Size;
+  Size                     += Counts.CompatibleCount * sizeof (FDT_INDEX_COMPATIBLE);
+  Index->InterruptCellArray = (UINT32)Size;
+  Size                     += Counts.InterruptCellCount * sizeof (UINT32);
+  Index->StringPool         = (UINT32)Size;
+  Size                     += Counts.StringPoolSize;
+
+  Index->Size               = (UINT32)Size;
+  Index->NodeCount          = Counts.NodeCount;
+  Index->CompatibleCount    = Counts.CompatibleCount;
+  Index->RegCount           = Counts.RegCount;
+  Index->InterruptCellCount = Counts.InterruptCellCount;
+  Index->StringPoolSize     = Counts.StringPoolSize;
+
+  WalkDeviceTree (DeviceTreeBase, &Recorded, Index);
+  ASSERT (CompareMem (&Recorded, &Counts, sizeof (Counts)) == 0);
+
+  //
+  // Chain the compatible entries into their hash buckets. Inserting them at
+  // the head in reverse order keeps every chain in device tree order.
+  //
+  SetMem32 (Index->Bucket, sizeof (Index->Bucket), FDT_INDEX_NONE);
+
+  Compatible = FDT_INDEX_ARRAY (Index, CompatibleArray, FDT_INDEX_COMPATIBLE);
+  for (Entry = Index->CompatibleCount; Entry > 0; Entry--) {
+    Bucket                     = Compatible[Entry - 1].Hash % FDT_INDEX_BUCKET_COUNT;
+    Compatible[Entry - 1].Next = Index->Bucket[Bucket];
+    Index->Bucket[Bucket]      = Entry - 1;
+  }
+
+  HobData = BuildGuidHob (&gFdtIndexHobGuid, sizeof (*HobData));
+  if (HobData == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  *HobData = (UINTN)Index;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: indexed %u nodes, %u compatible strings, %u reg entries in %u bytes\n",
+    __FUNCTION__,
+    Index->NodeCount,
+    Index->CompatibleCount,
+    Index->RegCount,
+    Index->Size
+    ));
+
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,30 @@
+/** @file
+  Internal definitions shared by the FdtIndexLib build and lookup code.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef FDT_INDEX_LIB_INTERNAL_H_
+#define FDT_INDEX_LIB_INTERNAL_H_
+
+#include <Guid/FdtIndexHob.h>
+
+#define FDT_INDEX_ARRAY(Index, Field, Type) \
+  ((Type *)((UINTN)(Index) + (Index)->Field))
+
+/**
+  Hash a compatible string for the bucket table of the index.
+
+  @param[in]  String    The NUL terminated string.
+
+  @return The 32-bit FNV-1a hash of the string.
+
+**/
+UINT32
+FdtIndexHash (
+  IN  CONST CHAR8  *String
+  );
+
+#endif
@@ -0,0 +1,255 @@
+/** @file
+  Look up device tree nodes in the gFdtIndexHobGuid index.
+
+  Copyright (c) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FdtIndexLib.h>
+#include <Library/HobLib.h>
+
+#include "FdtIndexLibInternal.h"
+
+/**
+  Hash a compatible string for the bucket table of the index.
+
+  @param[in]  String    The NUL terminated string.
+
+  @return The 32-bit FNV-1a hash of the string.
+
+**/
+UINT32
+FdtIndexHash (
+  IN  CONST CHAR8  *String
+  )
+{
+  UINT32  Hash;
+
+  Hash = 0x811c9dc5;
+  while (*String != '\0') {
+    Hash = (Hash ^ (UINT8)*String++) * 0x01000193;
+  }
+
+  return Hash;
+}
+
+/**
+  Locate the index published by FdtIndexBuild ().
+
+  @return The index, or NULL if there is none.
+
+**/
+STATIC
+CONST FDT_INDEX_HEADER *
+GetFdtIndex (
+  VOID
+  )
+{
+  VOID  *Hob;
+
+  Hob = GetFirstGuidHob (&gFdtIndexHobGuid);
+  if ((Hob == NULL) || (GET_GUID_HOB_DATA_SIZE (Hob) != sizeof (UINT64))) {
+    return NULL;
+  }
+
+  return (CONST FDT_INDEX_HEADER *)(UINTN)ReadUnaligned64 (GET_GUID_HOB_DATA (Hob));
+}
+
+/**
+  Find the first enabled node with a node index of at least FirstNode that
+  lists CompatibleString in its 'compatible' property.
+
+  @param[in]   Index              The device tree index.
+  @param[in]   CompatibleString   The compatible string to look for.
+  @param[in]   FirstNode          The lowest node index to consider.
+  @param[out]  Node               The index entry of the node.
+
+  @retval RETURN_SUCCESS          A node was found.
+  @retval RETURN_NOT_FOUND        No matching node.
+
+**/
+STATIC
+RETURN_STATUS
+FindCompatibleNodeFrom (
+  IN  CONST FDT_INDEX_HEADER  *Index,
+  IN  CONST CHAR8             *CompatibleString,
+  IN  UINT32                  FirstNode,
+  OUT CONST FDT_INDEX_NODE    **Node
+  )
+{
+  CONST FDT_INDEX_NODE        *Nodes;
+  CONST FDT_INDEX_COMPATIBLE  *Compatible;
+  CONST CHAR8                 *StringPool;
+  UINT32                      Hash;
+  UINT32                      Entry;
+
+  Nodes      = FDT_INDEX_ARRAY (Index, NodeArray, CONST FDT_INDEX_NODE);
+  Compatible = FDT_INDEX_ARRAY (Index, CompatibleArray, CONST FDT_INDEX_COMPATIBLE);
+  StringPool = FDT_INDEX_ARRAY (Index, StringPool, CONST CHAR8);
+  Hash       = FdtIndexHash (CompatibleString);
+
+  //
+  // Entries are chained in device tree order, so the first match is the
+  // first matching node at or after FirstNode.
+  //
+  for (Entry = Index->Bucket[Hash % FDT_INDEX_BUCKET_COUNT];
+       Entry != FDT_INDEX_NONE;
+       Entry = Compatible[Entry].Next)
+  {
+    if ((Compatible[Entry].Hash != Hash) ||
+        (Compatible[Entry].Node < FirstNode) ||
+        ((Nodes[Compatible[Entry].Node].Flags & FDT_INDEX_NODE_ENABLED) == 0) ||
+        (AsciiStrCmp (StringPool + Compatible[Entry].String, CompatibleString) != 0))
+    {
+      continue;
+    }
+
+    *Node = &Nodes[Compatible[Entry].Node];
+    return RETURN_SUCCESS;
+  }
+
+  return RETURN_NOT_FOUND;
+}
+
+/**
+  Find the first enabled node, in device tree order, that lists
+  CompatibleString in its 'compatible' property.
+
+  @param[in]   CompatibleString   The compatible string to look for.
+  @param[out]  Node               The index entry of the node.
+
+  @retval RETURN_SUCCESS          A node was found.
+  @retval RETURN_NOT_FOUND        No matching node, or no index.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexFindCompatibleNode (
+  IN  CONST CHAR8           *CompatibleString,
+  OUT CONST FDT_INDEX_NODE  **Node
+  )
+{
+  CONST FDT_INDEX_HEADER  *Index;
+
+  Index = GetFdtIndex ();
+  if (Index == NULL) {
+    return RETURN_NOT_FOUND;
+  }
+
+  return FindCompatibleNodeFrom (Index, CompatibleString, 0, Node);
+}
+
+/**
+  Find the next enabled node after PrevNode, in device tree order, that lists
+  CompatibleString in its 'compatible' property.
+
+  @param[in]   CompatibleString   The compatible string to look for.
+  @param[in]   PrevNode           A node returned by a previous lookup.
+  @param[out]  Node               The index entry of the node.
+
+  @retval RETURN_SUCCESS          A node was found.
+  @retval RETURN_NOT_FOUND        No more matching nodes, or no index.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexFindNextCompatibleNode (
+  IN  CONST CHAR8           *CompatibleString,
+  IN  CONST FDT_INDEX_NODE  *PrevNode,
+  OUT CONST FDT_INDEX_NODE  **Node
+  )
+{
+  CONST FDT_INDEX_HEADER  *Index;
+  CONST FDT_INDEX_NODE    *Nodes;
+
+  Index = GetFdtIndex ();
+  if (Index == NULL) {
+    return RETURN_NOT_FOUND;
+  }
+
+  Nodes = FDT_INDEX_ARRAY (Index, NodeArray, CONST FDT_INDEX_NODE);
+  ASSERT (PrevNode >= Nodes && PrevNode < Nodes + Index->NodeCount);
+
+  return FindCompatibleNodeFrom (
+           Index,
+           CompatibleString,
+           (UINT32)(PrevNode - Nodes) + 1,
+           Node
+           );
+}
+
+/**
+  Retrieve a decoded (base, size) pair from the 'reg' property of a node.
+
+  @param[in]   Node     The index entry of the node.
+  @param[in]   Index    The zero based index of the pair.
+  @param[out]  Base     The base address.
+  @param[out]  Size     The size, or 0 if the parent has #size-cells == 0.
+
+  @retval RETURN_SUCCESS          The pair was returned.
+  @retval RETURN_NOT_FOUND        The node has fewer than Index + 1 pairs, or
+                                  its 'reg' property could not be decoded.
+
+**/
+RETURN_STATUS
+EFIAPI
+FdtIndexGetNodeReg (
+  IN  CONST FDT_INDEX_NODE  *Node,
+  IN  UINT32                Index,
+  OUT UINT64                *Base,
+  OUT UINT64                *Size OPTIONAL
+  )
+{
+  CONST FDT_INDEX_HEADER  *FdtIndex;
+  CONST FDT_INDEX_REG     *Reg;
+
+  FdtIndex = GetFdtIndex ();
+  if ((FdtIndex == NULL) || (Index >= Node->RegCount)) {
+    return RETURN_NOT_FOUND;
+  }
+
+  Reg   = FDT_INDEX_ARRAY (FdtIndex, RegArray, CONST FDT_INDEX_REG);
+  Reg  += Node->FirstReg + Index;
+  *Base = Reg->Base;
+  if (Size != NULL) {
+    *Size = Reg->Size;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Retrieve the cells of the 'interrupts' property of a node, converted to CPU
+  byte order.
+
+  @param[in]   Node       The index entry of the node.
+  @param[out]  CellCount  The number of cells.
+
+  @return The cells, or NULL if the node has no 'interrupts' property.
+
+**/
+CONST UINT32 *
+EFIAPI
+FdtIndexGetNodeInterrupts (
+  IN  CONST FDT_INDEX_NODE  *Node,
+  OUT UINT32                *CellCount
+  )
+{
+  CONST FDT_INDEX_HEADER  *Index;
+
+  *CellCount = 0;
+
+  Index = GetFdtIndex ();
+  if ((Index == NULL) || (Node->InterruptCellCount == 0)) {
+    return NULL;
+  }
+
+  *CellCount = Node->InterruptCellCount;
+  return FDT_INDEX_ARRAY (Index, InterruptCellArray, CONST UINT32) +
+         Node->FirstInterruptCell;
+}
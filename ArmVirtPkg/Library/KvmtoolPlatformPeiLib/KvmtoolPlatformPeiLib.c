@@ -14,6 +14,7 @@
 
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DebugLib.h>
+#include <Library/FdtIndexLib.h>
 #include <Library/HobLib.h>
 #include <Library/PcdLib.h>
 #include <Library/PeiServicesLib.h>
@@ -31,12 +32,13 @@ PlatformPeim (
   VOID
   )
 {
-  VOID    *Base;
-  VOID    *NewBase;
-  UINTN   FdtSize;
-  UINTN   FdtPages;
-  UINT64  *FdtHobData;
-  UINT64  *UartHobData;
+  VOID        *Base;
+  VOID        *NewBase;
+  UINTN       FdtSize;
+  UINTN       FdtPages;
+  UINT64      *FdtHobData;
+  UINT64      *UartHobData;
+  EFI_STATUS  Status;
 
   Base = (VOID *)(UINTN)PcdGet64 (PcdDeviceTreeInitialBaseAddress);
   if ((Base == NULL) || (fdt_check_header (Base) != 0)) {
@@ -62,6 +64,16 @@ PlatformPeim (
 
   *FdtHobData = (UINTN)NewBase;
 
+  //
+  // Walk the device tree once, and let all later FDT consumers look up nodes
+  // in the resulting index.
+  //
+  Status = FdtIndexBuild (NewBase);
+  if (RETURN_ERROR (Status)) {
+    ASSERT (0);
+    return Status;
+  }
+
   UartHobData = BuildGuidHob (
                   &gEarly16550UartBaseAddressGuid,
                   sizeof (*UartHobData)
@@ -9,13 +9,17 @@
 
 #include <PiPei.h>
 
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DebugLib.h>
+#include <Library/FdtIndexLib.h>
 #include <Library/HobLib.h>
 #include <Library/PcdLib.h>
 #include <Library/PeiServicesLib.h>
 #include <libfdt.h>
 
+#include <Guid/ArmMpCoreInfo.h>
 #include <Guid/EarlyPL011BaseAddress.h>
 #include <Guid/FdtHob.h>
 
@@ -31,31 +35,237 @@ STATIC CONST EFI_PEI_PPI_DESCRIPTOR  mTpm2InitializationDonePpi = {
   NULL
 };
 
-EFI_STATUS
-EFIAPI
-PlatformPeim (
-  VOID
+//
+// Compatible strings of the /psci node, most recent binding first.
+//
+STATIC CONST CHAR8  *mPsciCompatibles[] = {
+  "arm,psci-1.0",
+  "arm,psci-0.2",
+  "arm,psci",
+};
+
+/**
+  Retrieve the MMIO base address of the TPM, translated through the 'ranges'
+  property of its parent if it does not sit on the root bus.
+
+  @param[in]  DeviceTreeBase    The device tree blob.
+  @param[in]  TpmNode           The index entry of the TPM node.
+
+  @return The TPM base address, or 0 if it could not be determined.
+
+**/
+STATIC
+UINT64
+GetTpmBase (
+  IN  CONST VOID            *DeviceTreeBase,
+  IN  CONST FDT_INDEX_NODE  *TpmNode
   )
 {
-  VOID          *Base;
-  VOID          *NewBase;
-  UINTN         FdtSize;
-  UINTN         FdtPages;
-  UINT64        *FdtHobData;
-  UINT64        *UartHobData;
-  INT32         Node, Prev;
-  INT32         Parent, Depth;
-  CONST CHAR8   *Compatible;
-  CONST CHAR8   *CompItem;
-  CONST CHAR8   *NodeStatus;
   INT32         Len;
   INT32         RangesLen;
-  INT32         StatusLen;
   CONST UINT64  *RegProp;
   CONST UINT32  *RangesProp;
-  UINT64        UartBase;
   UINT64        TpmBase;
-  EFI_STATUS    Status;
+
+  RegProp = fdt_getprop (DeviceTreeBase, TpmNode->NodeOffset, "reg", &Len);
+  ASSERT (Len == 8 || Len == 16);
+  if (Len == 8) {
+    TpmBase = fdt32_to_cpu (RegProp[0]);
+  } else if (Len == 16) {
+    TpmBase = fdt64_to_cpu (ReadUnaligned64 ((UINT64 *)RegProp));
+  } else {
+    return 0;
+  }
+
+  if (TpmNode->ParentOffset != 0) {
+    //
+    // QEMU/mach-virt may put the TPM on the platform bus, in which case
+    // we have to take its 'ranges' property into account to translate the
+    // MMIO address. This consists of a <child base, parent base, size>
+    // tuple, where the child base and the size use the same number of
+    // cells as the 'reg' property above, and the parent base uses 2 cells
+    //
+    RangesProp = fdt_getprop (DeviceTreeBase, TpmNode->ParentOffset, "ranges", &RangesLen);
+    ASSERT (RangesProp != NULL);
+
+    //
+    // a plain 'ranges' attribute without a value implies a 1:1 mapping
+    //
+    if (RangesLen != 0) {
+      //
+      // assume a single translated range with 2 cells for the parent base
+      //
+      if (RangesLen != Len + 2 * sizeof (UINT32)) {
+        DEBUG ((
+          DEBUG_WARN,
+          "%a: 'ranges' property has unexpected size %d\n",
+          __FUNCTION__,
+          RangesLen
+          ));
+        return 0;
+      }
+
+      if (Len == 8) {
+        TpmBase -= fdt32_to_cpu (RangesProp[0]);
+      } else {
+        TpmBase -= fdt64_to_cpu (ReadUnaligned64 ((UINT64 *)RangesProp));
+      }
+
+      //
+      // advance RangesProp to the parent bus address
+      //
+      RangesProp = (UINT32 *)((UINT8 *)RangesProp + Len / 2);
+      TpmBase   += fdt64_to_cpu (ReadUnaligned64 ((UINT64 *)RangesProp));
+    }
+  }
+
+  return TpmBase;
+}
+
+/**
+  Walk the CPU nodes under /cpus, and optionally record their MPIDR values.
+
+  @param[in]   DeviceTreeBase   The device tree blob.
+  @param[in]   CpusNode         The offset of the /cpus node.
+  @param[in]   AddressCells     The #address-cells of the /cpus node.
+  @param[out]  CoreInfo         If not NULL, the CPUs are recorded here. It
+                                must have room for the number of CPUs returned
+                                by a previous call with NULL.
+
+  @return The number of CPUs found.
+
+**/
+STATIC
+UINTN
+EnumerateCpus (
+  IN  CONST VOID     *DeviceTreeBase,
+  IN  INT32          CpusNode,
+  IN  UINT32         AddressCells,
+  OUT ARM_CORE_INFO  *CoreInfo OPTIONAL
+  )
+{
+  INT32         Node;
+  INT32         Len;
+  CONST CHAR8   *Type;
+  CONST UINT32  *Reg;
+  UINTN         Count;
+
+  Count = 0;
+  for (Node = fdt_first_subnode (DeviceTreeBase, CpusNode);
+       Node >= 0;
+       Node = fdt_next_subnode (DeviceTreeBase, Node))
+  {
+    Type = fdt_getprop (DeviceTreeBase, Node, "device_type", &Len);
+    if ((Type == NULL) || (AsciiStrnCmp (Type, "cpu", Len) != 0)) {
+      continue;
+    }
+
+    Reg = fdt_getprop (DeviceTreeBase, Node, "reg", &Len);
+    if ((Reg == NULL) || (Len != (INT32)(AddressCells * sizeof (UINT32)))) {
+      continue;
+    }
+
+    if (CoreInfo != NULL) {
+      ZeroMem (&CoreInfo[Count], sizeof (ARM_CORE_INFO));
+      CoreInfo[Count].Mpidr = fdt32_to_cpu (ReadUnaligned32 (Reg));
+      if (AddressCells == 2) {
+        CoreInfo[Count].Mpidr = LShiftU64 (CoreInfo[Count].Mpidr, 32) |
+                                fdt32_to_cpu (ReadUnaligned32 (Reg + 1));
+      }
+    }
+
+    Count++;
+  }
+
+  return Count;
+}
+
+/**
+  Describe the CPUs found in the device tree in a gArmMpCoreInfoGuid HOB, so
+  that they can be started with PSCI CPU_ON in the DXE phase.
+
+  Nothing is built unless the device tree has a PSCI node. Besides
+  ArmPsciMpServicesDxe, the HOB is consumed by CpuDxe, which then installs an
+  ARM_PROCESSOR_TABLE listing the MPIDR of each CPU, with no mailboxes, as on
+  the other MPCore platforms that describe their CPUs in this HOB.
+
+  @param[in]  DeviceTreeBase    The device tree blob.
+
+**/
+STATIC
+VOID
+BuildMpCoreInfoHob (
+  IN  CONST VOID  *DeviceTreeBase
+  )
+{
+  INT32                 CpusNode;
+  INT32                 Len;
+  CONST UINT32          *Prop;
+  UINT32                AddressCells;
+  UINTN                 Count;
+  ARM_CORE_INFO         *CoreInfo;
+  UINTN                 Index;
+  CONST FDT_INDEX_NODE  *PsciNode;
+
+  for (Index = 0; Index < ARRAY_SIZE (mPsciCompatibles); Index++) {
+    if (!RETURN_ERROR (FdtIndexFindCompatibleNode (mPsciCompatibles[Index], &PsciNode))) {
+      break;
+    }
+  }
+
+  if (Index == ARRAY_SIZE (mPsciCompatibles)) {
+    return;
+  }
+
+  CpusNode = fdt_path_offset (DeviceTreeBase, "/cpus");
+  if (CpusNode < 0) {
+    return;
+  }
+
+  AddressCells = 1;
+  Prop         = fdt_getprop (DeviceTreeBase, CpusNode, "#address-cells", &Len);
+  if ((Prop != NULL) && (Len == sizeof (UINT32))) {
+    AddressCells = fdt32_to_cpu (ReadUnaligned32 (Prop));
+  }
+
+  if ((AddressCells == 0) || (AddressCells > 2)) {
+    DEBUG ((DEBUG_ERROR, "%a: unsupported /cpus #address-cells\n", __FUNCTION__));
+    return;
+  }
+
+  Count = EnumerateCpus (DeviceTreeBase, CpusNode, AddressCells, NULL);
+  if (Count == 0) {
+    return;
+  }
+
+  CoreInfo = BuildGuidHob (&gArmMpCoreInfoGuid, Count * sizeof (ARM_CORE_INFO));
+  ASSERT (CoreInfo != NULL);
+  if (CoreInfo == NULL) {
+    return;
+  }
+
+  EnumerateCpus (DeviceTreeBase, CpusNode, AddressCells, CoreInfo);
+
+  DEBUG ((DEBUG_INFO, "%a: %Lu CPUs\n", __FUNCTION__, (UINT64)Count));
+}
+
+EFI_STATUS
+EFIAPI
+PlatformPeim (
+  VOID
+  )
+{
+  VOID                  *Base;
+  VOID                  *NewBase;
+  UINTN                 FdtSize;
+  UINTN                 FdtPages;
+  UINT64                *FdtHobData;
+  UINT64                *UartHobData;
+  CONST FDT_INDEX_NODE  *IndexNode;
+  CONST CHAR8           *NodeStatus;
+  UINT64                UartBase;
+  UINT64                TpmBase;
+  EFI_STATUS            Status;
 
   Base = (VOID *)(UINTN)PcdGet64 (PcdDeviceTreeInitialBaseAddress);
   ASSERT (Base != NULL);
@@ -71,106 +281,44 @@ PlatformPeim (
   ASSERT (FdtHobData != NULL);
   *FdtHobData = (UINTN)NewBase;
 
+  //
+  // Walk the device tree once, and let this function and all later FDT
+  // consumers look up nodes in the resulting index.
+  //
+  Status = FdtIndexBuild (NewBase);
+  ASSERT_EFI_ERROR (Status);
+
   UartHobData = BuildGuidHob (&gEarlyPL011BaseAddressGuid, sizeof *UartHobData);
   ASSERT (UartHobData != NULL);
   *UartHobData = 0;
 
-  TpmBase = 0;
-
   //
-  // Set Parent to suppress incorrect compiler/analyzer warnings.
+  // The last PL011 node with no 'status' property, or with status "okay", is
+  // used as the console UART.
   //
-  Parent = 0;
-
-  for (Prev = Depth = 0; ; Prev = Node) {
-    Node = fdt_next_node (Base, Prev, &Depth);
-    if (Node < 0) {
-      break;
+  for (Status = FdtIndexFindCompatibleNode ("arm,pl011", &IndexNode);
+       !RETURN_ERROR (Status);
+       Status = FdtIndexFindNextCompatibleNode ("arm,pl011", IndexNode, &IndexNode))
+  {
+    NodeStatus = fdt_getprop (NewBase, IndexNode->NodeOffset, "status", NULL);
+    if ((NodeStatus != NULL) && (AsciiStrCmp (NodeStatus, "okay") != 0)) {
+      continue;
     }
 
-    if (Depth == 1) {
-      Parent = Node;
+    if (!RETURN_ERROR (FdtIndexGetNodeReg (IndexNode, 0, &UartBase, NULL))) {
+      *UartHobData = UartBase;
     }
+  }
 
-    Compatible = fdt_getprop (Base, Node, "compatible", &Len);
+  if (*UartHobData != 0) {
+    DEBUG ((DEBUG_INFO, "%a: PL011 UART @ 0x%lx\n", __FUNCTION__, *UartHobData));
+  }
 
-    //
-    // Iterate over the NULL-separated items in the compatible string
-    //
-    for (CompItem = Compatible; CompItem != NULL && CompItem < Compatible + Len;
-         CompItem += 1 + AsciiStrLen (CompItem))
-    {
-      if (AsciiStrCmp (CompItem, "arm,pl011") == 0) {
-        NodeStatus = fdt_getprop (Base, Node, "status", &StatusLen);
-        if ((NodeStatus != NULL) && (AsciiStrCmp (NodeStatus, "okay") != 0)) {
-          continue;
-        }
-
-        RegProp = fdt_getprop (Base, Node, "reg", &Len);
-        ASSERT (Len == 16);
-
-        UartBase = fdt64_to_cpu (ReadUnaligned64 (RegProp));
-
-        DEBUG ((DEBUG_INFO, "%a: PL011 UART @ 0x%lx\n", __FUNCTION__, UartBase));
-
-        *UartHobData = UartBase;
-        break;
-      } else if (FeaturePcdGet (PcdTpm2SupportEnabled) &&
-                 (AsciiStrCmp (CompItem, "tcg,tpm-tis-mmio") == 0))
-      {
-        RegProp = fdt_getprop (Base, Node, "reg", &Len);
-        ASSERT (Len == 8 || Len == 16);
-        if (Len == 8) {
-          TpmBase = fdt32_to_cpu (RegProp[0]);
-        } else if (Len == 16) {
-          TpmBase = fdt64_to_cpu (ReadUnaligned64 ((UINT64 *)RegProp));
-        }
-
-        if (Depth > 1) {
-          //
-          // QEMU/mach-virt may put the TPM on the platform bus, in which case
-          // we have to take its 'ranges' property into account to translate the
-          // MMIO address. This consists of a <child base, parent base, size>
-          // tuple, where the child base and the size use the same number of
-          // cells as the 'reg' property above, and the parent base uses 2 cells
-          //
-          RangesProp = fdt_getprop (Base, Parent, "ranges", &RangesLen);
-          ASSERT (RangesProp != NULL);
-
-          //
-          // a plain 'ranges' attribute without a value implies a 1:1 mapping
-          //
-          if (RangesLen != 0) {
-            //
-            // assume a single translated range with 2 cells for the parent base
-            //
-            if (RangesLen != Len + 2 * sizeof (UINT32)) {
-              DEBUG ((
-                DEBUG_WARN,
-                "%a: 'ranges' property has unexpected size %d\n",
-                __FUNCTION__,
-                RangesLen
-                ));
-              break;
-            }
-
-            if (Len == 8) {
-              TpmBase -= fdt32_to_cpu (RangesProp[0]);
-            } else {
-              TpmBase -= fdt64_to_cpu (ReadUnaligned64 ((UINT64 *)RangesProp));
-            }
-
-            //
-            // advance RangesProp to the parent bus address
-            //
-            RangesProp = (UINT32 *)((UINT8 *)RangesProp + Len / 2);
-            TpmBase   += fdt64_to_cpu (ReadUnaligned64 ((UINT64 *)RangesProp));
-          }
-        }
-
-        break;
-      }
-    }
+  TpmBase = 0;
+  if (FeaturePcdGet (PcdTpm2SupportEnabled) &&
+      !RETURN_ERROR (FdtIndexFindCompatibleNode ("tcg,tpm-tis-mmio", &IndexNode)))
+  {
+    TpmBase = GetTpmBase (NewBase, IndexNode);
   }
 
   if (FeaturePcdGet (PcdTpm2SupportEnabled)) {
@@ -188,6 +336,8 @@ PlatformPeim (
     ASSERT_EFI_ERROR (Status);
   }
 
+  BuildMpCoreInfoHob (NewBase);
+
   BuildFvHob (PcdGet64 (PcdFvBaseAddress), PcdGet32 (PcdFvSize));
 
   return EFI_SUCCESS;
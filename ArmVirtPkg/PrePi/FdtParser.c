@@ -7,6 +7,22 @@
 #include <Uefi.h>
 #include <Include/libfdt.h>
 
+/**
+  Find the system memory range that UEFI should run from.
+
+  All the enabled nodes with a device_type of "memory" are considered, and
+  every range listed in their 'reg' property, so that guests describing their memory with
+  several (NUMA) nodes are handled. The lowest range is returned; all other
+  ranges are described later by MemoryPeim ().
+
+  @param[in]   DeviceTreeBlob     The device tree blob.
+  @param[out]  SystemMemoryBase   The base of the lowest memory range.
+  @param[out]  SystemMemorySize   The size of the lowest memory range.
+
+  @retval TRUE   A memory range was found.
+  @retval FALSE  The device tree is corrupt or describes no memory.
+
+**/
 BOOLEAN
 FindMemnode (
   IN  VOID    *DeviceTreeBlob,
@@ -19,19 +35,15 @@ FindMemnode (
   INT32        SizeCells;
   INT32        Length;
   CONST INT32  *Prop;
+  CONST CHAR8  *Type;
+  UINT64       Base;
+  UINT64       Size;
+  BOOLEAN      Found;
 
   if (fdt_check_header (DeviceTreeBlob) != 0) {
     return FALSE;
   }
 
-  //
-  // Look for a node called "memory" at the lowest level of the tree
-  //
-  MemoryNode = fdt_path_offset (DeviceTreeBlob, "/memory");
-  if (MemoryNode <= 0) {
-    return FALSE;
-  }
-
   //
   // Retrieve the #address-cells and #size-cells properties
   // from the root node, or use the default if not provided.
@@ -49,29 +61,62 @@ FindMemnode (
     SizeCells = fdt32_to_cpu (*Prop);
   }
 
-  //
-  // Now find the 'reg' property of the /memory node, and read the first
-  // range listed.
-  //
-  Prop = fdt_getprop (DeviceTreeBlob, MemoryNode, "reg", &Length);
+  Found = FALSE;
 
-  if (Length < (AddressCells + SizeCells) * sizeof (INT32)) {
-    return FALSE;
-  }
+  for (MemoryNode = fdt_next_node (DeviceTreeBlob, 0, NULL);
+       MemoryNode >= 0;
+       MemoryNode = fdt_next_node (DeviceTreeBlob, MemoryNode, NULL))
+  {
+    Type = fdt_getprop (DeviceTreeBlob, MemoryNode, "device_type", &Length);
+    if ((Type == NULL) || (Length < 7) || (CompareMem (Type, "memory", 7) != 0)) {
+      continue;
+    }
 
-  *SystemMemoryBase = fdt32_to_cpu (Prop[0]);
-  if (AddressCells > 1) {
-    *SystemMemoryBase = (*SystemMemoryBase << 32) | fdt32_to_cpu (Prop[1]);
-  }
+    //
+    // Skip disabled nodes, as MemoryPeim () does not describe them either.
+    //
+    Prop = fdt_getprop (DeviceTreeBlob, MemoryNode, "status", &Length);
+    if ((Prop != NULL) &&
+        (AsciiStrCmp ((CONST CHAR8 *)Prop, "okay") != 0) &&
+        (AsciiStrCmp ((CONST CHAR8 *)Prop, "ok") != 0))
+    {
+      continue;
+    }
+
+    //
+    // Walk every range listed in the 'reg' property of this node.
+    //
+    Prop = fdt_getprop (DeviceTreeBlob, MemoryNode, "reg", &Length);
+    if (Prop == NULL) {
+      continue;
+    }
+
+    for ( ; Length >= (AddressCells + SizeCells) * (INT32)sizeof (INT32);
+          Length -= (AddressCells + SizeCells) * sizeof (INT32))
+    {
+      Base = fdt32_to_cpu (Prop[0]);
+      if (AddressCells > 1) {
+        Base = (Base << 32) | fdt32_to_cpu (Prop[1]);
+      }
+
+      Prop += AddressCells;
+
+      Size = fdt32_to_cpu (Prop[0]);
+      if (SizeCells > 1) {
+        Size = (Size << 32) | fdt32_to_cpu (Prop[1]);
+      }
 
-  Prop += AddressCells;
+      Prop += SizeCells;
 
-  *SystemMemorySize = fdt32_to_cpu (Prop[0]);
-  if (SizeCells > 1) {
-    *SystemMemorySize = (*SystemMemorySize << 32) | fdt32_to_cpu (Prop[1]);
+      if ((Size != 0) && (!Found || (Base < *SystemMemoryBase))) {
+        *SystemMemoryBase = Base;
+        *SystemMemorySize = Size;
+        Found             = TRUE;
+      }
+    }
   }
 
-  return TRUE;
+  return Found;
 }
 
 VOID